@@ -7,11 +7,13 @@
 #include <stdbool.h>
 #include <math.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <time.h>
 
 #define mapWidth 21
 #define mapHeight 12
 #define TILE_SIZE 60
+#define NO_TILE 0xFF
 #define SCREEN_WIDTH 1260
 #define SCREEN_HEIGHT 720
 #define NUM_RAYS SCREEN_WIDTH
@@ -20,11 +22,139 @@
 #define DIST_TO_PROJ_PLANE ((NUM_RAYS / 2) / tan(DEG_TO_RAD(FOV_ANGLE) / 2))
 #define MINIMAP_SCALE 0.2f
 #define MAX_ENEMIES 24
+#define PALETTE_SIZE 256
+#define FOG_BANDS 32
+#define FOG_DISTANCE (TILE_SIZE * 16)
+#define PVS_WORDS ((mapWidth * mapHeight + 63) / 64)
+#define PVS_EDGE_SAMPLES 5
+#define PVS_MARGIN (0.5f / (PVS_EDGE_SAMPLES - 1))
+#define PVS_EPSILON 1e-4f
+#define PVS_BLOCKERS 8
+#define PVS_MAX_THREADS 32
+#define PVS_INLINE_SOURCES 16
+#define MAX_TILE_LISTENERS 8
+#define TICK_RATE 60
+#define ANGLE_UNITS_PER_DEG (NUM_RAYS / FOV_ANGLE)
+#define ANGLE_UNITS (360 * ANGLE_UNITS_PER_DEG)
+#define FIXED_SHIFT 16
+#define FIXED_ONE ((Sint64)1 << FIXED_SHIFT)
+#define FIXED_FRACTION (FIXED_ONE - 1)
+#define RECORDING_MAGIC "MZRC"
+#define RECORDING_VERSION 2
+#define RECORDING_GENERATED 0x1
+#define PACK_MAGIC "MZPK"
+#define PACK_VERSION 1
+#define PACK_BYTE_ORDER 0x01020304
+#define PACK_NAME_SIZE 48
+#define PACK_ALIGN 64
+#define PACK_COLUMNS 0x1
+#define ASSET_PACK_PATH "../images/assets.pack"
+#define ENEMY_TEXTURE_PATH "../images/Enemy2.png"
+
+/* Per-tick input bits, see handleEvent */
+#define INPUT_FORWARD 0x0001
+#define INPUT_BACK 0x0002
+#define INPUT_LEFT 0x0004
+#define INPUT_RIGHT 0x0008
+#define INPUT_TURN_LEFT 0x0010
+#define INPUT_TURN_RIGHT 0x0020
+#define INPUT_TOGGLE_MAP 0x0040
+#define INPUT_SHOW_MAP 0x0080
+#define INPUT_FIRE 0x0100
+#define INPUT_LAUNCH 0x0200
+#define INPUT_REWIND 0x0400
+#define INPUT_SAVE 0x0800
+#define INPUT_LOAD 0x1000
+#define INPUT_RESTART 0x2000
+#define INPUT_EDIT 0x4000
+#define INPUT_ONESHOT_MASK (INPUT_TOGGLE_MAP | INPUT_SHOW_MAP | INPUT_SAVE | \
+		INPUT_LOAD | INPUT_RESTART | INPUT_EDIT)
+
+/* Marks a snapshot slot published but not yet taken, see SnapshotBuffer */
+#define SNAPSHOT_FRESH 0x4
+
+/* Headless environments, see MazeEnvBatch */
+#define ENV_OBS_WIDTH 32
+#define ENV_OBS_HEIGHT 24
+#define ENV_OBS_SIZE (ENV_OBS_WIDTH * ENV_OBS_HEIGHT)
+#define ENV_MAX_TICKS (TICK_RATE * 60)
+#define ENV_TICK_REWARD (-1.0f / ENV_MAX_TICKS)
+#define ENV_PLAYER_SIZE 20
+#define ENV_SPEED 200
+#define ENV_CHUNK 64
+#define ENV_JOB_RESET 0
+#define ENV_JOB_STEP 1
+
+/* Networked play, see NetServer and NetClient */
+#define NET_PORT 27960
+#define NET_MAX_PLAYERS 64
+#define NET_HISTORY 32
+#define NET_MAX_PACKET 1200
+#define NET_TIMEOUT (TICK_RATE * 5)
+#define NET_PLAYER_SIZE 20
+#define NET_SPEED 200
+#define NET_MAGIC 0x4D5A
+#define NET_VERSION 1
+#define NET_CONNECT 1
+#define NET_WELCOME 2
+#define NET_REFUSED 3
+#define NET_INPUT 4
+#define NET_SNAPSHOT 5
+#define NET_DISCONNECT 6
+
+/* Frames the render thread can be ahead of the encoder, see FrameCapture */
+#define CAPTURE_SLOTS 8
+
+/* Tile lighting, see bake_lighting */
+#define LIGHT_TILE 5
+#define LIGHT_LEVELS 32
+#define LIGHT_FULL (LIGHT_LEVELS - 1)
+#define LIGHT_AMBIENT 10
+#define LIGHT_LAMP LIGHT_FULL
+#define LIGHT_LANTERN 20
+#define LIGHT_FALLOFF 3
+
+/* Weapons, see fire_weapons and ProjectilePool */
+#define MAX_PROJECTILES 4096
+#define HITSCAN_DAMAGE 40
+#define HITSCAN_COOLDOWN (TICK_RATE / 4)
+#define PROJECTILE_DAMAGE 60
+#define PROJECTILE_SPEED 480
+#define PROJECTILE_LIFETIME (TICK_RATE * 3)
+#define LAUNCH_COOLDOWN (TICK_RATE / 8)
+#define MUZZLE_FLASH_TICKS 3
+
+/* Enemy update scheduling, see update_enemies */
+#define LOD_NEAR_TILES 4
+#define LOD_SLEEP_TILES 10
+#define LOD_HEARING_TILES 8
+#define LOD_DISTANT_PERIOD 4
+#define LOD_ALERT_TICKS (3 * TICK_RATE)
+#define LOD_ALERT_PENDING 0xFFFFFFFFu
+
+/* Save states and rewind, see SaveState and RewindBuffer */
+#define SAVE_MAGIC 0x4D5A5356
+#define SAVE_VERSION 3
+#define SAVE_PATH "mazemania.sav"
+#define REWIND_BUDGET (16 << 20)
+#define REWIND_RECORDS 8192
+#define REWIND_KEYFRAME TICK_RATE
+
+/* Memory accounting tags, see mem_alloc */
+enum {MEM_LEVELS, MEM_TEXTURES, MEM_ENEMIES, MEM_RENDER, MEM_SIMULATION,
+	MEM_TAGS};
+#define MEM_MAX_TEXTURES 256
 
-extern float depthBuffer[SCREEN_WIDTH];
 
 extern int worldMap[mapHeight][mapWidth];
 
+extern bool paletteMode;
+extern bool paletteShading;
+extern bool fixedPointMode;
+extern bool gpuBatchMode;
+extern bool lightingMode;
+extern Uint8 paletteFramebuffer[SCREEN_HEIGHT * SCREEN_WIDTH];
+
 extern int worldMap1[mapHeight][mapWidth];
 extern int worldMap2[mapHeight][mapWidth];
 extern int worldMap3[mapHeight][mapWidth];
@@ -36,6 +166,7 @@ extern int worldMap6[mapHeight][mapWidth];
  * struct SDL_Instance - SDL window and renderer structure.
  * @window: Pointer to the SDL_Window structure.
  * @renderer: Pointer to the SDL_Renderer structure.
+ * @surface: Offscreen render target when running headless, NULL otherwise.
  *
  * This structure represents an SDL window and its associated renderer.
  * It contains pointers to the SDL_Window and SDL_Renderer instances
@@ -46,19 +177,21 @@ typedef struct SDL_Instance
 {
 	SDL_Window *window;
 	SDL_Renderer *renderer;
+	SDL_Surface *surface;
 } SDL_Instance;
 
 /**
- * struct SDL_Texture - A structure representing an SDL texture.
+ * struct Texture - A structure representing an SDL texture.
  * @texture: Pointer to an SDL_Texture object.
  * @width: Width of the texture in pixels.
  * @height: Height of the texture in pixels.
  *
  * This structure is used to encapsulate an SDL texture along with its
- * associated dimensions (width and height).
+ * associated dimensions (width and height). Its tag must not be
+ * SDL_Texture, or a bare SDL_Texture pointer would pass for a Texture.
  */
 
-typedef struct SDL_Texture
+typedef struct Texture
 {
 	SDL_Texture *texture;
 	int width;
@@ -72,6 +205,11 @@ typedef struct SDL_Texture
  * @height: The height of the texture in pixels.
  * @pixels: Pointer to the pixel data of the texture, typically used
  * for direct pixel manipulation.
+ * @indices: Palette-quantized copy of @pixels, only allocated when the
+ * palettized renderer is enabled.
+ * @columns: Column-major copy of @pixels from the asset pack, or NULL.
+ * @mapped: @pixels and @columns point into the asset pack and are not
+ * freed.
  *
  * Description: This structure holds all necessary information related
  * to a wall's texture in a rendering context. It includes dimensions of
@@ -86,14 +224,398 @@ typedef struct wallTexture
 	int width;
 	int height;
 	Uint32 *pixels;
+	Uint8 *indices;
+	const Uint32 *columns;
+	bool mapped;
 } wallTexture;
 
+/**
+ * struct PackHeader - Header at the start of an asset pack.
+ * @magic: PACK_MAGIC.
+ * @version: PACK_VERSION.
+ * @byteOrder: PACK_BYTE_ORDER as written by the baker, so a pack baked on
+ * a machine of the other endianness is rejected instead of misread.
+ * @count: Number of PackEntry records following the header.
+ */
+
+typedef struct PackHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint32 byteOrder;
+	Uint32 count;
+} PackHeader;
+
+/**
+ * struct PackEntry - Table of contents record of one packed texture.
+ * @name: File name of the source image, without its directory.
+ * @width: Stored width, a power of two.
+ * @height: Stored height, a power of two.
+ * @sourceWidth: Width of the source image.
+ * @sourceHeight: Height of the source image.
+ * @mipLevels: Number of mip levels, each half the size of the previous.
+ * @flags: PACK_COLUMNS if a column-major copy of level 0 is present.
+ * @offset: File offset of level 0; the other levels follow it directly.
+ * @columnOffset: File offset of the column-major copy, or 0.
+ *
+ * Description: Texels are ARGB8888 words in host byte order, the format
+ * the renderer reads, so the game uses them straight from the mapping.
+ */
+
+typedef struct PackEntry
+{
+	char name[PACK_NAME_SIZE];
+	Uint32 width;
+	Uint32 height;
+	Uint32 sourceWidth;
+	Uint32 sourceHeight;
+	Uint32 mipLevels;
+	Uint32 flags;
+	Uint64 offset;
+	Uint64 columnOffset;
+} PackEntry;
+
+/**
+ * struct GameOptions - Settings parsed from the command line.
+ * @palette: Render through the 8-bit palette and lighting colormaps.
+ * @fixedPoint: Cast rays with the 16.16 fixed-point path.
+ * @gpuBatch: Draw walls and sprites in batches on the GPU.
+ * @lighting: Shade walls, floor and ceiling by the tile light grid.
+ * @recordPath: File to record the session's inputs to, or NULL.
+ * @replayPath: Recording to play back, or NULL.
+ * @timedemo: Play @replayPath back as fast as possible and report timings.
+ * @hasSeed: True if @seed was given on the command line.
+ * @seed: Seed for the game state's random number generator.
+ * @level: Level to start on (1-based).
+ * @goldenDir: Directory of reference frames for --snapshot / --compare.
+ * @goldenCompare: Compare against @goldenDir instead of writing to it.
+ * @tolerance: Per-channel tolerance used by --compare.
+ * @generate: Replace the levels in worlds.txt with generated mazes.
+ * @connectAddress: Server to play on instead of simulating locally, or
+ * NULL.
+ * @capturePath: Y4M file or PNG directory to capture frames to, or NULL.
+ * @memoryPath: File the memory use is written to as JSON at exit, or NULL.
+ * @headless: Render offscreen without a window, for replays.
+ *
+ * Description: Collects the optional features selected at start-up so
+ * that main() can configure the subsystems before the first frame.
+ */
+
+typedef struct GameOptions
+{
+	bool palette;
+	bool fixedPoint;
+	bool gpuBatch;
+	bool lighting;
+	const char *recordPath;
+	const char *replayPath;
+	bool timedemo;
+	bool hasSeed;
+	Uint64 seed;
+	int level;
+	const char *goldenDir;
+	bool goldenCompare;
+	int tolerance;
+	bool generate;
+	const char *connectAddress;
+	const char *capturePath;
+	const char *memoryPath;
+	bool headless;
+} GameOptions;
+
+/**
+ * struct GameState - Simulation state advanced once per tick.
+ * @player: Position and size of the player in world pixels.
+ * @degrees: Player's viewing angle in degrees.
+ * @level: The current level (1-based).
+ * @isMinimap: Whether the mini-map is shown.
+ * @rng: State of the game's random number generator.
+ * @tick: Number of ticks simulated so far.
+ * @nextShot: First tick the weapons can fire again.
+ * @lastShot: Value of @tick once the last shot's tick ended, 0 if none.
+ *
+ * Description: Everything that a replay must reproduce lives here, and it
+ * only changes through updatePlayer, fire_weapons and
+ * checkLevelCompletion, so a seed plus the per-tick inputs fully
+ * determine a session.
+ */
+
+typedef struct GameState
+{
+	SDL_Rect player;
+	double degrees;
+	int level;
+	bool isMinimap;
+	Uint64 rng;
+	Uint32 tick;
+	Uint32 nextShot;
+	Uint32 lastShot;
+} GameState;
+
+/**
+ * struct Recording - An input recording being written or played back.
+ * @file: The open recording file.
+ * @seed: Seed stored in the header.
+ * @level: Starting level stored in the header.
+ * @flags: RECORDING_GENERATED if the levels were generated from @seed.
+ * @ticks: Ticks written so far, or the total when playing back.
+ * @position: Ticks played back so far.
+ * @runInput: Input of the current run.
+ * @runLength: Ticks pending in the current run.
+ */
+
+typedef struct Recording
+{
+	FILE *file;
+	Uint64 seed;
+	int level;
+	Uint16 flags;
+	Uint32 ticks;
+	Uint32 position;
+	Uint16 runInput;
+	Uint16 runLength;
+} Recording;
+
+/**
+ * struct RenderAssets - Textures needed to draw a frame.
+ * @wall: Wall texture.
+ * @floor: Floor texture.
+ * @ceiling: Ceiling texture.
+ * @mini: Player marker drawn on the mini-map.
+ */
+
+typedef struct RenderAssets
+{
+	wallTexture wall;
+	wallTexture floor;
+	wallTexture ceiling;
+	Texture mini;
+} RenderAssets;
+
+/**
+ * struct FixedRayHit - Result of a fixed-point ray cast.
+ * @distance: Distance along the ray in tile units, 16.16.
+ * @fraction: Position of the hit along the wall face, 16.16 fraction.
+ * @verticalRay: Non-zero if the ray hit a vertical grid line.
+ * @tileX: Column of the wall tile hit, NO_TILE if the ray left the map.
+ * @tileY: Row of the wall tile hit, NO_TILE if the ray left the map.
+ * @tile: Tile id hit, 0 if the ray left the map.
+ */
+
+typedef struct FixedRayHit
+{
+	Sint64 distance;
+	Sint64 fraction;
+	int verticalRay;
+	int tileX;
+	int tileY;
+	int tile;
+} FixedRayHit;
+
+/**
+ * struct RayHits - Where the ray of every screen column met a wall, one
+ * array per field so each consumer only streams through what it reads.
+ * @angle: Ray angle in degrees.
+ * @distance: Distance along the ray in world pixels.
+ * @perpDistance: Distance perpendicular to the view plane, without the
+ * fisheye distortion; used for wall heights, fog and sprite occlusion.
+ * @wallHeight: Projected wall height in pixels.
+ * @texX: Hit position along the wall face, 0 to TILE_SIZE - 1.
+ * @tileX: Column of the wall tile hit, NO_TILE for a miss.
+ * @tileY: Row of the wall tile hit, NO_TILE for a miss.
+ * @tile: Tile id hit, 0 if the ray left the map without hitting a wall.
+ * @verticalRay: Non-zero if the ray hit a vertical grid line.
+ */
+
+typedef struct RayHits
+{
+	float angle[NUM_RAYS];
+	float distance[NUM_RAYS];
+	float perpDistance[NUM_RAYS];
+	int wallHeight[NUM_RAYS];
+	Uint8 texX[NUM_RAYS];
+	Uint8 tileX[NUM_RAYS];
+	Uint8 tileY[NUM_RAYS];
+	Uint8 tile[NUM_RAYS];
+	Uint8 verticalRay[NUM_RAYS];
+} RayHits;
+
+extern RayHits rayHits;
+
+/* Draws every wall column of a frame from its hits */
+typedef void (*WallKernel)(SDL_Instance *instance, const RayHits *hits,
+		wallTexture *texture);
+/* Draws one textured wall column in one texture layout and lighting mode */
+typedef void (*WallColumn)(SDL_Renderer *renderer, int rayIndex,
+		int wallHeight, wallTexture *texture, int texX, int light);
+/* Shades the floor or ceiling around the wall spans of a frame's hits */
+typedef void (*PlaneKernel)(SDL_Instance *instance, float playerX,
+		float playerY, float playerAngle, wallTexture *texture,
+		const RayHits *hits);
+
+/**
+ * struct RenderKernels - Frame renderers specialised for one render mode.
+ * @walls: Draws the wall columns.
+ * @ceiling: Shades the ceiling, or NULL to show the sky.
+ * @floor: Shades the floor, or NULL to show plain ground.
+ *
+ * Description: Every combination of renderer, wall style, floor, ceiling
+ * and lighting is expanded into its own kernels at compile time, and
+ * select_render_kernels picks one set per level, so no column or pixel
+ * loop tests a mode flag.
+ */
+
+typedef struct RenderKernels
+{
+	WallKernel walls;
+	PlaneKernel ceiling;
+	PlaneKernel floor;
+} RenderKernels;
+
+extern const RenderKernels *renderKernels;
+
+/* Adjacent rays traced together by cast_views, see CameraView */
+#define RAY_PACKET 8
+
+/**
+ * struct CameraView - One camera of a multi-view cast.
+ * @map: Tile map the camera looks at, worldMap or an environment's own.
+ * @x: Camera x in world pixels.
+ * @y: Camera y in world pixels.
+ * @rotation: View direction in degrees.
+ * @viewport: Region of the framebuffer the view is drawn to; its width is
+ * the number of rays cast, at most NUM_RAYS.
+ * @hits: Receives the hit of every column of the view.
+ */
+
+typedef struct CameraView
+{
+	int (*map)[mapWidth];
+	float x;
+	float y;
+	float rotation;
+	SDL_Rect viewport;
+	RayHits *hits;
+} CameraView;
+
+/**
+ * struct FrameCapture - Frames being recorded by a background encoder.
+ * @path: Y4M file or PNG directory written to.
+ * @width: Frame width.
+ * @height: Frame height.
+ * @pixels: CAPTURE_SLOTS ARGB8888 frames, used as a ring.
+ * @planes: YCbCr conversion buffer, Y4M only; only the encoder uses it.
+ * @file: The Y4M stream, or NULL for a PNG sequence.
+ * @written: Frames put in the ring; only the render thread adds to it.
+ * @encoded: Frames taken from the ring; only the encoder adds to it.
+ * @stopping: Set once no more frames will come.
+ * @ready: Posted once per frame put in the ring, and once to stop.
+ * @thread: The encoder thread.
+ * @dropped: Frames skipped because the ring was full; render thread only.
+ * @encodedFrames: Frames the encoder processed; encoder only.
+ * @failed: Frames among @encodedFrames that could not be written.
+ *
+ * Description: The ring holds @written - @encoded frames, so each side
+ * only ever moves its own counter and neither ever waits for the other.
+ */
+
+typedef struct FrameCapture
+{
+	const char *path;
+	int width;
+	int height;
+	Uint8 *pixels;
+	Uint8 *planes;
+	FILE *file;
+	SDL_atomic_t written;
+	SDL_atomic_t encoded;
+	SDL_atomic_t stopping;
+	SDL_sem *ready;
+	SDL_Thread *thread;
+	Uint32 dropped;
+	Uint32 encodedFrames;
+	Uint32 failed;
+} FrameCapture;
+
+/**
+ * struct MazeParams - Settings for the procedural maze generator.
+ * @seed: Seed of the generator; equal seeds give equal mazes.
+ * @width: Width in tiles, at least 3.
+ * @height: Height in tiles, at least 3.
+ * @spawnPercent: Chance, in percent, of a cell holding an enemy spawn.
+ */
+
+typedef struct MazeParams
+{
+	Uint64 seed;
+	int width;
+	int height;
+	int spawnPercent;
+} MazeParams;
+
+/*
+ * Receives one finished tile row of a generated maze. The row buffer is
+ * only valid during the call.
+ */
+typedef void (*MazeRowCallback)(const int *row, int width, int y,
+		void *context);
+
+/**
+ * struct LevelGrid - A level packed into bitsets for validation.
+ * @width: Width in tiles.
+ * @height: Height in tiles.
+ * @stride: Number of 64-bit words per row.
+ * @open: Tiles the player can walk on, one bit per tile.
+ * @spawns: Enemy spawn tiles.
+ * @exitX: Column of the exit tile, or -1 if there is none.
+ * @exitY: Row of the exit tile, or -1 if there is none.
+ * @exits: Number of exit tiles.
+ */
+
+typedef struct LevelGrid
+{
+	int width;
+	int height;
+	int stride;
+	Uint64 *open;
+	Uint64 *spawns;
+	int exitX;
+	int exitY;
+	int exits;
+} LevelGrid;
+
+/**
+ * struct LevelStats - Result of validating one level.
+ * @startOpen: The start tile can be walked on.
+ * @exitReachable: The exit can be reached from the start.
+ * @pathLength: Steps on the shortest path to the exit, or -1.
+ * @openArea: Number of walkable tiles.
+ * @reachableArea: Number of walkable tiles reachable from the start.
+ * @deadEnds: Reachable tiles with exactly one walkable neighbour.
+ * @spawns: Number of spawn tiles.
+ * @reachableSpawns: Number of spawn tiles reachable from the start.
+ */
+
+typedef struct LevelStats
+{
+	bool startOpen;
+	bool exitReachable;
+	long pathLength;
+	long openArea;
+	long reachableArea;
+	long deadEnds;
+	long spawns;
+	long reachableSpawns;
+} LevelStats;
+
 /**
  * struct LevelManager - Manages the levels and their corresponding
  * maps in the game.
  * @worldMap: Pointer to a dynamically allocated 2D array representing
  * the map of the current level.
  * @current_Level: The index of the currently active level in the game.
+ * @onLoad: Called by loadCurrentLevel with the number of the level just
+ * loaded, or NULL.
  *
  * Description: The LevelManager is responsible for handling and switching
  * between different levels in a game. It stores the maps of levels as 2D
@@ -105,6 +627,7 @@ typedef struct LevelManager
 {
 	int **worldMap;
 	int current_Level;
+	void (*onLoad)(int level);
 } LevelManager;
 
 /**
@@ -115,6 +638,9 @@ typedef struct LevelManager
  * @health: Integer value representing the health points of the enemy.
  * @direction: Floating-point value indicating the movement direction of the
  * enemy in degrees.
+ * @lastThink: Tick the enemy was last updated on.
+ * @alertUntil: Tick until which the enemy updates every tick however far
+ * away it is, or LOD_ALERT_PENDING right after alert_enemy.
  *
  * Description: This structure is used to manage the properties and behavior of
  * enemy entities within the game. It includes their graphical representation,
@@ -130,31 +656,552 @@ typedef struct Enemy
 	float speed;
 	int health;
 	float direction;
+	Uint32 lastThink;
+	Uint32 alertUntil;
 } Enemy;
 
-int init_instance(SDL_Instance *instance);
+/**
+ * struct Projectile - A projectile in flight.
+ * @x: Position x in world pixels.
+ * @y: Position y in world pixels.
+ * @dx: Velocity x in pixels per second.
+ * @dy: Velocity y in pixels per second.
+ * @ttl: Ticks left before it expires.
+ * @next: Next free slot while the slot is on the free list, or -1.
+ */
+
+typedef struct Projectile
+{
+	float x;
+	float y;
+	float dx;
+	float dy;
+	int ttl;
+	int next;
+} Projectile;
+
+/**
+ * struct ProjectilePool - Fixed-capacity storage for projectiles.
+ * @slots: Every projectile, live or free.
+ * @live: Slot of every projectile in flight, packed at the front.
+ * @numLive: Number of entries of @live in use.
+ * @freeHead: First free slot, or -1 when the pool is full.
+ *
+ * Description: Free slots are chained through their next field, so
+ * firing and releasing never allocate, and a tick only walks the
+ * projectiles actually in flight.
+ */
+
+typedef struct ProjectilePool
+{
+	Projectile slots[MAX_PROJECTILES];
+	int live[MAX_PROJECTILES];
+	int numLive;
+	int freeHead;
+} ProjectilePool;
+
+/**
+ * struct MemUsage - Memory held by one subsystem.
+ * @live: Bytes currently allocated, heap blocks and texture pixels.
+ * @peak: Most bytes allocated at once.
+ * @blocks: Heap blocks currently allocated.
+ * @textures: Textures currently created.
+ */
+
+typedef struct MemUsage
+{
+	Sint64 live;
+	Sint64 peak;
+	int blocks;
+	int textures;
+} MemUsage;
+
+/* Update buckets of update_enemies */
+enum {LOD_ACTIVE, LOD_DISTANT, LOD_ASLEEP, LOD_BUCKETS};
+
+/**
+ * struct EnemyLodStats - What update_enemies did over a session.
+ * @ticks: Ticks counted.
+ * @occupancy: Enemy ticks spent in each bucket.
+ * @updates: Enemy updates made.
+ * @maxUpdates: Most updates made in one tick.
+ * @counter: Performance counter ticks spent updating enemies.
+ * @maxCounter: Most performance counter ticks spent in one tick.
+ */
+
+typedef struct EnemyLodStats
+{
+	Uint32 ticks;
+	Uint64 occupancy[LOD_BUCKETS];
+	Uint64 updates;
+	Uint32 maxUpdates;
+	Uint64 counter;
+	Uint64 maxCounter;
+} EnemyLodStats;
+
+/**
+ * struct SavedEnemy - An enemy as stored in a save state.
+ * @rect: Position and size in world pixels.
+ * @speed: Movement speed.
+ * @health: Health points; 0 or less once killed.
+ * @direction: Movement direction in degrees.
+ * @lastThink: Tick the enemy was last updated on.
+ * @alertUntil: Tick until which the enemy stays alert.
+ *
+ * Description: An Enemy without its texture, which belongs to the
+ * renderer and is never saved.
+ */
+
+typedef struct SavedEnemy
+{
+	SDL_Rect rect;
+	float speed;
+	int health;
+	float direction;
+	Uint32 lastThink;
+	Uint32 alertUntil;
+} SavedEnemy;
+
+/**
+ * struct SaveState - The whole simulation state as one flat blob.
+ * @magic: SAVE_MAGIC.
+ * @version: SAVE_VERSION.
+ * @size: sizeof(SaveState), rejecting saves of another build.
+ * @numEnemies: Number of entries of @enemies in use.
+ * @state: Player pose, level, random generator state and weapon timers.
+ * @enemies: The level's enemies.
+ * @map: Contents of the world map.
+ * @explored: Tiles of the level explored so far, see get_explored.
+ * @projectiles: Projectiles in flight.
+ *
+ * Description: Plain data with no pointers, so saving is a copy and a
+ * save written to disk is read back as it is. Unused bytes are zeroed,
+ * which keeps the rewind deltas of unchanged ticks empty.
+ */
+
+typedef struct SaveState
+{
+	Uint32 magic;
+	Uint32 version;
+	Uint32 size;
+	Sint32 numEnemies;
+	GameState state;
+	SavedEnemy enemies[MAX_ENEMIES];
+	int map[mapHeight][mapWidth];
+	Uint64 explored[PVS_WORDS];
+	ProjectilePool projectiles;
+} SaveState;
+
+/**
+ * struct RewindRecord - One tick stored in a RewindBuffer.
+ * @offset: Start of the record in the arena.
+ * @size: Bytes the record takes.
+ * @key: Sequence number of the keyframe the record is a delta against;
+ * its own for a keyframe.
+ */
+
+typedef struct RewindRecord
+{
+	Uint32 offset;
+	Uint32 size;
+	Uint32 key;
+} RewindRecord;
+
+/**
+ * struct RewindBuffer - Ring of per-tick save states in a fixed budget.
+ * @arena: REWIND_BUDGET bytes holding the records, used circularly.
+ * @head: Arena offset the next record is written at.
+ * @records: The records, indexed by sequence number modulo REWIND_RECORDS.
+ * @first: Sequence number of the oldest record.
+ * @next: Sequence number the next record gets.
+ * @keySeq: Sequence number of the newest keyframe.
+ * @hasKey: Whether the ring holds a keyframe new deltas can use.
+ * @key: Copy of the newest keyframe, which deltas are encoded against.
+ * @delta: Scratch space for encoding one delta.
+ *
+ * Description: Every REWIND_KEYFRAME ticks a full SaveState is stored;
+ * the ticks in between only store the words that differ from it. When the
+ * arena is full the oldest keyframe is dropped along with its deltas.
+ */
+
+typedef struct RewindBuffer
+{
+	Uint8 *arena;
+	Uint32 head;
+	RewindRecord records[REWIND_RECORDS];
+	Uint32 first;
+	Uint32 next;
+	Uint32 keySeq;
+	bool hasKey;
+	SaveState *key;
+	Uint32 *delta;
+} RewindBuffer;
+
+/**
+ * struct Snapshot - What the renderer needs from one simulation tick.
+ * @state: Player pose, level id and mini-map flag after the tick.
+ * @enemies: The level's enemies.
+ * @numEnemies: Number of entries of @enemies in use.
+ */
+
+typedef struct Snapshot
+{
+	GameState state;
+	Enemy enemies[MAX_ENEMIES];
+	int numEnemies;
+} Snapshot;
+
+/**
+ * struct SnapshotBuffer - Lock-free triple buffer of snapshots.
+ * @slots: The three snapshots.
+ * @spare: Index of the slot neither side holds, plus SNAPSHOT_FRESH if it
+ * was published after the reader last took one.
+ * @back: Slot the writer fills next; only the writer touches it.
+ * @front: Slot the reader is drawing; only the reader touches it.
+ *
+ * Description: Publishing swaps the filled slot with the spare one and
+ * taking swaps the spare with the front one, each a single atomic
+ * exchange, so neither side ever waits and the reader always gets the
+ * newest complete snapshot.
+ */
+
+typedef struct SnapshotBuffer
+{
+	Snapshot slots[3];
+	SDL_atomic_t spare;
+	int back;
+	int front;
+} SnapshotBuffer;
+
+/**
+ * struct Simulation - Game simulation running on its own thread.
+ * @state: The simulation's state; only the simulation thread touches it,
+ * except during a level change.
+ * @enemies: The current level's enemies.
+ * @projectiles: Projectiles in flight; only the simulation thread touches
+ * them.
+ * @rewind: The last ticks, for INPUT_REWIND.
+ * @startSave: State the session started in, for INPUT_RESTART.
+ * @quicksave: State saved by INPUT_SAVE, for INPUT_LOAD.
+ * @hasQuicksave: Whether @quicksave holds a state.
+ * @scratch: Save state being captured or restored by a tick.
+ * @lod: Enemy update statistics, reported when the session ends.
+ * @levelManager: Every level of the session.
+ * @instance: Renderer used to load the next level's enemies.
+ * @recording: Recording being written or played back, or NULL.
+ * @replaying: Whether inputs come from @recording rather than the keyboard.
+ * @speed: Player speed in pixels per second.
+ * @snapshots: Ticks published for the render thread.
+ * @heldInput: Movement bits currently held, set by the render thread.
+ * @oneshotInput: One-shot bits not yet consumed by a tick.
+ * @running: Cleared by either thread to end the session.
+ * @levelRequest: Set while the simulation waits for a level change.
+ * @levelRestore: Save state the level change restores, or NULL to move on
+ * to the next level.
+ * @editX: Column of the tile the level change edits.
+ * @editY: Row of the tile the level change edits.
+ * @editTile: Id the level change gives that tile, or -1 for no edit.
+ * @levelDone: Posted by the render thread once it made the change.
+ * @levelStatus: checkLevelCompletion's result for the request.
+ * @status: 0 while playing or after a clean end, -1 after an error.
+ * @thread: The simulation thread, or NULL when ticks run in lockstep with
+ * frames.
+ */
+
+typedef struct Simulation
+{
+	GameState state;
+	Enemy enemies[MAX_ENEMIES];
+	ProjectilePool projectiles;
+	RewindBuffer rewind;
+	SaveState *startSave;
+	SaveState *quicksave;
+	bool hasQuicksave;
+	SaveState *scratch;
+	EnemyLodStats lod;
+	LevelManager *levelManager;
+	SDL_Instance *instance;
+	Recording *recording;
+	bool replaying;
+	float speed;
+	SnapshotBuffer snapshots;
+	SDL_atomic_t heldInput;
+	SDL_atomic_t oneshotInput;
+	SDL_atomic_t running;
+	SDL_atomic_t levelRequest;
+	const SaveState *levelRestore;
+	int editX;
+	int editY;
+	int editTile;
+	SDL_sem *levelDone;
+	int levelStatus;
+	int status;
+	SDL_Thread *thread;
+} Simulation;
+
+/**
+ * struct MazeEnv - One headless game instance.
+ * @map: The instance's own level.
+ * @state: Player pose, level id, random state and tick count.
+ * @seed: Seed of the current episode.
+ */
+
+typedef struct MazeEnv
+{
+	int map[mapHeight][mapWidth];
+	GameState state;
+	Uint64 seed;
+} MazeEnv;
+
+/**
+ * struct MazeEnvBatch - Independent game instances stepped together.
+ * @envs: The instances.
+ * @count: Number of instances.
+ * @observations: Low-resolution grey views, ENV_OBS_SIZE bytes per
+ * instance, row after row, instance i at i * ENV_OBS_SIZE.
+ * @rewards: Reward of each instance's last step.
+ * @dones: 1 where the last step ended an episode.
+ * @levels: The built-in levels, or NULL if none were loaded.
+ * @level: Level every episode plays, 0 for mazes generated from the seed.
+ * @seed: Seed of the last reset; instance i starts from @seed + i.
+ * @actions: Per-instance input bits of the step being run.
+ * @job: ENV_JOB_RESET or ENV_JOB_STEP.
+ * @next: Index of the next unclaimed instance.
+ * @threads: Worker threads; the calling thread also works, as worker 0.
+ * @numThreads: Number of workers including the calling thread.
+ * @start: Posted once per worker thread to start a job.
+ * @finished: Posted by each worker thread once no instance is left.
+ * @quit: Tells the worker threads to exit.
+ *
+ * Description: Every instance owns its state, so nothing is shared but the
+ * read-only levels, and nothing needs a window or SDL video.
+ */
+
+typedef struct MazeEnvBatch
+{
+	MazeEnv *envs;
+	int count;
+	Uint8 *observations;
+	float *rewards;
+	Uint8 *dones;
+	int (*levels)[mapHeight][mapWidth];
+	int level;
+	Uint64 seed;
+	const Uint16 *actions;
+	int job;
+	SDL_atomic_t next;
+	SDL_Thread **threads;
+	int numThreads;
+	SDL_sem *start;
+	SDL_sem *finished;
+	bool quit;
+} MazeEnvBatch;
+
+/**
+ * struct BitPacker - Reads or writes a packet one bit field at a time.
+ * @data: Packet bytes.
+ * @capacity: Size of @data in bytes.
+ * @bits: Bits written or read so far.
+ * @overflow: Set once a field did not fit; the packet is then invalid.
+ */
+
+typedef struct BitPacker
+{
+	Uint8 *data;
+	int capacity;
+	int bits;
+	bool overflow;
+} BitPacker;
+
+/**
+ * struct NetPlayer - A player as sent in snapshots.
+ * @active: Whether a client holds this slot.
+ * @x: Position in world pixels.
+ * @y: Position in world pixels.
+ * @angle: View direction, a full turn being 65536.
+ */
+
+typedef struct NetPlayer
+{
+	bool active;
+	Sint16 x;
+	Sint16 y;
+	Uint16 angle;
+} NetPlayer;
+
+/**
+ * struct NetEnemy - An enemy as sent in snapshots.
+ * @x: Position in world pixels.
+ * @y: Position in world pixels.
+ * @health: Remaining health.
+ */
+
+typedef struct NetEnemy
+{
+	Sint16 x;
+	Sint16 y;
+	Uint8 health;
+} NetEnemy;
+
+/**
+ * struct NetWorld - Everything a client is told about one server tick.
+ * @tick: Server tick, never 0; 0 marks an empty history slot.
+ * @level: The level everyone plays (1-based).
+ * @numEnemies: Number of entries of @enemies in use.
+ * @players: Every player slot.
+ * @enemies: The level's enemies.
+ */
+
+typedef struct NetWorld
+{
+	Uint32 tick;
+	Uint8 level;
+	Uint8 numEnemies;
+	NetPlayer players[NET_MAX_PLAYERS];
+	NetEnemy enemies[MAX_ENEMIES];
+} NetWorld;
+
+/**
+ * struct NetPeer - A client as seen by the server.
+ * @connected: Whether the slot is in use.
+ * @host: Client IPv4 address, network byte order.
+ * @port: Client UDP port, network byte order.
+ * @state: The client's player.
+ * @input: Input bits of the client's newest input packet.
+ * @inputTick: Client tick of @input; older packets are ignored.
+ * @ackTick: Newest snapshot the client decoded, 0 if none.
+ * @lastHeard: Server tick of the client's last packet.
+ */
+
+typedef struct NetPeer
+{
+	bool connected;
+	Uint32 host;
+	Uint16 port;
+	GameState state;
+	Uint16 input;
+	Uint32 inputTick;
+	Uint32 ackTick;
+	Uint32 lastHeard;
+} NetPeer;
+
+/**
+ * struct NetServer - Authoritative server of a shared maze.
+ * @socket: Bound UDP socket.
+ * @peers: Player slots.
+ * @history: Recent snapshots by tick modulo NET_HISTORY, the baselines
+ * deltas are encoded against.
+ * @enemies: The level's enemies, without textures.
+ * @numEnemies: Number of entries of @enemies in use.
+ * @projectiles: Projectiles every player launched, in flight.
+ * @levelManager: Every level.
+ * @level: The current level (1-based).
+ * @rng: Random state enemy spawns are drawn from.
+ * @seed: Session seed, sent to clients so they build the same levels.
+ * @generate: The levels are generated from @seed.
+ * @tick: Ticks simulated so far.
+ * @bytesSent: Snapshot bytes sent since the last report.
+ * @snapshotsSent: Snapshots sent since the last report.
+ * @busySeconds: Time spent in server_tick since the last report.
+ */
+
+typedef struct NetServer
+{
+	int socket;
+	NetPeer peers[NET_MAX_PLAYERS];
+	NetWorld history[NET_HISTORY];
+	Enemy enemies[MAX_ENEMIES];
+	int numEnemies;
+	ProjectilePool projectiles;
+	LevelManager levelManager;
+	int level;
+	Uint64 rng;
+	Uint64 seed;
+	bool generate;
+	Uint32 tick;
+	Uint64 bytesSent;
+	Uint64 snapshotsSent;
+	double busySeconds;
+} NetServer;
+
+/**
+ * struct NetClient - Connection of one player to a server.
+ * @socket: UDP socket.
+ * @host: Server IPv4 address, network byte order.
+ * @port: Server UDP port, network byte order.
+ * @id: Player slot the server gave us.
+ * @seed: Session seed from the server.
+ * @generate: The server's levels are generated from @seed.
+ * @history: Decoded snapshots by tick modulo NET_HISTORY.
+ * @latest: Tick of the newest decoded snapshot, 0 if none.
+ * @tick: Input packets sent so far.
+ * @bytesReceived: Snapshot bytes received.
+ * @snapshots: Snapshots decoded.
+ * @deltas: Snapshots among @snapshots that were deltas.
+ * @undecodable: Snapshots dropped because their baseline was unknown or
+ * they were malformed.
+ * @lastHeard: SDL_GetTicks at the last decoded snapshot or the welcome.
+ */
+
+typedef struct NetClient
+{
+	int socket;
+	Uint32 host;
+	Uint16 port;
+	int id;
+	Uint64 seed;
+	bool generate;
+	NetWorld history[NET_HISTORY];
+	Uint32 latest;
+	Uint32 tick;
+	Uint64 bytesReceived;
+	Uint64 snapshots;
+	Uint64 deltas;
+	Uint64 undecodable;
+	Uint32 lastHeard;
+} NetClient;
+
+int init_instance(SDL_Instance *instance, bool vsync);
+int init_headless_instance(SDL_Instance *instance);
+int parse_options(int argc, char *argv[], GameOptions *options);
 void initTexture(Texture *t);
 void freeTexture(Texture *t);
-void renderTopHalf(SDL_Instance *instance);
+void renderTopHalf(SDL_Instance *instance, const RayHits *hits);
 void renderBottomHalf(SDL_Instance *instance);
 int loadTexture(SDL_Renderer *renderer, const char *path, Texture *texture,
 		bool is_miniPlayer);
 void cleanup(SDL_Instance *instance);
 int checkIntersection(const SDL_Rect *A, const SDL_Rect *B);
 void render_world(SDL_Instance *instance, SDL_Rect *rect, bool isMinimap);
-void handleEvent(SDL_Event *event, SDL_Rect *object, Texture *texture,
-		float speed, double *degrees, float deltaTime, bool *isMinimap);
+void renderFrame(SDL_Instance *instance, const GameState *state,
+		const Enemy *enemies, int numEnemies, RenderAssets *assets);
+void handleEvent(SDL_Event *event, Uint16 *input);
+void updatePlayer(GameState *state, Uint16 input, float speed,
+		float deltaTime);
+void move_player(GameState *state, int map[mapHeight][mapWidth],
+		Uint16 input, float speed, float deltaTime);
 int truncateDivisionFloat(float value, float divisor);
-void castRays(SDL_Instance *instance, float playerX, float playerY,
-		float playerRotation, bool isMiniMap, wallTexture *wallTexture,
-		int level);
-void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
-		SDL_Instance *instance, float playerRotation, bool isMiniMap,
-		wallTexture *wallTexture, int ray, int level);
+void castRays(float playerX, float playerY, float playerRotation,
+		RayHits *hits);
+void castSingleRay(float playerX, float playerY, float rayAngle,
+		float playerRotation, RayHits *hits, int ray, Uint64 *explored);
+void init_fixed_tables(void);
+void castRaysFixed(float playerX, float playerY, float playerRotation,
+		RayHits *hits);
+void drawMiniMapRays(SDL_Renderer *renderer, const RayHits *hits,
+		float originX, float originY);
 void drawRay(SDL_Renderer *renderer, float playerX, float playerY,
 		float rayAngle, float rayDistance);
 void drawWallSlice(SDL_Renderer *renderer, int rayIndex, int wallHeight,
-		int horizontalRay, int verticalRay);
+		int horizontalRay, int verticalRay, int light);
+
+/* Specialised frame renderers */
+void select_render_kernels(int level);
+
+/* Multi-view ray casting */
+void cast_views(CameraView *views, int count);
+void shade_views(Uint32 *framebuffer, int pitch, const CameraView *views,
+		int count);
 
 /* Loading Worlds */
 int load_up_world(FILE *file, int worldMap[mapHeight][mapWidth]);
@@ -162,7 +1209,23 @@ int load_worlds_from_file(void);
 void loadCurrentLevel(LevelManager *levelManager);
 void free_LevelManager(LevelManager *levelManager);
 int init_LevelManager(LevelManager *levelManager);
+int checkLevelCompletion(GameState *state, LevelManager *levelManager,
+		Enemy *enemies, SDL_Instance *instance);
 int *getWorldMap(int index);
+int generate_levels(LevelManager *levelManager, Uint64 seed);
+bool atLevelExit(const GameState *state);
+
+/* Procedural mazes */
+int generate_maze(const MazeParams *params, int numBands,
+		MazeRowCallback callback, void *context);
+int write_maze_file(const MazeParams *params, const char *path, int numBands);
+
+/* Level validation */
+int init_level_grid(LevelGrid *grid, int width, int height);
+void free_level_grid(LevelGrid *grid);
+void set_level_tile(LevelGrid *grid, int x, int y, int tile);
+int check_level(const LevelGrid *grid, int startX, int startY,
+		LevelStats *stats);
 
 /* Handling wall texture */
 void init_wallTexture(wallTexture *t);
@@ -170,21 +1233,240 @@ void free_wallTexture(wallTexture *t);
 int load_wallTexture(SDL_Renderer *renderer, const char *path,
 		wallTexture *texture);
 void drawWallTexture(SDL_Renderer *renderer, int rayIndex, int wallHeight,
-		wallTexture *texture, int texX);
+		wallTexture *texture, int texX, int light);
+void drawWallRows(SDL_Renderer *renderer, int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, int light);
+void drawWallRowsLit(SDL_Renderer *renderer, int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, int light);
+void drawWallColumns(SDL_Renderer *renderer, int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, int light);
+void drawWallColumnsLit(SDL_Renderer *renderer, int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, int light);
+int wall_spans(const RayHits *hits, bool isCeiling, int *limits);
+void drawFloorLit(SDL_Instance *instance, float playerX, float playerY,
+		float playerAngle, wallTexture *texture, const RayHits *hits);
+void drawFloorUnlit(SDL_Instance *instance, float playerX, float playerY,
+		float playerAngle, wallTexture *texture, const RayHits *hits);
+void drawCeilingLit(SDL_Instance *instance, float playerX, float playerY,
+		float playerAngle, wallTexture *texture, const RayHits *hits);
+void drawCeilingUnlit(SDL_Instance *instance, float playerX, float playerY,
+		float playerAngle, wallTexture *texture, const RayHits *hits);
 void drawFloor(SDL_Instance *instance, float playerX, float playerY,
-		float playerRotation, wallTexture *floorTexture);
+		float playerRotation, wallTexture *floorTexture,
+		const RayHits *hits);
 void drawCeiling(SDL_Instance *instance, float playerX, float playerY,
-		float playerRotation, wallTexture *ceilingTexture);
+		float playerRotation, wallTexture *ceilingTexture,
+		const RayHits *hits);
 
 /* Handling enemies */
-int init_Enemy(Enemy *enemy, int x, int y, const char *texturePath,
-		SDL_Renderer *renderer);
+void init_Enemy(Enemy *enemy, int x, int y, SDL_Texture *texture);
 void findSpawnPoints(int *spawnPointsX, int *spawnPointsY,
 		int *numSpawnPoints);
-int load_enemies(Enemy *enemies, int level, SDL_Instance *instance);
-void renderEnemies3D(SDL_Instance *instance, Enemy *enemies, int numEnemies,
-		float playerX, float playerY, float playerAngle);
+void free_enemies(Enemy *enemies, int numEnemies);
+int load_enemies(Enemy *enemies, int level, SDL_Instance *instance,
+		Uint64 *rng);
+void renderEnemies3D(SDL_Instance *instance, const Enemy *enemies,
+		int numEnemies, float playerX, float playerY, float playerAngle);
 int load_EnemyTexture(SDL_Renderer *renderer, const char *file,
 		SDL_Texture **texture, bool colorKey);
 
+/* Random numbers, recording and replay */
+void seed_rng(Uint64 *state, Uint64 seed);
+Uint32 next_rng(Uint64 *state);
+int rng_range(Uint64 *state, int bound);
+int start_recording(Recording *recording, const char *path, Uint64 seed,
+		int level, Uint16 flags);
+void record_input(Recording *recording, Uint16 input);
+int stop_recording(Recording *recording);
+int open_replay(Recording *recording, const char *path);
+bool next_replay_input(Recording *recording, Uint16 *input);
+void close_replay(Recording *recording);
+void report_timedemo(double *frameTimes, Uint32 count);
+
+/* Weapons */
+void init_projectiles(ProjectilePool *pool);
+int spawn_projectile(ProjectilePool *pool, float x, float y, double degrees);
+void step_projectiles(ProjectilePool *pool, Enemy *enemies, int numEnemies,
+		float deltaTime);
+int fire_hitscan(const GameState *state, Enemy *enemies, int numEnemies);
+void fire_weapons(GameState *state, ProjectilePool *pool, Enemy *enemies,
+		int numEnemies, Uint16 input);
+
+/* Memory accounting */
+void *mem_alloc(int tag, size_t size);
+void *mem_calloc(int tag, size_t count, size_t size);
+void mem_free(void *block);
+SDL_Texture *mem_texture_from_surface(int tag, SDL_Renderer *renderer,
+		SDL_Surface *surface);
+SDL_Texture *mem_create_texture(int tag, SDL_Renderer *renderer,
+		Uint32 format, int access, int width, int height);
+void mem_destroy_texture(SDL_Texture *texture);
+const char *mem_tag_name(int tag);
+void mem_usage(int tag, MemUsage *out);
+int mem_report_leaks(void);
+int mem_write_json(const char *path);
+void draw_memory_overlay(SDL_Renderer *renderer);
+
+/* Enemy behaviour */
+int enemy_lod(const Enemy *enemy, const GameState *state);
+void alert_enemy(Enemy *enemy);
+void update_enemies(Enemy *enemies, int numEnemies, const GameState *state,
+		EnemyLodStats *stats);
+void update_shared_enemies(Enemy *enemies, int numEnemies,
+		const GameState *players, int numPlayers);
+void report_enemy_lod(const EnemyLodStats *stats);
+
+/* Save states and rewind */
+void capture_save_state(SaveState *save, const GameState *state,
+		const Enemy *enemies, const ProjectilePool *pool);
+int restore_save_state(const SaveState *save, GameState *state,
+		Enemy *enemies, ProjectilePool *pool, LevelManager *levelManager,
+		SDL_Instance *instance);
+int write_save_state(const SaveState *save, const char *path);
+int read_save_state(SaveState *save, const char *path);
+int init_rewind(RewindBuffer *rewind);
+void clear_rewind(RewindBuffer *rewind);
+void rewind_push(RewindBuffer *rewind, const SaveState *save);
+int rewind_step(RewindBuffer *rewind, SaveState *save);
+void free_rewind(RewindBuffer *rewind);
+
+/* Simulation thread and snapshots */
+void init_snapshots(SnapshotBuffer *buffer, const Snapshot *initial);
+Snapshot *snapshot_back(SnapshotBuffer *buffer);
+void publish_snapshot(SnapshotBuffer *buffer);
+const Snapshot *latest_snapshot(SnapshotBuffer *buffer);
+int init_simulation(Simulation *sim);
+int step_simulation(Simulation *sim);
+int start_simulation(Simulation *sim);
+void stop_simulation(Simulation *sim);
+void send_input(Simulation *sim, Uint16 *input);
+void service_level_change(Simulation *sim);
+void free_simulation(Simulation *sim);
+
+/* Headless batch environments */
+int env_batch_init(MazeEnvBatch *batch, int count, int numThreads,
+		const char *levelsPath);
+int env_batch_reset(MazeEnvBatch *batch, Uint64 seed, int level);
+void env_batch_step(MazeEnvBatch *batch, const Uint16 *actions);
+void env_batch_free(MazeEnvBatch *batch);
+
+/* Networked play */
+int net_open_socket(Uint16 port);
+int net_resolve(const char *name, Uint32 *host, Uint16 *port);
+int net_send(int socket, Uint32 host, Uint16 port, const BitPacker *packet);
+int net_receive(int socket, Uint8 *data, int capacity, Uint32 *host,
+		Uint16 *port);
+void init_bits(BitPacker *packer, Uint8 *data, int capacity);
+void write_bits(BitPacker *packer, Uint32 value, int count);
+Uint32 read_bits(BitPacker *packer, int count);
+void write_header(BitPacker *packer, int type);
+int read_header(BitPacker *packer);
+void encode_world(BitPacker *packer, const NetWorld *world,
+		const NetWorld *base);
+int decode_world(BitPacker *packer, NetWorld *world, const NetWorld *base);
+int server_init(NetServer *server, Uint16 port, Uint64 seed, bool generate,
+		int level);
+void server_tick(NetServer *server);
+void server_free(NetServer *server);
+int client_connect(NetClient *client, const char *address);
+int client_poll(NetClient *client);
+void client_send_input(NetClient *client, Uint16 input);
+const NetWorld *client_world(const NetClient *client);
+void client_disconnect(NetClient *client);
+
+/* Frame capture */
+int start_capture(FrameCapture *capture, const char *path, int width,
+		int height);
+void capture_frame(FrameCapture *capture, SDL_Renderer *renderer);
+int stop_capture(FrameCapture *capture);
+void free_capture(FrameCapture *capture);
+
+/* Golden-image frame checks */
+int write_ppm(const char *path, const Uint8 *pixels, int width, int height);
+int read_ppm(const char *path, Uint8 *pixels, int width, int height);
+int compare_frames(const Uint8 *actual, const Uint8 *expected, Uint8 *diff,
+		int count, int tolerance);
+int run_golden(SDL_Instance *instance, LevelManager *levelManager,
+		RenderAssets *assets, const char *directory, bool compare,
+		int tolerance);
+
+/* Tile visibility sets */
+void build_visibility(void);
+void update_visibility_tiles(const int *tiles, int count);
+bool tileVisible(int fromX, int fromY, int toX, int toY);
+bool enemyCanSeePlayer(const Enemy *enemy, float playerX, float playerY);
+
+/*
+ * Repairs a cache derived from the world map after tile edits; @tiles
+ * holds the y * mapWidth + x index of each edited tile.
+ */
+typedef void (*TileListener)(const int *tiles, int count);
+
+/* Explored tiles of the current level */
+void mark_explored(Uint64 *tiles, const int *cells, int count);
+void merge_explored(const Uint64 *tiles);
+void get_explored(Uint64 *tiles);
+void set_explored(const Uint64 *tiles);
+void clear_explored(void);
+int count_explored(void);
+void report_explored(void);
+
+/* Runtime tile edits */
+int setTile(int x, int y, int id);
+int subscribe_tiles(TileListener listener);
+void flush_tiles(void);
+void clear_tile_changes(void);
+
+/* Tile lighting */
+void bake_lighting(void);
+void relight_tiles(const int *tiles, int count);
+void clear_dynamic_lights(void);
+void add_dynamic_light(float x, float y, int level);
+int tile_light(int x, int y);
+int face_light(int tileX, int tileY, int verticalRay, float angle);
+const Uint8 *light_ramp(int level);
+void light_plane_row(float playerX, float playerY, float playerAngle, int p,
+		Uint8 *lights);
+
+/* Palettized rendering */
+int init_palette(SDL_Renderer *renderer);
+void free_palette(void);
+Uint8 quantizeColor(Uint32 color);
+int quantize_wallTexture(wallTexture *t);
+void renderTopHalfPalette(bool sky, bool ground);
+void drawWallSlicePalette(int rayIndex, int wallHeight, float distance,
+		int verticalRay, int light);
+void drawWallTexturePalette(int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, float distance, int verticalRay,
+		int light);
+void drawFloorPaletteLit(SDL_Instance *instance, float playerX,
+		float playerY, float playerAngle, wallTexture *texture,
+		const RayHits *hits);
+void drawFloorPaletteUnlit(SDL_Instance *instance, float playerX,
+		float playerY, float playerAngle, wallTexture *texture,
+		const RayHits *hits);
+void drawCeilingPaletteLit(SDL_Instance *instance, float playerX,
+		float playerY, float playerAngle, wallTexture *texture,
+		const RayHits *hits);
+void drawCeilingPaletteUnlit(SDL_Instance *instance, float playerX,
+		float playerY, float playerAngle, wallTexture *texture,
+		const RayHits *hits);
+void presentPaletteFramebuffer(SDL_Instance *instance);
+
+/* Asset pack */
+int open_asset_pack(const char *path);
+void close_asset_pack(void);
+const PackEntry *find_pack_entry(const char *path);
+const Uint32 *pack_texels(const PackEntry *entry, int level);
+const Uint32 *pack_columns(const PackEntry *entry);
+SDL_Surface *pack_surface(const PackEntry *entry);
+
+/* Batched GPU drawing */
+void batchWallSlice(int rayIndex, int wallHeight, int horizontalRay,
+		int verticalRay, int light);
+void batchWallTexture(SDL_Renderer *renderer, int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, int light);
+void batchSprite(SDL_Texture *texture, const SDL_Rect *rect);
+void flushGpuBatches(SDL_Renderer *renderer);
+
 #endif /* MAZEMANIA_H_ */
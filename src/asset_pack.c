@@ -0,0 +1,202 @@
+#include "../headers/mazemania.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * The pack stays mapped read-only for the whole run; textures loaded from
+ * it point straight into the mapping, so it is only unmapped after every
+ * texture has been freed.
+ */
+static const Uint8 *packData;
+static size_t packSize;
+static const PackHeader *packHeader;
+static const PackEntry *packEntries;
+
+/**
+ * mipChainSize - Computes the size of a packed texture's mip chain.
+ * @entry: The entry.
+ *
+ * Return: Size in bytes of every mip level together.
+ */
+
+static Uint64 mipChainSize(const PackEntry *entry)
+{
+	Uint64 size = 0, width = entry->width, height = entry->height;
+	Uint32 level;
+
+	for (level = 0; level < entry->mipLevels; level++)
+	{
+		size += width * height * sizeof(Uint32);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return (size);
+}
+
+/**
+ * open_asset_pack - Maps an asset pack baked by packbake.
+ * @path: Pack file path.
+ *
+ * A missing pack is not an error: every loader falls back to decoding the
+ * image files. A pack that is present but malformed is reported and
+ * ignored the same way.
+ *
+ * Return: 0 if the pack is mapped, 1 otherwise.
+ */
+
+int open_asset_pack(const char *path)
+{
+	struct stat info;
+	int fd = open(path, O_RDONLY);
+	void *data;
+	Uint32 i;
+
+	if (fd < 0)
+		return (1);
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(PackHeader))
+	{
+		close(fd);
+		return (1);
+	}
+	data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		fprintf(stderr, "Could not map %s\n", path);
+		return (1);
+	}
+
+	packData = data;
+	packSize = info.st_size;
+	packHeader = data;
+	packEntries = (const PackEntry *)(packHeader + 1);
+	if (memcmp(packHeader->magic, PACK_MAGIC, 4) != 0 ||
+			packHeader->version != PACK_VERSION ||
+			packHeader->byteOrder != PACK_BYTE_ORDER ||
+			sizeof(PackHeader) + (size_t)packHeader->count * sizeof(PackEntry) >
+			packSize)
+	{
+		fprintf(stderr, "%s is not a version %d asset pack for this machine\n",
+				path, PACK_VERSION);
+		close_asset_pack();
+		return (1);
+	}
+	for (i = 0; i < packHeader->count; i++)
+	{
+		const PackEntry *entry = &packEntries[i];
+
+		if (entry->mipLevels == 0 || entry->name[PACK_NAME_SIZE - 1] ||
+				entry->offset + mipChainSize(entry) > packSize ||
+				((entry->flags & PACK_COLUMNS) && entry->columnOffset +
+				 (Uint64)entry->width * entry->height * sizeof(Uint32) >
+				 packSize))
+		{
+			fprintf(stderr, "%s: entry %u is truncated\n", path, i);
+			close_asset_pack();
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+/**
+ * close_asset_pack - Unmaps the asset pack, if one is open.
+ */
+
+void close_asset_pack(void)
+{
+	if (packData)
+		munmap((void *)packData, packSize);
+	packData = NULL;
+	packSize = 0;
+	packHeader = NULL;
+	packEntries = NULL;
+}
+
+/**
+ * find_pack_entry - Looks an image up in the asset pack.
+ * @path: Image path as passed to the loaders; only the file name is used.
+ *
+ * Return: The entry, or NULL if no pack is open or it lacks the image.
+ */
+
+const PackEntry *find_pack_entry(const char *path)
+{
+	const char *name = strrchr(path, '/');
+	Uint32 i;
+
+	if (!packHeader)
+		return (NULL);
+
+	name = name ? name + 1 : path;
+	for (i = 0; i < packHeader->count; i++)
+	{
+		if (strcmp(packEntries[i].name, name) == 0)
+			return (&packEntries[i]);
+	}
+	return (NULL);
+}
+
+/**
+ * pack_texels - Returns the texels of one mip level of a packed texture.
+ * @entry: The entry.
+ * @level: Mip level, 0 being the full size.
+ *
+ * Return: Pointer into the mapping, or NULL if the level does not exist.
+ */
+
+const Uint32 *pack_texels(const PackEntry *entry, int level)
+{
+	Uint64 offset = entry->offset;
+	Uint32 width = entry->width, height = entry->height;
+	int i;
+
+	if (level < 0 || (Uint32)level >= entry->mipLevels)
+		return (NULL);
+
+	for (i = 0; i < level; i++)
+	{
+		offset += (Uint64)width * height * sizeof(Uint32);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return ((const Uint32 *)(packData + offset));
+}
+
+/**
+ * pack_columns - Returns the column-major copy of a packed texture.
+ * @entry: The entry.
+ *
+ * Column x of level 0 starts at element x * height, so a wall column is
+ * read from consecutive memory.
+ *
+ * Return: Pointer into the mapping, or NULL if the pack has no copy.
+ */
+
+const Uint32 *pack_columns(const PackEntry *entry)
+{
+	if (!(entry->flags & PACK_COLUMNS))
+		return (NULL);
+	return ((const Uint32 *)(packData + entry->columnOffset));
+}
+
+/**
+ * pack_surface - Wraps level 0 of a packed texture in an SDL_Surface.
+ * @entry: The entry.
+ *
+ * The surface shares the mapped texels, so creating a texture from it
+ * costs no decoding and no intermediate copy. The caller frees the
+ * surface with SDL_FreeSurface, which leaves the texels alone.
+ *
+ * Return: The surface, or NULL on failure.
+ */
+
+SDL_Surface *pack_surface(const PackEntry *entry)
+{
+	return (SDL_CreateRGBSurfaceWithFormatFrom((void *)pack_texels(entry, 0),
+				entry->width, entry->height, 32, entry->width * sizeof(Uint32),
+				SDL_PIXELFORMAT_ARGB8888));
+}
@@ -0,0 +1,691 @@
+#include "../headers/mazemania.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+int worldMap[mapHeight][mapWidth];
+
+#define BENCH_COUNTERS 5
+#define BENCH_TEXTURE_SIZE 64
+#define BENCH_SPLIT_VIEWS 4
+#define BENCH_AGENT_VIEWS 64
+#define BENCH_AGENT_WIDTH 32
+
+/**
+ * struct Counter - A hardware event counted around every benchmark.
+ * @name: JSON key the per-operation count is reported under.
+ * @type: perf_event_attr type.
+ * @config: perf_event_attr config.
+ * @fd: perf event file descriptor, or -1 if the event is unavailable.
+ */
+
+typedef struct Counter
+{
+	const char *name;
+	Uint32 type;
+	Uint64 config;
+	int fd;
+} Counter;
+
+static Counter counters[BENCH_COUNTERS] = {
+	{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1},
+	{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1},
+	{"l1dMisses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+		(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16), -1},
+	{"llcMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1},
+	{"branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1},
+};
+
+/**
+ * struct BenchContext - Synthetic inputs shared by the kernels.
+ * @instance: Software renderer drawing into an offscreen surface.
+ * @texture: Procedural power-of-two texture for walls, floor and ceiling.
+ * @hits: Ray hit buffer for castSingleRay.
+ * @views: Split-screen views, then small agent views, for cast_views.
+ * @viewHits: One hit buffer per entry of @views.
+ * @walls: Rectangles of the map's inner walls.
+ * @numWalls: Number of entries of @walls.
+ * @levelFile: Memory stream holding the map as level text.
+ * @projectiles: Pool kept full of projectiles for step_projectiles.
+ * @enemies: Targets at the map's spawn points.
+ * @numEnemies: Number of entries of @enemies.
+ * @sink: Results are accumulated here so they cannot be optimised away.
+ */
+
+typedef struct BenchContext
+{
+	SDL_Instance instance;
+	wallTexture texture;
+	RayHits *hits;
+	CameraView views[BENCH_SPLIT_VIEWS + BENCH_AGENT_VIEWS];
+	RayHits *viewHits;
+	SDL_Rect walls[mapHeight * mapWidth];
+	int numWalls;
+	FILE *levelFile;
+	ProjectilePool *projectiles;
+	Enemy enemies[MAX_ENEMIES];
+	int numEnemies;
+	volatile long sink;
+} BenchContext;
+
+/**
+ * struct Benchmark - One kernel of the suite.
+ * @name: Name selected on the command line and reported in the JSON.
+ * @run: Runs the kernel @iterations times.
+ * @raysPerOp: Rays cast by one operation, or 0 if the kernel casts none.
+ */
+
+typedef struct Benchmark
+{
+	const char *name;
+	void (*run)(BenchContext *context, long iterations);
+	int raysPerOp;
+} Benchmark;
+
+/**
+ * benchCastSingleRay - One ray per operation, sweeping every column of
+ * a slowly turning view, marking the tiles it explores as castRays does.
+ * @context: Benchmark inputs.
+ * @iterations: Number of rays.
+ */
+
+static void benchCastSingleRay(BenchContext *context, long iterations)
+{
+	float rotation, rayAngle;
+	Uint64 explored[PVS_WORDS] = {0};
+	long i;
+	int ray;
+
+	for (i = 0; i < iterations; i++)
+	{
+		ray = i % NUM_RAYS;
+		rotation = (float)((i / NUM_RAYS * 7) % 360);
+		rayAngle = fmod(rotation - FOV_ANGLE / 2.0f + ray *
+				(FOV_ANGLE / (float)NUM_RAYS) + 360, 360);
+		castSingleRay(90, 90, rayAngle, rotation, context->hits, ray,
+				explored);
+	}
+	context->sink += context->hits->wallHeight[0] + explored[0];
+}
+
+/**
+ * turnViews - Moves and turns a range of views for the next operation.
+ * @views: The views.
+ * @count: Number of views.
+ * @i: Operation index.
+ */
+
+static void turnViews(CameraView *views, int count, long i)
+{
+	int j;
+
+	for (j = 0; j < count; j++)
+		views[j].rotation = (float)((i * 7 + j * 90) % 360);
+}
+
+/**
+ * benchSplitScreen - Four quarter-screen views per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of frames.
+ */
+
+static void benchSplitScreen(BenchContext *context, long iterations)
+{
+	long i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		turnViews(context->views, BENCH_SPLIT_VIEWS, i);
+		cast_views(context->views, BENCH_SPLIT_VIEWS);
+	}
+	context->sink += context->viewHits[0].wallHeight[0];
+}
+
+/**
+ * benchAgentViews - A batch of small agent views per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of batches.
+ */
+
+static void benchAgentViews(BenchContext *context, long iterations)
+{
+	CameraView *views = context->views + BENCH_SPLIT_VIEWS;
+	long i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		turnViews(views, BENCH_AGENT_VIEWS, i);
+		cast_views(views, BENCH_AGENT_VIEWS);
+	}
+	context->sink += views[0].hits->wallHeight[0];
+}
+
+/**
+ * benchWallColumn - One textured wall column per operation, with heights
+ * from a sliver to several times the screen.
+ * @context: Benchmark inputs.
+ * @iterations: Number of columns.
+ */
+
+static void benchWallColumn(BenchContext *context, long iterations)
+{
+	long i;
+
+	for (i = 0; i < iterations; i++)
+		drawWallTexture(context->instance.renderer, i % SCREEN_WIDTH,
+				8 + (i * 37) % (3 * SCREEN_HEIGHT), &context->texture,
+				i % BENCH_TEXTURE_SIZE, LIGHT_FULL);
+}
+
+/**
+ * benchFloor - One full floor pass per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of passes.
+ */
+
+static void benchFloor(BenchContext *context, long iterations)
+{
+	long i;
+
+	for (i = 0; i < iterations; i++)
+		drawFloor(&context->instance, 90, 90, (i * 7) % 360,
+				&context->texture, NULL);
+}
+
+/**
+ * benchCeiling - One full ceiling pass per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of passes.
+ */
+
+static void benchCeiling(BenchContext *context, long iterations)
+{
+	long i;
+
+	for (i = 0; i < iterations; i++)
+		drawCeiling(&context->instance, 90, 90, (i * 7) % 360,
+				&context->texture, NULL);
+}
+
+/**
+ * benchCollision - One player-against-wall test per operation, walking
+ * the player rectangle across the map the way updatePlayer scans it.
+ * @context: Benchmark inputs.
+ * @iterations: Number of tests.
+ */
+
+static void benchCollision(BenchContext *context, long iterations)
+{
+	SDL_Rect player = {0, 0, 12, 12};
+	long i, hits = 0;
+
+	for (i = 0; i < iterations; i++)
+	{
+		player.x = (i * 13) % (mapWidth * TILE_SIZE);
+		player.y = (i * 29) % (mapHeight * TILE_SIZE);
+		hits += checkIntersection(&player,
+				&context->walls[i % context->numWalls]);
+	}
+	context->sink += hits;
+}
+
+/**
+ * benchSpawnPoints - One findSpawnPoints scan of the map per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of scans.
+ */
+
+static void benchSpawnPoints(BenchContext *context, long iterations)
+{
+	int spawnPointsX[mapHeight * mapWidth];
+	int spawnPointsY[mapHeight * mapWidth];
+	int numSpawnPoints = 0;
+	long i;
+
+	for (i = 0; i < iterations; i++)
+		findSpawnPoints(spawnPointsX, spawnPointsY, &numSpawnPoints);
+	context->sink += numSpawnPoints;
+}
+
+/**
+ * benchLevelParse - Parses one level from text per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of levels parsed.
+ */
+
+static void benchLevelParse(BenchContext *context, long iterations)
+{
+	static int level[mapHeight][mapWidth];
+	long i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		rewind(context->levelFile);
+		context->sink += load_up_world(context->levelFile, level);
+	}
+}
+
+/**
+ * benchProjectiles - One tick of a full projectile pool per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of ticks.
+ *
+ * Projectiles released by a tick are launched again from the player's
+ * start before the next one, so every tick moves MAX_PROJECTILES of them.
+ */
+
+static void benchProjectiles(BenchContext *context, long iterations)
+{
+	long i;
+	int j;
+
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = context->projectiles->numLive; j < MAX_PROJECTILES; j++)
+			spawn_projectile(context->projectiles, 90, 90,
+					(i * 7 + j * 13) % 360);
+		for (j = 0; j < context->numEnemies; j++)
+			context->enemies[j].health = 100;
+		step_projectiles(context->projectiles, context->enemies,
+				context->numEnemies, 1.0f / TICK_RATE);
+	}
+	context->sink += context->projectiles->numLive;
+}
+
+/**
+ * benchEnemies - One tick of the enemy scheduler per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of ticks.
+ *
+ * The player stands on the start tile, so the enemies spread over every
+ * update bucket as they would in a level.
+ */
+
+static void benchEnemies(BenchContext *context, long iterations)
+{
+	GameState state;
+	long i;
+	int j;
+
+	memset(&state, 0, sizeof(state));
+	state.player.x = 80;
+	state.player.y = 80;
+	state.player.w = TILE_SIZE / 3;
+	state.player.h = TILE_SIZE / 3;
+	for (j = 0; j < context->numEnemies; j++)
+	{
+		context->enemies[j].health = 100;
+		context->enemies[j].speed = 100;
+	}
+	for (i = 0; i < iterations; i++)
+	{
+		state.tick++;
+		update_enemies(context->enemies, context->numEnemies, &state, NULL);
+	}
+	context->sink += context->enemies[0].rect.x;
+}
+
+/**
+ * benchTileEdit - One door opening or closing per operation.
+ * @context: Benchmark inputs.
+ * @iterations: Number of edits.
+ *
+ * The first inner wall is removed and put back in turn, each edit
+ * flushed on its own, so this is the full cost of one setTile: the
+ * visibility rows and the light around it being repaired.
+ */
+
+static void benchTileEdit(BenchContext *context, long iterations)
+{
+	int x = context->walls[0].x / TILE_SIZE;
+	int y = context->walls[0].y / TILE_SIZE;
+	long i;
+
+	for (i = 0; i < iterations; i++)
+	{
+		setTile(x, y, i % 2 ? 2 : 0);
+		flush_tiles();
+	}
+	setTile(x, y, 2);
+	flush_tiles();
+	context->sink += tile_light(x, y);
+}
+
+static const Benchmark benchmarks[] = {
+	{"castSingleRay", benchCastSingleRay, 1},
+	{"castViewsSplit", benchSplitScreen,
+		BENCH_SPLIT_VIEWS * (SCREEN_WIDTH / 2)},
+	{"castViewsAgents", benchAgentViews,
+		BENCH_AGENT_VIEWS * BENCH_AGENT_WIDTH},
+	{"drawWallTexture", benchWallColumn, 0},
+	{"drawFloor", benchFloor, 0},
+	{"drawCeiling", benchCeiling, 0},
+	{"checkIntersection", benchCollision, 0},
+	{"findSpawnPoints", benchSpawnPoints, 0},
+	{"load_up_world", benchLevelParse, 0},
+	{"step_projectiles", benchProjectiles, 0},
+	{"update_enemies", benchEnemies, 0},
+	{"setTile", benchTileEdit, 0},
+};
+
+/**
+ * copyMapRow - Stores a generated tile row in worldMap.
+ * @row: Tile row.
+ * @width: Number of tiles.
+ * @y: Tile row index.
+ * @context: Unused.
+ */
+
+static void copyMapRow(const int *row, int width, int y, void *context)
+{
+	(void)context;
+	memcpy(worldMap[y], row, width * sizeof(int));
+}
+
+/**
+ * initContext - Builds the synthetic inputs.
+ * @context: Receives the inputs.
+ *
+ * The map is a generated maze like the --generate levels, so ray lengths,
+ * wall counts and spawn points are those of a real level.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int initContext(BenchContext *context)
+{
+	MazeParams params = {1, mapWidth, mapHeight, 70};
+	static char levelText[mapHeight * mapWidth * 4];
+	size_t length = 0;
+	Uint64 rng;
+	int x, y;
+
+	memset(context, 0, sizeof(*context));
+	if (generate_maze(&params, 1, copyMapRow, NULL) != 0)
+		return (1);
+
+	for (y = 0; y < mapHeight; y++)
+	{
+		for (x = 0; x < mapWidth; x++)
+		{
+			length += sprintf(levelText + length, x + 1 < mapWidth ?
+					"%d " : "%d\n", worldMap[y][x]);
+			if (worldMap[y][x] == 2)
+			{
+				context->walls[context->numWalls].x = x * TILE_SIZE;
+				context->walls[context->numWalls].y = y * TILE_SIZE;
+				context->walls[context->numWalls].w = TILE_SIZE;
+				context->walls[context->numWalls].h = TILE_SIZE;
+				context->numWalls++;
+			}
+		}
+	}
+	context->levelFile = fmemopen(levelText, length, "r");
+	build_visibility();
+	bake_lighting();
+
+	context->texture.width = BENCH_TEXTURE_SIZE;
+	context->texture.height = BENCH_TEXTURE_SIZE;
+	context->texture.pixels = malloc(BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE *
+			sizeof(Uint32));
+	context->hits = malloc(sizeof(RayHits));
+	context->projectiles = malloc(sizeof(ProjectilePool));
+	context->viewHits = malloc((BENCH_SPLIT_VIEWS + BENCH_AGENT_VIEWS) *
+			sizeof(RayHits));
+	context->instance.surface = SDL_CreateRGBSurfaceWithFormat(0,
+			SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (context->instance.surface)
+		context->instance.renderer = SDL_CreateSoftwareRenderer(
+				context->instance.surface);
+	if (!context->levelFile || !context->texture.pixels || !context->hits ||
+			!context->viewHits || !context->projectiles ||
+			!context->instance.renderer || context->numWalls == 0)
+	{
+		fprintf(stderr, "Could not build the benchmark inputs: %s\n",
+				SDL_GetError());
+		return (1);
+	}
+
+	seed_rng(&rng, 1);
+	for (x = 0; x < BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE; x++)
+		context->texture.pixels[x] = 0xFF000000 | next_rng(&rng);
+
+	/* Projectile targets on the spawn tiles, placed like load_enemies */
+	init_projectiles(context->projectiles);
+	for (y = 0; y < mapHeight; y++)
+	{
+		for (x = 0; x < mapWidth && context->numEnemies < MAX_ENEMIES; x++)
+		{
+			if (worldMap[y][x] != 4)
+				continue;
+			context->enemies[context->numEnemies].rect.x = x * TILE_SIZE +
+				TILE_SIZE / 3;
+			context->enemies[context->numEnemies].rect.y = y * TILE_SIZE +
+				TILE_SIZE / 3;
+			context->enemies[context->numEnemies].rect.w = TILE_SIZE / 3;
+			context->enemies[context->numEnemies].rect.h = TILE_SIZE / 3;
+			context->numEnemies++;
+		}
+	}
+
+	/* Four players in a 2x2 split, then agents at spread-out positions */
+	for (x = 0; x < BENCH_SPLIT_VIEWS + BENCH_AGENT_VIEWS; x++)
+	{
+		context->views[x].map = worldMap;
+		context->views[x].x = 90 + (x % 4) * 2 * TILE_SIZE;
+		context->views[x].y = 90 + (x / 4 % 2) * 2 * TILE_SIZE;
+		context->views[x].hits = &context->viewHits[x];
+		if (x < BENCH_SPLIT_VIEWS)
+		{
+			context->views[x].viewport.x = x % 2 * (SCREEN_WIDTH / 2);
+			context->views[x].viewport.y = x / 2 * (SCREEN_HEIGHT / 2);
+			context->views[x].viewport.w = SCREEN_WIDTH / 2;
+			context->views[x].viewport.h = SCREEN_HEIGHT / 2;
+		}
+		else
+		{
+			context->views[x].viewport.w = BENCH_AGENT_WIDTH;
+			context->views[x].viewport.h = BENCH_AGENT_WIDTH * 3 / 4;
+		}
+	}
+
+	return (0);
+}
+
+/**
+ * freeContext - Frees the synthetic inputs.
+ * @context: The inputs.
+ */
+
+static void freeContext(BenchContext *context)
+{
+	if (context->instance.renderer)
+		SDL_DestroyRenderer(context->instance.renderer);
+	if (context->instance.surface)
+		SDL_FreeSurface(context->instance.surface);
+	if (context->levelFile)
+		fclose(context->levelFile);
+	free(context->texture.pixels);
+	free(context->hits);
+	free(context->viewHits);
+	free(context->projectiles);
+}
+
+/**
+ * openCounters - Opens every hardware counter the kernel lets us use.
+ *
+ * Counters count this process in user space only. Any that cannot be
+ * opened, because the CPU or a virtual machine lacks the event or
+ * perf_event_paranoid forbids it, are reported as null.
+ *
+ * Return: Number of counters opened.
+ */
+
+static int openCounters(void)
+{
+	struct perf_event_attr attr;
+	int i, opened = 0;
+
+	for (i = 0; i < BENCH_COUNTERS; i++)
+	{
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = counters[i].type;
+		attr.config = counters[i].config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+			PERF_FORMAT_TOTAL_TIME_RUNNING;
+		counters[i].fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		opened += counters[i].fd >= 0;
+	}
+
+	return (opened);
+}
+
+/**
+ * readCounter - Reads a counter, scaled up if the kernel multiplexed it.
+ * @counter: The counter.
+ * @value: Receives the count.
+ *
+ * Return: true if @value is valid.
+ */
+
+static bool readCounter(const Counter *counter, double *value)
+{
+	Uint64 data[3];
+
+	if (counter->fd < 0 || read(counter->fd, data, sizeof(data)) !=
+			sizeof(data) || data[2] == 0)
+		return (false);
+	*value = (double)data[0] * data[1] / data[2];
+	return (true);
+}
+
+/**
+ * runBenchmark - Times one kernel and prints its result as a JSON line.
+ * @benchmark: The kernel.
+ * @context: Benchmark inputs.
+ * @minSeconds: Shortest measured run.
+ *
+ * The iteration count doubles until one run lasts @minSeconds; that run's
+ * time and counters are the ones reported, per operation. Kernels that
+ * cast rays also report their throughput in rays per second.
+ */
+
+static void runBenchmark(const Benchmark *benchmark, BenchContext *context,
+		double minSeconds)
+{
+	Uint64 frequency = SDL_GetPerformanceFrequency(), start;
+	double seconds = 0, value;
+	long iterations = 1;
+	int i;
+
+	/* Warm caches and branch predictors first */
+	benchmark->run(context, 1);
+	while (true)
+	{
+		for (i = 0; i < BENCH_COUNTERS; i++)
+		{
+			if (counters[i].fd >= 0)
+			{
+				ioctl(counters[i].fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(counters[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+		start = SDL_GetPerformanceCounter();
+		benchmark->run(context, iterations);
+		seconds = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+		for (i = 0; i < BENCH_COUNTERS; i++)
+		{
+			if (counters[i].fd >= 0)
+				ioctl(counters[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+		if (seconds >= minSeconds || iterations > LONG_MAX / 2)
+			break;
+		iterations *= 2;
+	}
+
+	printf("{\"benchmark\":\"%s\",\"iterations\":%ld,\"nsPerOp\":%.3f",
+			benchmark->name, iterations, seconds * 1e9 / iterations);
+	if (benchmark->raysPerOp > 0)
+		printf(",\"raysPerSecond\":%.0f",
+				benchmark->raysPerOp * iterations / seconds);
+	for (i = 0; i < BENCH_COUNTERS; i++)
+	{
+		if (readCounter(&counters[i], &value))
+			printf(",\"%s\":%.3f", counters[i].name, value / iterations);
+		else
+			printf(",\"%s\":null", counters[i].name);
+	}
+	printf("}\n");
+	fflush(stdout);
+}
+
+/**
+ * main - Entry point of the kernel microbenchmarks.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: bench [--time MS] [NAME...] runs every kernel, or only the named
+ * ones, on synthetic inputs and prints one JSON object per kernel with
+ * its time and hardware counters per operation, so runs can be diffed.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int main(int argc, char *argv[])
+{
+	BenchContext context;
+	double minSeconds = 0.2;
+	int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+	int i, j, first = 1;
+	bool found;
+
+	if (argc > 2 && strcmp(argv[1], "--time") == 0)
+	{
+		minSeconds = atof(argv[2]) / 1000;
+		first = 3;
+	}
+	for (i = first; i < argc; i++)
+	{
+		for (j = 0, found = false; j < numBenchmarks; j++)
+			found = found || strcmp(argv[i], benchmarks[j].name) == 0;
+		if (!found)
+		{
+			fprintf(stderr, "Usage: %s [--time MS] [NAME...]\n", argv[0]);
+			for (j = 0; j < numBenchmarks; j++)
+				fprintf(stderr, "  %s\n", benchmarks[j].name);
+			return (1);
+		}
+	}
+
+	if (initContext(&context) != 0)
+	{
+		freeContext(&context);
+		return (1);
+	}
+	if (openCounters() == 0)
+		fprintf(stderr, "Hardware counters are unavailable, "
+				"reporting times only\n");
+
+	for (j = 0; j < numBenchmarks; j++)
+	{
+		for (i = first, found = first == argc; i < argc; i++)
+			found = found || strcmp(argv[i], benchmarks[j].name) == 0;
+		if (found)
+			runBenchmark(&benchmarks[j], &context, minSeconds);
+	}
+
+	for (i = 0; i < BENCH_COUNTERS; i++)
+	{
+		if (counters[i].fd >= 0)
+			close(counters[i].fd);
+	}
+	freeContext(&context);
+
+	return (0);
+}
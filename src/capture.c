@@ -0,0 +1,272 @@
+#include "../headers/mazemania.h"
+
+/**
+ * writeY4mFrame - Converts one frame to 4:2:0 YCbCr and writes it.
+ * @capture: The capture; @capture->planes is the conversion buffer.
+ * @pixels: ARGB8888 pixels, tightly packed.
+ *
+ * Full-range BT.601, as announced by the C420jpeg header tag, with each
+ * chroma sample averaged over its 2x2 block.
+ *
+ * Return: 0 on success, 1 on a write error.
+ */
+
+static int writeY4mFrame(FrameCapture *capture, const Uint32 *pixels)
+{
+	int width = capture->width, height = capture->height, x, y, i;
+	Uint8 *luma = capture->planes;
+	Uint8 *cb = luma + width * height;
+	Uint8 *cr = cb + (width / 2) * (height / 2);
+	size_t size = width * height + 2 * (width / 2) * (height / 2);
+	Uint32 color;
+	int r, g, b, sumR, sumG, sumB;
+
+	for (i = 0; i < width * height; i++)
+	{
+		color = pixels[i];
+		luma[i] = (77 * ((color >> 16) & 0xFF) + 150 * ((color >> 8) & 0xFF) +
+				29 * (color & 0xFF) + 128) >> 8;
+	}
+	for (y = 0; y < height / 2; y++)
+	{
+		for (x = 0; x < width / 2; x++)
+		{
+			sumR = sumG = sumB = 0;
+			for (i = 0; i < 4; i++)
+			{
+				color = pixels[(2 * y + i / 2) * width + 2 * x + i % 2];
+				sumR += (color >> 16) & 0xFF;
+				sumG += (color >> 8) & 0xFF;
+				sumB += color & 0xFF;
+			}
+			r = sumR / 4;
+			g = sumG / 4;
+			b = sumB / 4;
+			cb[y * (width / 2) + x] = (-43 * r - 85 * g + 128 * b + 32896) >> 8;
+			cr[y * (width / 2) + x] = (128 * r - 107 * g - 21 * b + 32896) >> 8;
+		}
+	}
+
+	return (fputs("FRAME\n", capture->file) == EOF ||
+			fwrite(capture->planes, 1, size, capture->file) != size);
+}
+
+/**
+ * writePngFrame - Writes one frame as the next image of the sequence.
+ * @capture: The capture.
+ * @pixels: ARGB8888 pixels, tightly packed.
+ * @index: Number of the frame in the sequence.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int writePngFrame(FrameCapture *capture, Uint32 *pixels, Uint32 index)
+{
+	char path[4096];
+	SDL_Surface *surface;
+	int status;
+
+	surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, capture->width,
+			capture->height, 32, capture->width * 4,
+			SDL_PIXELFORMAT_ARGB8888);
+	if (!surface)
+		return (1);
+	snprintf(path, sizeof(path), "%s/frame%06u.png", capture->path, index);
+	status = IMG_SavePNG(surface, path);
+	SDL_FreeSurface(surface);
+
+	return (status != 0);
+}
+
+/**
+ * encoderThread - Encodes captured frames until the capture stops.
+ * @data: The FrameCapture.
+ *
+ * Frames are taken in order from the ring; once the capture is stopping,
+ * the frames already captured are still written before the thread exits.
+ *
+ * Return: Always 0.
+ */
+
+static int encoderThread(void *data)
+{
+	FrameCapture *capture = data;
+	Uint32 *pixels;
+	int slot, failed;
+
+	for (;;)
+	{
+		SDL_SemWait(capture->ready);
+		if (SDL_AtomicGet(&capture->encoded) ==
+				SDL_AtomicGet(&capture->written))
+		{
+			if (SDL_AtomicGet(&capture->stopping))
+				return (0);
+			continue;
+		}
+
+		SDL_MemoryBarrierAcquire();
+		slot = SDL_AtomicGet(&capture->encoded) % CAPTURE_SLOTS;
+		pixels = (Uint32 *)(capture->pixels +
+				(size_t)slot * capture->width * capture->height * 4);
+		if (capture->file)
+			failed = writeY4mFrame(capture, pixels);
+		else
+			failed = writePngFrame(capture, pixels, capture->encodedFrames);
+		capture->encodedFrames++;
+		capture->failed += failed;
+		/* The slot is free for the render thread again */
+		SDL_AtomicIncRef(&capture->encoded);
+	}
+}
+
+/**
+ * start_capture - Starts capturing frames to a file or directory.
+ * @capture: Receives the capture.
+ * @path: A path ending in .y4m for an uncompressed Y4M stream, otherwise
+ * an existing directory that receives a PNG sequence.
+ * @width: Frame width, even for Y4M.
+ * @height: Frame height, even for Y4M.
+ *
+ * Every buffer is allocated, and the ring touched, here, so capturing a
+ * frame never allocates or page-faults.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int start_capture(FrameCapture *capture, const char *path, int width,
+		int height)
+{
+	size_t length = strlen(path);
+
+	memset(capture, 0, sizeof(*capture));
+	capture->path = path;
+	capture->width = width;
+	capture->height = height;
+	capture->pixels = mem_alloc(MEM_RENDER,
+			(size_t)CAPTURE_SLOTS * width * height * 4);
+	capture->ready = SDL_CreateSemaphore(0);
+	if (!capture->pixels || !capture->ready)
+	{
+		fprintf(stderr, "Could not allocate the capture buffers\n");
+		free_capture(capture);
+		return (1);
+	}
+	memset(capture->pixels, 0, (size_t)CAPTURE_SLOTS * width * height * 4);
+
+	if (length > 4 && strcmp(path + length - 4, ".y4m") == 0)
+	{
+		capture->planes = mem_alloc(MEM_RENDER, (size_t)width * height * 3 / 2);
+		capture->file = fopen(path, "wb");
+		if (!capture->planes || !capture->file)
+		{
+			fprintf(stderr, "Could not create %s\n", path);
+			free_capture(capture);
+			return (1);
+		}
+		fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+				width, height, TICK_RATE);
+	}
+
+	capture->thread = SDL_CreateThread(encoderThread, "capture", capture);
+	if (!capture->thread)
+	{
+		fprintf(stderr, "Could not start the capture thread: %s\n",
+				SDL_GetError());
+		free_capture(capture);
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * capture_frame - Queues the frame just drawn for encoding.
+ * @capture: The capture.
+ * @renderer: Renderer holding the finished frame; call before presenting.
+ *
+ * The frame is copied into the next free ring slot. If the encoder still
+ * holds every slot the frame is dropped and counted instead, so the render
+ * loop never waits for it. A frame that cannot be read back is dropped the
+ * same way.
+ */
+
+void capture_frame(FrameCapture *capture, SDL_Renderer *renderer)
+{
+	int written = SDL_AtomicGet(&capture->written);
+	Uint8 *slot;
+
+	if (written - SDL_AtomicGet(&capture->encoded) >= CAPTURE_SLOTS)
+	{
+		capture->dropped++;
+		return;
+	}
+
+	slot = capture->pixels + (size_t)(written % CAPTURE_SLOTS) *
+		capture->width * capture->height * 4;
+	if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, slot,
+				capture->width * 4) != 0)
+	{
+		capture->dropped++;
+		return;
+	}
+
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicIncRef(&capture->written);
+	SDL_SemPost(capture->ready);
+}
+
+/**
+ * stop_capture - Writes the frames still queued and ends the capture.
+ * @capture: The capture.
+ *
+ * Prints how many frames were written and dropped.
+ *
+ * Return: 0 if every captured frame was written, 1 otherwise.
+ */
+
+int stop_capture(FrameCapture *capture)
+{
+	int status;
+
+	if (capture->thread)
+	{
+		SDL_AtomicSet(&capture->stopping, 1);
+		SDL_SemPost(capture->ready);
+		SDL_WaitThread(capture->thread, NULL);
+		capture->thread = NULL;
+	}
+	status = capture->failed != 0;
+	if (capture->file && fclose(capture->file) != 0)
+	{
+		fprintf(stderr, "Could not finish %s\n", capture->path);
+		status = 1;
+	}
+	capture->file = NULL;
+
+	printf("Wrote %u frames to %s, dropped %u, failed %u\n",
+			capture->encodedFrames - capture->failed, capture->path,
+			capture->dropped, capture->failed);
+	free_capture(capture);
+
+	return (status);
+}
+
+/**
+ * free_capture - Releases the buffers of a capture.
+ * @capture: The capture; its thread must have stopped.
+ */
+
+void free_capture(FrameCapture *capture)
+{
+	if (capture->file)
+		fclose(capture->file);
+	capture->file = NULL;
+	if (capture->ready)
+		SDL_DestroySemaphore(capture->ready);
+	capture->ready = NULL;
+	mem_free(capture->pixels);
+	capture->pixels = NULL;
+	mem_free(capture->planes);
+	capture->planes = NULL;
+}
@@ -1,5 +1,14 @@
 #include "../headers/mazemania.h"
 
+/**
+ * rayHits - The hit of every screen column for the frame being drawn.
+ *
+ * castRays fills it once per frame; walls, the mini-map ray fan and sprite
+ * occlusion all read it instead of casting their own rays. Its perpendicular
+ * distances are the depth buffer sprites are tested against.
+ */
+RayHits rayHits;
+
 /**
  * truncateDivisionFloat - Performs a truncated division of a float
  * value by a divisor
@@ -22,32 +31,34 @@ int truncateDivisionFloat(float value, float divisor)
 }
 
 /**
- * castRays - Casts multiple rays from the player's position to simulate vision
- * @instance: Pointer to an SDL_Instance containing rendering and game
- * state information.
+ * castRays - Casts one ray per screen column and records where each one
+ * meets a wall.
  * @playerX: The x-coordinate of the player's position.
  * @playerY: The y-coordinate of the player's position.
  * @playerRotation: The current rotation angle of the player.
- * @isMiniMap: Flag to determine if the casting is for a mini-map.
- * @wallTexture: Pointer to the wall texture structure.
- * @level: The current level of the game.
+ * @hits: Receives the hit of every column.
  *
- * Description: This function casts multiple rays from the player’s
- * current position in various directions based on the player's rotation.
- * It utilizes the game's rendering context and state to determine the
- * visibility and rendering of walls and obstacles within the player’s field
- * of view. The function can be tailored to either the main game view or a
- * mini-map, adjusting the fidelity and scale of raycasting accordingly.
+ * Description: This function only does the intersection maths; it draws
+ * nothing and reads nothing but the world map. Everything that needs to
+ * know what the player sees, the walls, the mini-map ray fan and sprite
+ * occlusion, reads @hits afterwards, so each frame casts its rays once.
+ * The tiles the rays cross are added to the explored set on the way.
+ * When fixedPointMode is set the work is handed to castRaysFixed.
  */
 
-void castRays(SDL_Instance *instance, float playerX, float playerY,
-		float playerRotation, bool isMiniMap, wallTexture *wallTexture,
-		int level)
+void castRays(float playerX, float playerY, float playerRotation,
+		RayHits *hits)
 {
-	float scale = isMiniMap ? MINIMAP_SCALE : 1.0f;
 	float rayAngle;
-	float angleIncrement = FOV_ANGLE / (float)(NUM_RAYS * scale);
-	int ray;
+	float angleIncrement = FOV_ANGLE / (float)NUM_RAYS;
+	Uint64 explored[PVS_WORDS] = {0};
+	int ray, cell;
+
+	if (fixedPointMode)
+	{
+		castRaysFixed(playerX, playerY, playerRotation, hits);
+		return;
+	}
 
 	/* Normalize the player's rotation angle to [0, 360) range */
 	playerRotation = fmod(playerRotation, 360);
@@ -56,7 +67,7 @@ void castRays(SDL_Instance *instance, float playerX, float playerY,
 		playerRotation += 360;
 	}
 
-	for (ray = 0; ray < (NUM_RAYS * scale); ray++)
+	for (ray = 0; ray < NUM_RAYS; ray++)
 	{
 		/* Calculate the angle for this ray, considering player's rotation */
 		rayAngle = playerRotation - (FOV_ANGLE / 2) + ray * angleIncrement;
@@ -69,9 +80,44 @@ void castRays(SDL_Instance *instance, float playerX, float playerY,
 		}
 
 		/* Calculate the distance of the ray */
-		castSingleRay(playerX, playerY, rayAngle, scale, instance,
-				playerRotation, isMiniMap, wallTexture, ray, level);
+		castSingleRay(playerX, playerY, rayAngle, playerRotation, hits, ray,
+				explored);
 	}
+
+	/* The player's own tile, which no ray crosses into */
+	cell = truncateDivisionFloat(playerY, TILE_SIZE) * mapWidth +
+		truncateDivisionFloat(playerX, TILE_SIZE);
+	mark_explored(explored, &cell, 1);
+	merge_explored(explored);
+}
+
+/**
+ * crossingsBefore - Counts the grid crossings of one walk that lie before
+ * the ray's hit.
+ * @first: Distance along the walk's axis from the player to its first
+ * crossing.
+ * @limit: Distance along the same axis from the player to the hit, or
+ * INFINITY if the ray left the map.
+ * @count: Number of crossings the walk made.
+ *
+ * Each walk steps one tile along its axis, so crossing i is first plus i
+ * tiles away on it, and the distance along the ray grows with it. The
+ * walk that did not find the hit went on behind it, and those crossings
+ * were never seen.
+ *
+ * Return: The number of crossings up to and including the hit.
+ */
+
+static int crossingsBefore(float first, float limit, int count)
+{
+	int before;
+
+	if (limit < first)
+		return (0);
+	if (limit == INFINITY)
+		return (count);
+	before = (int)((limit - first) / TILE_SIZE) + 1;
+	return (before < count ? before : count);
 }
 
 /**
@@ -79,35 +125,39 @@ void castRays(SDL_Instance *instance, float playerX, float playerY,
  * @playerX: The x-coordinate of the player's starting position.
  * @playerY: The y-coordinate of the player's starting position.
  * @rayAngle: The angle at which the ray is cast, relative to the player.
- * @scale: The scale factor for the ray, differentiating between main
- * view and mini-map.
- * @instance: Pointer to the SDL_Instance for rendering and state management.
  * @playerRotation: The player's current rotation for correcting perspective.
- * @isMiniMap: Flag to indicate mini-map calculation.
- * @wallTexture: Pointer to the texture of the wall.
+ * @hits: Receives the hit in column @ray.
  * @ray: The index of the current ray in the raycasting sequence.
- * @level: The current level of the game.
+ * @explored: Tile set receiving every tile the ray enters, the wall it
+ * hits included, or NULL for a ray that explores nothing, such as a shot.
  *
  * Description: Function performs the calculation of a single ray’s travel
  * distance until it hits an obstacle. The calculation accounts for both
  * vertical and horizontal distances, adjusting for perspective errors caused
- * by the angle of incidence and player rotation. It supports both main and
- * mini-map functionalities by adjusting the scale of measurements.
+ * by the angle of incidence and player rotation. A ray that leaves the map
+ * without meeting a wall is recorded with tile 0 and NO_TILE as its tile
+ * coordinates. The tiles for @explored are the ones the two grid walks
+ * already test, kept as they go.
  */
 
-void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
-		SDL_Instance *instance, float playerRotation, bool isMiniMap,
-		wallTexture *wallTexture, int ray, int level)
+void castSingleRay(float playerX, float playerY, float rayAngle,
+		float playerRotation, RayHits *hits, int ray, Uint64 *explored)
 {
 	/* Convert angle to radians for trigonometric functions */
 	float rayAngleRad = DEG_TO_RAD(rayAngle);
-	float TILE_SIZED = TILE_SIZE * scale;
+	float TILE_SIZED = TILE_SIZE;
 
 	/* Define variables to track intersection points */
-	float horizontalHitX, horizontalHitY, verticalHitX, verticalHitY;
+	float horizontalHitX = 0, horizontalHitY = 0;
+	float verticalHitX = 0, verticalHitY = 0;
 	float horizontalDistance = INFINITY, verticalDistance = INFINITY;
 	int foundHorizontalWallHit = 0, foundVerticalWallHit = 0;
-	int gridX, gridY, wallHeight;
+	int gridX, gridY, horizontalGridX = 0, horizontalGridY = 0;
+	int verticalGridX = 0, verticalGridY = 0;
+	/* Tiles entered at each horizontal and vertical grid line crossed */
+	int horizontalCells[mapHeight + 1], verticalCells[mapWidth + 1];
+	int numHorizontal = 0, numVertical = 0;
+	float firstHorizontal, firstVertical;
 
 	int isRayFacingDown = (rayAngle > 0 && rayAngle < 180);
 	int isRayFacingUp = !isRayFacingDown;
@@ -139,6 +189,7 @@ void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
 		ystep = -TILE_SIZED;
 		xstep = -TILE_SIZED / tan(rayAngleRad);
 	}
+	firstHorizontal = fabsf(nextHorizontalTouchY - playerY);
 
 	while (nextHorizontalTouchX >= 0 &&
 			nextHorizontalTouchX < mapWidth * TILE_SIZED &&
@@ -148,11 +199,15 @@ void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
 		gridX = truncateDivisionFloat(nextHorizontalTouchX, TILE_SIZED);
 		gridY = truncateDivisionFloat(nextHorizontalTouchY +
 				(isRayFacingUp ? -1 : 0), TILE_SIZED);
+		horizontalCells[numHorizontal++] = gridY >= 0 ?
+			gridY * mapWidth + gridX : -1;
 
 		if (gridX >= 0 && gridX < mapWidth && gridY >= 0 &&
 				gridY < mapHeight && (worldMap[gridY][gridX] == 1 ||
 					worldMap[gridY][gridX] == 2))
 		{
+			horizontalGridX = gridX;
+			horizontalGridY = gridY;
 			horizontalHitX = nextHorizontalTouchX;
 			horizontalHitY = nextHorizontalTouchY;
 			horizontalDistance = hypot(horizontalHitX - playerX,
@@ -189,6 +244,7 @@ void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
 		xstep = -TILE_SIZED;
 		ystep = -TILE_SIZED * tan(rayAngleRad);
 	}
+	firstVertical = fabsf(nextVerticalTouchX - playerX);
 
 	while (nextVerticalTouchX >= 0 &&
 			nextVerticalTouchX < mapWidth * TILE_SIZED &&
@@ -198,11 +254,15 @@ void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
 		gridX = truncateDivisionFloat(nextVerticalTouchX +
 				(isRayFacingLeft ? -1 : 0), TILE_SIZED);
 		gridY = truncateDivisionFloat(nextVerticalTouchY, TILE_SIZED);
+		verticalCells[numVertical++] = gridX >= 0 ?
+			gridY * mapWidth + gridX : -1;
 
 		if (gridX >= 0 && gridX < mapWidth && gridY >= 0 &&
 				gridY < mapHeight && (worldMap[gridY][gridX] == 1 ||
 					worldMap[gridY][gridX] == 2))
 		{
+			verticalGridX = gridX;
+			verticalGridY = gridY;
 			verticalHitX = nextVerticalTouchX;
 			verticalHitY = nextVerticalTouchY;
 			verticalDistance = hypot(verticalHitX - playerX,
@@ -219,68 +279,64 @@ void castSingleRay(float playerX, float playerY, float rayAngle, float scale,
 
 	/* Determine the shortest distance */
 	float rayDistance, correctedDistance;
-	int verticalRay = 0, horizontalRay = 0;
+	int verticalRay;
 
-	if (foundHorizontalWallHit && foundVerticalWallHit)
+	verticalRay = !foundHorizontalWallHit || (foundVerticalWallHit &&
+			horizontalDistance >= verticalDistance);
+	if (explored)
 	{
-		if (horizontalDistance < verticalDistance)
-		{
-			rayDistance = horizontalDistance;
-			horizontalRay = 1;
-		}
-		else
+		float hitX = INFINITY, hitY = INFINITY;
+
+		if (foundHorizontalWallHit || foundVerticalWallHit)
 		{
-			rayDistance = verticalDistance;
-			verticalRay = 1;
+			hitX = fabsf((verticalRay ? verticalHitX : horizontalHitX) -
+					playerX);
+			hitY = fabsf((verticalRay ? verticalHitY : horizontalHitY) -
+					playerY);
 		}
+		mark_explored(explored, horizontalCells,
+				crossingsBefore(firstHorizontal, hitY, numHorizontal));
+		mark_explored(explored, verticalCells,
+				crossingsBefore(firstVertical, hitX, numVertical));
 	}
-	else if (foundHorizontalWallHit)
-	{
-		rayDistance = horizontalDistance;
-		horizontalRay = 1;
-	}
-	else if (foundVerticalWallHit)
+
+	if (!foundHorizontalWallHit && !foundVerticalWallHit)
 	{
-		rayDistance = verticalDistance;
-		verticalRay = 1;
+		hits->angle[ray] = rayAngle;
+		hits->distance[ray] = INFINITY;
+		hits->perpDistance[ray] = INFINITY;
+		hits->wallHeight[ray] = 0;
+		hits->texX[ray] = 0;
+		hits->tileX[ray] = NO_TILE;
+		hits->tileY[ray] = NO_TILE;
+		hits->tile[ray] = 0;
+		hits->verticalRay[ray] = 0;
+		return;
 	}
 
-	if (isMiniMap)
+	rayDistance = verticalRay ? verticalDistance : horizontalDistance;
+
+	/* Calculate the projected wall height */
+	correctedDistance = rayDistance * cos(DEG_TO_RAD
+			(rayAngle - playerRotation));
+
+	hits->angle[ray] = rayAngle;
+	hits->distance[ray] = rayDistance;
+	hits->perpDistance[ray] = correctedDistance;
+	hits->wallHeight[ray] = (int)((TILE_SIZE / correctedDistance) *
+			DIST_TO_PROJ_PLANE);
+	hits->verticalRay[ray] = verticalRay;
+	if (verticalRay)
 	{
-		drawRay(instance->renderer, playerX, playerY, rayAngle, rayDistance);
+		hits->texX[ray] = (int)verticalHitY % TILE_SIZE;
+		hits->tileX[ray] = verticalGridX;
+		hits->tileY[ray] = verticalGridY;
 	}
 	else
 	{
-		/* Calculate the projected wall height */
-		correctedDistance = rayDistance * cos(DEG_TO_RAD
-				(rayAngle - playerRotation));
-		wallHeight = (int)((TILE_SIZE / correctedDistance) *
-				DIST_TO_PROJ_PLANE);
-
-		/* Store the corrected perpendicular distance for the current ray */
-		depthBuffer[ray] = correctedDistance;
-
-		/* Calculate texture X coordinate */
-		int texX;
-
-		if (verticalRay)
-			texX = ((int)verticalHitY % TILE_SIZE);
-		else
-			texX = ((int)horizontalHitX % TILE_SIZE);
-
-		/* Scale texX to the texture width */
-		texX = (texX * wallTexture->width) / TILE_SIZE;
-
-		if (level == 1)
-		{
-			drawWallSlice(instance->renderer, ray, wallHeight,
-					verticalRay, horizontalRay);
-		}
-		else
-		{
-			drawWallTexture(instance->renderer, ray,
-					wallHeight, wallTexture, texX);
-		}
-
+		hits->texX[ray] = (int)horizontalHitX % TILE_SIZE;
+		hits->tileX[ray] = horizontalGridX;
+		hits->tileY[ray] = horizontalGridY;
 	}
+	hits->tile[ray] = worldMap[hits->tileY[ray]][hits->tileX[ray]];
 }
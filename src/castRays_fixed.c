@@ -0,0 +1,405 @@
+#include "../headers/mazemania.h"
+
+/**
+ * fixedPointMode - True when rays are cast by castRaysFixed.
+ */
+bool fixedPointMode;
+
+/*
+ * Angles are integer units of 1/ANGLE_UNITS_PER_DEG degree, which makes the
+ * main view exactly one unit per ray. All tables are 16.16 fixed point and
+ * are built with integer arithmetic only, see cordicSinCos, so the cast
+ * gives the same result on every compiler, CPU and libm.
+ */
+static Sint64 cotTable[ANGLE_UNITS];
+static Sint64 tanTable[ANGLE_UNITS];
+static Sint64 invSinTable[ANGLE_UNITS];
+static Sint64 invCosTable[ANGLE_UNITS];
+static Sint64 cosTable[ANGLE_UNITS];
+static Sint64 projPlaneFixed;
+
+/*
+ * The table builder works in 2.61 fixed point. Pi and the CORDIC gain,
+ * 1 / prod(sqrt(1 + 2^-2i)) over the CORDIC_STEPS steps, are the only
+ * constants it needs.
+ */
+#define CORDIC_SHIFT 61
+#define CORDIC_ONE ((Sint64)1 << CORDIC_SHIFT)
+#define CORDIC_STEPS 61
+#define CORDIC_PI ((Sint64)7244019458077122842)
+#define CORDIC_GAIN ((Sint64)1400229935014726477)
+
+/* atan(2^-i) in radians, 2.61 fixed point */
+static Sint64 cordicAngles[CORDIC_STEPS];
+
+/**
+ * initCordicAngles - Fills cordicAngles from the arctangent series.
+ *
+ * atan(2^-i) = 2^-i - 2^-3i / 3 + 2^-5i / 5 - ..., where every power is a
+ * shift; atan(1) is pi / 4.
+ */
+
+static void initCordicAngles(void)
+{
+	Sint64 sum, term;
+	int i, k;
+
+	cordicAngles[0] = CORDIC_PI / 4;
+	for (i = 1; i < CORDIC_STEPS; i++)
+	{
+		sum = 0;
+		for (k = 0; i * (2 * k + 1) < CORDIC_SHIFT; k++)
+		{
+			term = (CORDIC_ONE >> (i * (2 * k + 1))) / (2 * k + 1);
+			sum += k % 2 ? -term : term;
+		}
+		cordicAngles[i] = sum;
+	}
+}
+
+/**
+ * cordicSinCos - Sine and cosine of a first-quadrant angle by CORDIC.
+ * @angle: The angle in radians, 2.61 fixed point, in [0, pi / 2].
+ * @sine: Receives the sine, 2.61 fixed point.
+ * @cosine: Receives the cosine, 2.61 fixed point.
+ *
+ * Rotates the unit vector, pre-scaled by the gain, towards @angle by
+ * +-atan(2^-i) in turn; each step is two shifts and adds.
+ */
+
+static void cordicSinCos(Sint64 angle, Sint64 *sine, Sint64 *cosine)
+{
+	Sint64 x = CORDIC_GAIN, y = 0, next;
+	int i;
+
+	for (i = 0; i < CORDIC_STEPS; i++)
+	{
+		if (angle >= 0)
+		{
+			next = x - (y >> i);
+			y += x >> i;
+			angle -= cordicAngles[i];
+		}
+		else
+		{
+			next = x + (y >> i);
+			y -= x >> i;
+			angle += cordicAngles[i];
+		}
+		x = next;
+	}
+	*sine = y;
+	*cosine = x;
+}
+
+/**
+ * unitSinCos - Sine and cosine of an angle in angle units.
+ * @a: The angle, in [0, ANGLE_UNITS).
+ * @sine: Receives the sine, 2.61 fixed point.
+ * @cosine: Receives the cosine, 2.61 fixed point.
+ *
+ * The angle is folded into the first quadrant; the axes are exact.
+ */
+
+static void unitSinCos(int a, Sint64 *sine, Sint64 *cosine)
+{
+	const Sint64 quarter = ANGLE_UNITS / 4, halfPi = CORDIC_PI / 2;
+	Sint64 r = a % quarter, s = 0, c = CORDIC_ONE;
+
+	if (r != 0)
+		cordicSinCos(halfPi / quarter * r + halfPi % quarter * r / quarter,
+				&s, &c);
+	switch (a / quarter)
+	{
+		case 0:
+			*sine = s;
+			*cosine = c;
+			break;
+		case 1:
+			*sine = c;
+			*cosine = -s;
+			break;
+		case 2:
+			*sine = -s;
+			*cosine = -c;
+			break;
+		default:
+			*sine = -c;
+			*cosine = s;
+	}
+}
+
+/**
+ * fixedRatio - Rounds scale * num / den to 16.16, clamped so products stay
+ * in 64 bits.
+ * @num: Numerator, 2.61 fixed point.
+ * @den: Denominator, 2.61 fixed point; 0 gives the positive limit.
+ * @scale: Integer factor of the numerator, below 2^13.
+ *
+ * Return: The fixed-point value.
+ */
+
+static Sint64 fixedRatio(Sint64 num, Sint64 den, int scale)
+{
+	const Sint64 limit = (Sint64)1 << (30 + FIXED_SHIFT);
+	bool negative = (num < 0) != (den < 0);
+	Sint64 quotient, remainder;
+
+	/* 24.40 leaves room for the scale and the 16-bit shift below */
+	num = (num < 0 ? -num : num) >> (CORDIC_SHIFT - 40);
+	den = (den < 0 ? -den : den) >> (CORDIC_SHIFT - 40);
+	if (den == 0)
+		return (limit);
+	num *= scale;
+	quotient = num / den;
+	remainder = num % den;
+	if (quotient >= (Sint64)1 << 30)
+		return (negative ? -limit : limit);
+	quotient = (quotient << FIXED_SHIFT) +
+		((remainder << FIXED_SHIFT) + den / 2) / den;
+	return (negative ? -quotient : quotient);
+}
+
+/**
+ * init_fixed_tables - Builds the trigonometry and reciprocal tables used by
+ * the fixed-point cast.
+ */
+
+void init_fixed_tables(void)
+{
+	Sint64 s, c;
+	int a;
+
+	initCordicAngles();
+	for (a = 0; a < ANGLE_UNITS; a++)
+	{
+		unitSinCos(a, &s, &c);
+		cotTable[a] = fixedRatio(c, s, 1);
+		tanTable[a] = fixedRatio(s, c, 1);
+		invSinTable[a] = fixedRatio(CORDIC_ONE, s < 0 ? -s : s, 1);
+		invCosTable[a] = fixedRatio(CORDIC_ONE, c < 0 ? -c : c, 1);
+		cosTable[a] = fixedRatio(c, CORDIC_ONE, 1);
+	}
+	/* (NUM_RAYS / 2) / tan(FOV_ANGLE / 2), as DIST_TO_PROJ_PLANE */
+	unitSinCos(FOV_ANGLE * ANGLE_UNITS_PER_DEG / 2, &s, &c);
+	projPlaneFixed = fixedRatio(c, s, NUM_RAYS / 2);
+}
+
+/**
+ * isWallCell - Tests a map cell for a wall, treating the outside as open.
+ * @x: Cell column.
+ * @y: Cell row.
+ *
+ * Return: true for border and inner walls.
+ */
+
+static bool isWallCell(Sint64 x, Sint64 y)
+{
+	if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+		return (false);
+	return (worldMap[y][x] == 1 || worldMap[y][x] == 2);
+}
+
+/**
+ * crossingsBefore - Counts the grid crossings of one walk that lie before
+ * the ray's hit.
+ * @first: Distance along the walk's axis from the player to its first
+ * crossing, 16.16 tile units.
+ * @limit: Distance along the same axis from the player to the hit, or
+ * INT64_MAX if the ray left the map.
+ * @count: Number of crossings the walk made.
+ *
+ * Return: The number of crossings up to and including the hit; see the
+ * floating-point caster's counterpart.
+ */
+
+static int crossingsBefore(Sint64 first, Sint64 limit, int count)
+{
+	Sint64 before;
+
+	if (limit < first)
+		return (0);
+	before = (limit - first) / FIXED_ONE + 1;
+	return (before < count ? (int)before : count);
+}
+
+/**
+ * castSingleRayFixed - Casts one ray in 16.16 fixed point.
+ * @posX: Player x in tile units, 16.16.
+ * @posY: Player y in tile units, 16.16.
+ * @angle: Ray angle in angle units, in [0, ANGLE_UNITS).
+ * @hit: Receives the hit distance, side, tile and texture coordinate.
+ * @explored: Tile set receiving every tile the ray enters, the wall it
+ * hits included.
+ *
+ * Positions are cell index plus a 16-bit fraction, so finding the first
+ * grid line is a mask and every step after it is one add and compare.
+ * Distances along the ray come from the reciprocal sine/cosine tables.
+ */
+
+static void castSingleRayFixed(Sint64 posX, Sint64 posY, int angle,
+		FixedRayHit *hit, Uint64 *explored)
+{
+	bool facingDown = angle > 0 && angle < ANGLE_UNITS / 2;
+	bool facingRight = angle < ANGLE_UNITS / 4 ||
+		angle > 3 * ANGLE_UNITS / 4;
+	Sint64 horizontalDistance = INT64_MAX, verticalDistance = INT64_MAX;
+	Sint64 horizontalX = 0, verticalY = 0, x, y, xstep, ystep;
+	Sint64 horizontalCellY = 0, verticalCellX = 0;
+	Sint64 horizontalY = 0, verticalX = 0, cellX, cellY;
+	Sint64 firstHorizontal, firstVertical;
+	Sint64 limitX = INT64_MAX, limitY = INT64_MAX;
+	/* Tiles entered at each horizontal and vertical grid line crossed */
+	int horizontalCells[mapHeight + 1], verticalCells[mapWidth + 1];
+	int numHorizontal = 0, numVertical = 0;
+
+	/* Horizontal grid lines */
+	y = facingDown ? (posY & ~FIXED_FRACTION) + FIXED_ONE :
+		posY & ~FIXED_FRACTION;
+	x = posX + (((y - posY) * cotTable[angle]) >> FIXED_SHIFT);
+	ystep = facingDown ? FIXED_ONE : -FIXED_ONE;
+	xstep = facingDown ? cotTable[angle] : -cotTable[angle];
+	firstHorizontal = facingDown ? y - posY : posY - y;
+	while (x >= 0 && x < (Sint64)mapWidth << FIXED_SHIFT &&
+			y >= 0 && y < (Sint64)mapHeight << FIXED_SHIFT)
+	{
+		cellX = x >> FIXED_SHIFT;
+		cellY = (y >> FIXED_SHIFT) - (facingDown ? 0 : 1);
+		horizontalCells[numHorizontal++] = cellY >= 0 ?
+			cellY * mapWidth + cellX : -1;
+		if (isWallCell(cellX, cellY))
+		{
+			horizontalX = x;
+			horizontalY = y;
+			horizontalCellY = cellY;
+			horizontalDistance = ((facingDown ? y - posY : posY - y) *
+					invSinTable[angle]) >> FIXED_SHIFT;
+			break;
+		}
+		x += xstep;
+		y += ystep;
+	}
+
+	/* Vertical grid lines */
+	x = facingRight ? (posX & ~FIXED_FRACTION) + FIXED_ONE :
+		posX & ~FIXED_FRACTION;
+	y = posY + (((x - posX) * tanTable[angle]) >> FIXED_SHIFT);
+	xstep = facingRight ? FIXED_ONE : -FIXED_ONE;
+	ystep = facingRight ? tanTable[angle] : -tanTable[angle];
+	firstVertical = facingRight ? x - posX : posX - x;
+	while (x >= 0 && x < (Sint64)mapWidth << FIXED_SHIFT &&
+			y >= 0 && y < (Sint64)mapHeight << FIXED_SHIFT)
+	{
+		cellX = (x >> FIXED_SHIFT) - (facingRight ? 0 : 1);
+		cellY = y >> FIXED_SHIFT;
+		verticalCells[numVertical++] = cellX >= 0 ?
+			cellY * mapWidth + cellX : -1;
+		if (isWallCell(cellX, cellY))
+		{
+			verticalY = y;
+			verticalX = x;
+			verticalCellX = cellX;
+			verticalDistance = ((facingRight ? x - posX : posX - x) *
+					invCosTable[angle]) >> FIXED_SHIFT;
+			break;
+		}
+		x += xstep;
+		y += ystep;
+	}
+
+	hit->verticalRay = verticalDistance <= horizontalDistance;
+	hit->distance = hit->verticalRay ? verticalDistance : horizontalDistance;
+	hit->fraction = (hit->verticalRay ? verticalY : horizontalX) &
+		FIXED_FRACTION;
+	hit->tileX = hit->verticalRay ? verticalCellX : horizontalX >> FIXED_SHIFT;
+	hit->tileY = hit->verticalRay ? verticalY >> FIXED_SHIFT : horizontalCellY;
+	hit->tile = 0;
+	if (hit->distance == INT64_MAX)
+		hit->tileX = hit->tileY = NO_TILE;
+	else
+		hit->tile = worldMap[hit->tileY][hit->tileX];
+
+	/* Crossings of the other walk behind the hit were never seen */
+	if (hit->tile != 0)
+	{
+		x = hit->verticalRay ? verticalX : horizontalX;
+		y = hit->verticalRay ? verticalY : horizontalY;
+		limitX = facingRight ? x - posX : posX - x;
+		limitY = facingDown ? y - posY : posY - y;
+	}
+	mark_explored(explored, horizontalCells,
+			crossingsBefore(firstHorizontal, limitY, numHorizontal));
+	mark_explored(explored, verticalCells,
+			crossingsBefore(firstVertical, limitX, numVertical));
+}
+
+/**
+ * castRaysFixed - Fixed-point counterpart of castRays.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerRotation: The current rotation angle of the player.
+ * @hits: Receives the hit of every column.
+ *
+ * Description: The player's position is converted to tile units and the
+ * rotation snapped to the nearest angle unit once per frame; everything
+ * after that, including the projected wall height, is integer arithmetic.
+ * The hits are converted back to world pixels only when they are stored,
+ * and the tiles the rays cross are added to the explored set.
+ */
+
+void castRaysFixed(float playerX, float playerY, float playerRotation,
+		RayHits *hits)
+{
+	int ray, player, angle, offset;
+	Sint64 posX = ((Sint64)(int)playerX << FIXED_SHIFT) / TILE_SIZE;
+	Sint64 posY = ((Sint64)(int)playerY << FIXED_SHIFT) / TILE_SIZE;
+	Sint64 corrected;
+	FixedRayHit hit;
+	Uint64 explored[PVS_WORDS] = {0};
+	int cell = (int)(posY >> FIXED_SHIFT) * mapWidth +
+		(int)(posX >> FIXED_SHIFT);
+
+	player = (int)floor(playerRotation * ANGLE_UNITS_PER_DEG + 0.5);
+	player %= ANGLE_UNITS;
+	if (player < 0)
+		player += ANGLE_UNITS;
+
+	for (ray = 0; ray < NUM_RAYS; ray++)
+	{
+		offset = ray - (FOV_ANGLE * ANGLE_UNITS_PER_DEG) / 2;
+		angle = (player + offset + ANGLE_UNITS) % ANGLE_UNITS;
+		castSingleRayFixed(posX, posY, angle, &hit, explored);
+
+		hits->angle[ray] = (float)angle / ANGLE_UNITS_PER_DEG;
+		hits->verticalRay[ray] = hit.verticalRay;
+		hits->tile[ray] = hit.tile;
+		if (hit.tile == 0)
+		{
+			hits->distance[ray] = INFINITY;
+			hits->perpDistance[ray] = INFINITY;
+			hits->wallHeight[ray] = 0;
+			hits->texX[ray] = 0;
+			hits->tileX[ray] = NO_TILE;
+			hits->tileY[ray] = NO_TILE;
+			continue;
+		}
+
+		/* Perpendicular distance removes the fisheye distortion */
+		corrected = (hit.distance * cosTable[offset < 0 ? offset +
+				ANGLE_UNITS : offset]) >> FIXED_SHIFT;
+		if (corrected < 1)
+			corrected = 1;
+
+		hits->distance[ray] = (float)(hit.distance * TILE_SIZE) / FIXED_ONE;
+		hits->perpDistance[ray] = (float)(corrected * TILE_SIZE) / FIXED_ONE;
+		hits->wallHeight[ray] = (int)((projPlaneFixed << FIXED_SHIFT) /
+				corrected >> FIXED_SHIFT);
+		hits->texX[ray] = (int)((hit.fraction * TILE_SIZE) >> FIXED_SHIFT);
+		hits->tileX[ray] = hit.tileX;
+		hits->tileY[ray] = hit.tileY;
+	}
+
+	/* The player's own tile, which no ray crosses into */
+	mark_explored(explored, &cell, 1);
+	merge_explored(explored);
+}
@@ -30,6 +30,30 @@ void drawRay(SDL_Renderer *renderer, float playerX, float playerY,
 			(int)rayEndX, (int)rayEndY);
 }
 
+/**
+ * drawMiniMapRays - Draws the mini-map ray fan from the frame's hits.
+ * @renderer: The SDL_Renderer to render the rays on.
+ * @hits: The hits cast for the main view.
+ * @originX: Mini-map x of the player.
+ * @originY: Mini-map y of the player.
+ *
+ * Description: Every fifth column's ray is drawn, scaled down to the
+ * mini-map, so the fan shows exactly the walls the main view hit.
+ */
+
+void drawMiniMapRays(SDL_Renderer *renderer, const RayHits *hits,
+		float originX, float originY)
+{
+	int step = (int)(1 / MINIMAP_SCALE + 0.5f), ray;
+
+	for (ray = 0; ray < NUM_RAYS; ray += step)
+	{
+		if (hits->tile[ray] != 0)
+			drawRay(renderer, originX, originY, hits->angle[ray],
+					hits->distance[ray] * MINIMAP_SCALE);
+	}
+}
+
 /**
  * drawWallSlice - Draws a vertical slice of a wall on the renderer.
  * @renderer: The SDL_Renderer used for drawing.
@@ -37,6 +61,7 @@ void drawRay(SDL_Renderer *renderer, float playerX, float playerY,
  * @wallHeight: The calculated height of the wall slice.
  * @horizontalRay: Flag indicating if the hit was on a horizontal surface.
  * @verticalRay: Flag indicating if the hit was on a vertical surface.
+ * @light: Light level of the wall face, LIGHT_FULL for the plain colours.
  *
  * Description: This function renders a vertical line that represents a wall
  * slice in the rendered scene. The slice's position and height are calculated
@@ -46,24 +71,128 @@ void drawRay(SDL_Renderer *renderer, float playerX, float playerY,
  */
 
 void drawWallSlice(SDL_Renderer *renderer, int rayIndex, int wallHeight,
-		int horizontalRay, int verticalRay)
+		int horizontalRay, int verticalRay, int light)
 {
 	int wallTop = (SCREEN_HEIGHT / 2) - (wallHeight / 2);
 	int wallBottom = (SCREEN_HEIGHT / 2) + (wallHeight / 2);
+	const Uint8 *ramp;
 
-
-	if (horizontalRay)
+	if (light == LIGHT_FULL)
 	{
-		SDL_SetRenderDrawColor(renderer, 64, 64, 64, 255);
-		SDL_RenderDrawLine(renderer, rayIndex, wallTop, rayIndex, wallBottom);
+		/* The plain colours, without a ramp */
+		if (horizontalRay)
+			SDL_SetRenderDrawColor(renderer, 64, 64, 64, 255);
+		else if (verticalRay)
+			SDL_SetRenderDrawColor(renderer, 255, 253, 208, 255);
 	}
-	else if (verticalRay)
+	else
 	{
-		SDL_SetRenderDrawColor(renderer, 255, 253, 208, 255);
-		SDL_RenderDrawLine(renderer, rayIndex, wallTop, rayIndex, wallBottom);
+		ramp = light_ramp(light);
+		if (horizontalRay)
+			SDL_SetRenderDrawColor(renderer, ramp[64], ramp[64], ramp[64],
+					255);
+		else if (verticalRay)
+			SDL_SetRenderDrawColor(renderer, ramp[255], ramp[253], ramp[208],
+					255);
 	}
+	if (horizontalRay || verticalRay)
+		SDL_RenderDrawLine(renderer, rayIndex, wallTop, rayIndex, wallBottom);
+}
+
+/*
+ * WALL_COLUMN - Defines a textured wall column renderer for one texture
+ * layout and lighting mode. COLUMN_MAJOR and LIT are constants, so each
+ * expansion reads its texels from one layout and only the lit ones go
+ * through a light ramp; the render kernels pick one per frame.
+ */
+#define WALL_COLUMN(name, COLUMN_MAJOR, LIT) \
+void name(SDL_Renderer *renderer, int rayIndex, int wallHeight, \
+		wallTexture *texture, int texX, int light) \
+{ \
+	int drawStart = (SCREEN_HEIGHT / 2) - (wallHeight / 2); \
+	int drawEnd = (SCREEN_HEIGHT / 2) + (wallHeight / 2); \
+	/* Texels of the column are stride apart */ \
+	const Uint32 *column = COLUMN_MAJOR ? \
+		texture->columns + texX * texture->height : texture->pixels + texX; \
+	int stride = COLUMN_MAJOR ? 1 : texture->width; \
+	const Uint8 *ramp = NULL; \
+\
+	if (LIT) \
+		ramp = light_ramp(light); \
+	else \
+		(void)light; \
+	if (drawStart < 0) \
+		drawStart = 0; \
+	if (drawEnd >= SCREEN_HEIGHT) \
+		drawEnd = SCREEN_HEIGHT - 1; \
+\
+	for (int y = drawStart; y < drawEnd; y++) \
+	{ \
+		int d = y * 256 - SCREEN_HEIGHT * 128 + wallHeight * 128; \
+		int texY = ((d * texture->height) / wallHeight) / 256; \
+		Uint32 color = column[texY * stride]; \
+		Uint8 r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF; \
+		Uint8 b = color & 0xFF; \
+\
+		if (LIT) \
+		{ \
+			r = ramp[r]; \
+			g = ramp[g]; \
+			b = ramp[b]; \
+		} \
+		SDL_SetRenderDrawColor(renderer, r, g, b, 255); \
+		SDL_RenderDrawPoint(renderer, rayIndex, y); \
+	} \
 }
 
+/**
+ * drawWallRows - Draws a wall column from a row-major texture at full
+ * brightness.
+ * @renderer: Pointer to the SDL_Renderer used for drawing.
+ * @rayIndex: Screen column.
+ * @wallHeight: The height of the wall slice to be drawn.
+ * @texture: The wall texture.
+ * @texX: Texture column.
+ * @light: Unused, the column is drawn unlit.
+ */
+WALL_COLUMN(drawWallRows, false, false)
+
+/**
+ * drawWallRowsLit - Draws a wall column from a row-major texture through
+ * the ramp of its light level.
+ * @renderer: Pointer to the SDL_Renderer used for drawing.
+ * @rayIndex: Screen column.
+ * @wallHeight: The height of the wall slice to be drawn.
+ * @texture: The wall texture.
+ * @texX: Texture column.
+ * @light: Light level of the wall face.
+ */
+WALL_COLUMN(drawWallRowsLit, false, true)
+
+/**
+ * drawWallColumns - Draws a wall column from the column-major copy of a
+ * texture at full brightness.
+ * @renderer: Pointer to the SDL_Renderer used for drawing.
+ * @rayIndex: Screen column.
+ * @wallHeight: The height of the wall slice to be drawn.
+ * @texture: The wall texture, with columns set.
+ * @texX: Texture column.
+ * @light: Unused, the column is drawn unlit.
+ */
+WALL_COLUMN(drawWallColumns, true, false)
+
+/**
+ * drawWallColumnsLit - Draws a wall column from the column-major copy of
+ * a texture through the ramp of its light level.
+ * @renderer: Pointer to the SDL_Renderer used for drawing.
+ * @rayIndex: Screen column.
+ * @wallHeight: The height of the wall slice to be drawn.
+ * @texture: The wall texture, with columns set.
+ * @texX: Texture column.
+ * @light: Light level of the wall face.
+ */
+WALL_COLUMN(drawWallColumnsLit, true, true)
+
 /**
  * drawWallTexture - Renders a textured slice of a wall on the screen.
  * @renderer: Pointer to the SDL_Renderer used for drawing.
@@ -72,6 +201,8 @@ void drawWallSlice(SDL_Renderer *renderer, int rayIndex, int wallHeight,
  * @wallHeight: The height of the wall slice to be drawn.
  * @texture: Pointer to the wallTexture structure containing texture data.
  * @texX: The x-coordinate on the texture to start drawing from.
+ * @light: Light level of the wall face, applied through its ramp;
+ * LIGHT_FULL draws the texels unchanged without one.
  *
  * Description: This function is responsible for drawing a vertical slice of
  * a wall using a specific texture. The slice's height and position are
@@ -81,92 +212,211 @@ void drawWallSlice(SDL_Renderer *renderer, int rayIndex, int wallHeight,
  * allows the function to select the correct vertical strip of the texture,
  * aligning it with the ray's impact point on the wall, ensuring that texture
  * alignment appears continuous and accurate across multiple slices.
+ * The column is handed to the renderer for the texture's layout and
+ * light; the render kernels choose theirs once per frame instead.
  */
 
 void drawWallTexture(SDL_Renderer *renderer, int rayIndex, int wallHeight,
-		wallTexture *texture, int texX)
+		wallTexture *texture, int texX, int light)
 {
-	int drawStart = (SCREEN_HEIGHT / 2) - (wallHeight / 2);
-	int drawEnd = (SCREEN_HEIGHT / 2) + (wallHeight / 2);
-
-	if (drawStart < 0)
-		drawStart = 0;
-	if (drawEnd >= SCREEN_HEIGHT)
-		drawEnd = SCREEN_HEIGHT - 1;
+	WallColumn column;
 
-	for (int y = drawStart; y < drawEnd; y++)
-	{
-		int d = y * 256 - SCREEN_HEIGHT * 128 + wallHeight * 128;
-		int texY = ((d * texture->height) / wallHeight) / 256;
-		Uint32 color = texture->pixels[texY * texture->width + texX];
+	if (texture->columns)
+		column = light == LIGHT_FULL ? drawWallColumns : drawWallColumnsLit;
+	else
+		column = light == LIGHT_FULL ? drawWallRows : drawWallRowsLit;
+	column(renderer, rayIndex, wallHeight, texture, texX, light);
+}
 
-		Uint8 r, g, b;
+/**
+ * wall_spans - Finds, per column, the rows a floor or ceiling pass still
+ * has to shade around the frame's walls.
+ * @hits: The hits cast for the main view, or NULL to shade whole rows.
+ * @isCeiling: True for the ceiling, false for the floor.
+ * @limits: Receives SCREEN_WIDTH rows. The ceiling covers the rows above
+ * each limit; the floor covers the limit and the rows below it.
+ *
+ * The wall span is the one drawWallTexture fills, so the plane and the
+ * wall of a column meet without overlapping. Columns without a hit keep
+ * the plane's full half of the screen.
+ *
+ * Return: For the ceiling, the row below the lowest ceiling pixel; for
+ * the floor, the first row holding a floor pixel.
+ */
 
-		r = (color >> 16) & 0xFF;
-		g = (color >> 8) & 0xFF;
-		b = color & 0xFF;
+int wall_spans(const RayHits *hits, bool isCeiling, int *limits)
+{
+	int x, half, bound = isCeiling ? 0 : SCREEN_HEIGHT;
 
-		SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-		SDL_RenderDrawPoint(renderer, rayIndex, y);
+	for (x = 0; x < SCREEN_WIDTH; x++)
+	{
+		half = hits && hits->tile[x] != 0 ? hits->wallHeight[x] / 2 : 0;
+		if (isCeiling)
+		{
+			limits[x] = half < SCREEN_HEIGHT / 2 ?
+				SCREEN_HEIGHT / 2 - half : 0;
+			if (limits[x] > bound)
+				bound = limits[x];
+		}
+		else
+		{
+			/* drawWallTexture stops short of the last row */
+			limits[x] = half < SCREEN_HEIGHT / 2 - 1 ?
+				SCREEN_HEIGHT / 2 + half : SCREEN_HEIGHT - 1;
+			if (limits[x] < SCREEN_HEIGHT / 2 + 1)
+				limits[x] = SCREEN_HEIGHT / 2 + 1;
+			if (limits[x] < bound)
+				bound = limits[x];
+		}
 	}
+
+	return (bound);
+}
+
+/*
+ * PLANE_KERNEL - Defines a floor or ceiling renderer for one lighting mode.
+ * IS_CEILING and LIT are constants, so each expansion carries neither
+ * check in its pixel loop, and only the lit ones look up light ramps.
+ * Rows are walked outward from the wall spans found by wall_spans, with
+ * the texture stepped across every column so a skipped wall pixel leaves
+ * the next pixel's texel unchanged.
+ */
+#define PLANE_KERNEL(name, IS_CEILING, LIT) \
+void name(SDL_Instance *instance, float playerX, float playerY, \
+		float playerAngle, wallTexture *texture, const RayHits *hits) \
+{ \
+	float rayDirX0 = cos(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2)); \
+	float rayDirY0 = sin(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2)); \
+	float rayDirX1 = cos(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2)); \
+	float rayDirY1 = sin(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2)); \
+	float posZ = 0.5 * SCREEN_HEIGHT; \
+	Uint8 lights[SCREEN_WIDTH]; \
+	int limits[SCREEN_WIDTH]; \
+	int bound = wall_spans(hits, IS_CEILING, limits); \
+\
+	for (int y = IS_CEILING ? 0 : bound; \
+			y < (IS_CEILING ? bound : SCREEN_HEIGHT); y++) \
+	{ \
+		int p = IS_CEILING ? SCREEN_HEIGHT / 2 - y : y - SCREEN_HEIGHT / 2; \
+		float rowDistance = posZ / p; \
+		float stepX = rowDistance * (rayDirX1 - rayDirX0) / SCREEN_WIDTH; \
+		float stepY = rowDistance * (rayDirY1 - rayDirY0) / SCREEN_WIDTH; \
+		float planeX = playerX + rowDistance * rayDirX0; \
+		float planeY = playerY + rowDistance * rayDirY0; \
+		const Uint8 *ramp = NULL; \
+		int light = -1; \
+\
+		if (LIT) \
+			light_plane_row(playerX, playerY, playerAngle, p, lights); \
+		for (int x = 0; x < SCREEN_WIDTH; x++, planeX += stepX, \
+				planeY += stepY) \
+		{ \
+			if (IS_CEILING ? y >= limits[x] : y < limits[x]) \
+				continue; \
+			if (LIT && lights[x] != light) \
+			{ \
+				light = lights[x]; \
+				ramp = light_ramp(light); \
+			} \
+\
+			int cellX = (int)planeX; \
+			int cellY = (int)planeY; \
+			int tx = (int)(texture->width * (planeX - cellX)) & \
+				(texture->width - 1); \
+			int ty = (int)(texture->height * (planeY - cellY)) & \
+				(texture->height - 1); \
+			Uint32 color = ((Uint32 *)texture->pixels)[ty * texture->width + \
+				tx]; \
+\
+			Uint8 r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF; \
+			Uint8 b = color & 0xFF; \
+\
+			if (LIT) \
+			{ \
+				r = ramp[r]; \
+				g = ramp[g]; \
+				b = ramp[b]; \
+			} \
+			SDL_SetRenderDrawColor(instance->renderer, r, g, b, 255); \
+			SDL_RenderDrawPoint(instance->renderer, x, y); \
+		} \
+	} \
 }
 
 /**
- * drawFloor - Renders the floor texture.
+ * drawFloorLit - Renders the floor, each row split into spans of one light
+ * level whose texels are scaled through that level's ramp.
  * @instance: Pointer to an SDL_Instance containing rendering and
  * game state information.
  * @playerX: The x-coordinate of the player's position.
  * @playerY: The y-coordinate of the player's position.
  * @playerAngle: The angle of the player's viewing direction.
- * @floorTexture: Pointer to the floor texture structure.
+ * @texture: Pointer to the floor texture structure.
+ * @hits: The frame's hits; only pixels below each column's wall are
+ * shaded. NULL shades the whole lower half.
  */
+PLANE_KERNEL(drawFloorLit, false, true)
 
-void drawFloor(SDL_Instance *instance, float playerX, float playerY,
-		float playerAngle, wallTexture *floorTexture)
-{
-	for (int y = SCREEN_HEIGHT / 2 + 1; y < SCREEN_HEIGHT; y++)
-	{
-		float rayDirX0 = cos(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2));
-		float rayDirY0 = sin(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2));
-		float rayDirX1 = cos(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2));
-		float rayDirY1 = sin(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2));
-
-		int p = y - SCREEN_HEIGHT / 2;
-		float posZ = 0.5 * SCREEN_HEIGHT;
-		float rowDistance = posZ / p;
-		float floorStepX = rowDistance * (rayDirX1 - rayDirX0) / SCREEN_WIDTH;
-		float floorStepY = rowDistance * (rayDirY1 - rayDirY0) / SCREEN_WIDTH;
-		float floorX = playerX + rowDistance * rayDirX0;
-		float floorY = playerY + rowDistance * rayDirY0;
-
-		for (int x = 0; x < SCREEN_WIDTH; x++)
-		{
-			int cellX = (int)floorX;
-			int cellY = (int)floorY;
-			int tx = (int)(floorTexture->width *
-					(floorX - cellX)) & (floorTexture->width - 1);
-			int ty = (int)(floorTexture->height *
-					(floorY - cellY)) & (floorTexture->height - 1);
-
-			Uint32 floorColor = ((Uint32 *)floorTexture->pixels)[ty *
-				floorTexture->width + tx];
+/**
+ * drawFloorUnlit - Renders the floor at full brightness.
+ * @instance: Pointer to an SDL_Instance.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Pointer to the floor texture structure.
+ * @hits: The frame's hits, or NULL.
+ */
+PLANE_KERNEL(drawFloorUnlit, false, false)
 
-			Uint8 r, g, b;
+/**
+ * drawCeilingLit - Renders the ceiling, lit in spans like drawFloorLit.
+ * @instance: Pointer to an SDL_Instance.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Pointer to the ceiling texture structure.
+ * @hits: The frame's hits; only pixels above each column's wall are
+ * shaded. NULL shades the whole upper half.
+ */
+PLANE_KERNEL(drawCeilingLit, true, true)
 
-			r = (floorColor >> 16) & 0xFF;
-			g = (floorColor >> 8) & 0xFF;
-			b = floorColor & 0xFF;
+/**
+ * drawCeilingUnlit - Renders the ceiling at full brightness.
+ * @instance: Pointer to an SDL_Instance.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Pointer to the ceiling texture structure.
+ * @hits: The frame's hits, or NULL.
+ */
+PLANE_KERNEL(drawCeilingUnlit, true, false)
 
-			SDL_SetRenderDrawColor(instance->renderer, r, g, b, 255);
-			SDL_RenderDrawPoint(instance->renderer, x, y);
+/**
+ * drawFloor - Renders the floor texture.
+ * @instance: Pointer to an SDL_Instance containing rendering and
+ * game state information.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @floorTexture: Pointer to the floor texture structure.
+ * @hits: The frame's hits; only pixels below each column's wall are
+ * shaded. NULL shades the whole lower half.
+ *
+ * Picks the kernel for the current lighting mode; the game's frames use
+ * the kernel chosen per level by select_render_kernels instead.
+ */
 
-			floorX += floorStepX;
-			floorY += floorStepY;
-		}
-	}
+void drawFloor(SDL_Instance *instance, float playerX, float playerY,
+		float playerAngle, wallTexture *floorTexture, const RayHits *hits)
+{
+	if (lightingMode)
+		drawFloorLit(instance, playerX, playerY, playerAngle, floorTexture,
+				hits);
+	else
+		drawFloorUnlit(instance, playerX, playerY, playerAngle, floorTexture,
+				hits);
 }
 
-
 /**
  * drawCeiling - Renders the ceiling texture.
  * @instance: Pointer to an SDL_Instance containing rendering and
@@ -175,49 +425,19 @@ void drawFloor(SDL_Instance *instance, float playerX, float playerY,
  * @playerY: The y-coordinate of the player's position.
  * @playerAngle: The angle of the player's viewing direction.
  * @ceilingTexture: Pointer to the ceiling texture structure.
+ * @hits: The frame's hits; only pixels above each column's wall are
+ * shaded. NULL shades the whole upper half.
+ *
+ * Picks the kernel for the current lighting mode, like drawFloor.
  */
 
 void drawCeiling(SDL_Instance *instance, float playerX, float playerY,
-		float playerAngle, wallTexture *ceilingTexture)
+		float playerAngle, wallTexture *ceilingTexture, const RayHits *hits)
 {
-	for (int y = 0; y < SCREEN_HEIGHT / 2; y++)
-	{
-		float rayDirX0 = cos(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2));
-		float rayDirY0 = sin(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2));
-		float rayDirX1 = cos(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2));
-		float rayDirY1 = sin(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2));
-
-		int p = SCREEN_HEIGHT / 2 - y;  /* Invert p for ceiling */
-		float posZ = 0.5 * SCREEN_HEIGHT;
-		float rowDistance = posZ / p;
-		float ceilingStepX = rowDistance * (rayDirX1 - rayDirX0) / SCREEN_WIDTH;
-		float ceilingStepY = rowDistance * (rayDirY1 - rayDirY0) / SCREEN_WIDTH;
-		float ceilingX = playerX + rowDistance * rayDirX0;
-		float ceilingY = playerY + rowDistance * rayDirY0;
-
-		for (int x = 0; x < SCREEN_WIDTH; x++)
-		{
-			int cellX = (int)ceilingX;
-			int cellY = (int)ceilingY;
-			int tx = (int)(ceilingTexture->width *
-					(ceilingX - cellX)) & (ceilingTexture->width - 1);
-			int ty = (int)(ceilingTexture->height
-					* (ceilingY - cellY)) & (ceilingTexture->height - 1);
-
-			Uint32 ceilingColor = ((Uint32 *)ceilingTexture->pixels)[ty *
-				ceilingTexture->width + tx];
-
-			Uint8 r, g, b;
-
-			r = (ceilingColor >> 16) & 0xFF;
-			g = (ceilingColor >> 8) & 0xFF;
-			b = ceilingColor & 0xFF;
-
-			SDL_SetRenderDrawColor(instance->renderer, r, g, b, 255);
-			SDL_RenderDrawPoint(instance->renderer, x, y);
-
-			ceilingX += ceilingStepX;
-			ceilingY += ceilingStepY;
-		}
-	}
+	if (lightingMode)
+		drawCeilingLit(instance, playerX, playerY, playerAngle,
+				ceilingTexture, hits);
+	else
+		drawCeilingUnlit(instance, playerX, playerY, playerAngle,
+				ceilingTexture, hits);
 }
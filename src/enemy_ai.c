@@ -0,0 +1,279 @@
+#include "../headers/mazemania.h"
+
+/**
+ * distanceSquared - Squared distance between an enemy and the player.
+ * @enemy: The enemy.
+ * @state: The game state holding the player.
+ *
+ * Return: The squared distance between their centres in world pixels.
+ */
+
+static float distanceSquared(const Enemy *enemy, const GameState *state)
+{
+	float dx = (enemy->rect.x + enemy->rect.w / 2) -
+		(state->player.x + state->player.w / 2);
+	float dy = (enemy->rect.y + enemy->rect.h / 2) -
+		(state->player.y + state->player.h / 2);
+
+	return (dx * dx + dy * dy);
+}
+
+/**
+ * enemyBlocked - Tells whether an enemy rectangle overlaps a wall.
+ * @rect: The rectangle.
+ *
+ * Return: true if a tile under it is a wall or lies outside the map.
+ */
+
+static bool enemyBlocked(const SDL_Rect *rect)
+{
+	int x, y;
+
+	if (rect->x < 0 || rect->y < 0)
+		return (true);
+	for (y = rect->y / TILE_SIZE; y <= (rect->y + rect->h - 1) / TILE_SIZE;
+			y++)
+	{
+		for (x = rect->x / TILE_SIZE; x <= (rect->x + rect->w - 1) /
+				TILE_SIZE; x++)
+		{
+			if (x >= mapWidth || y >= mapHeight || worldMap[y][x] == 1 ||
+					worldMap[y][x] == 2)
+				return (true);
+		}
+	}
+
+	return (false);
+}
+
+/**
+ * thinkEnemy - Updates one enemy.
+ * @enemy: The enemy.
+ * @state: The game state; the enemy is updated to its tick.
+ * @index: Index of the enemy, which picks its turns apart from the others.
+ *
+ * An enemy that sees the player heads for them; otherwise it walks on
+ * until a wall stops it and turns. The move covers every tick since the
+ * enemy's last update, up to LOD_DISTANT_PERIOD of them. Turns are drawn
+ * from the game's random state without advancing it, so the enemies add
+ * no draws that would shift level generation.
+ */
+
+static void thinkEnemy(Enemy *enemy, const GameState *state, int index)
+{
+	Uint32 ticks = state->tick - enemy->lastThink;
+	float px = state->player.x + state->player.w / 2;
+	float py = state->player.y + state->player.h / 2;
+	float step;
+	Uint64 seed;
+	SDL_Rect next = enemy->rect;
+
+	if (ticks > LOD_DISTANT_PERIOD)
+		ticks = LOD_DISTANT_PERIOD;
+	enemy->lastThink = state->tick;
+	step = enemy->speed * ticks / TICK_RATE;
+
+	if (enemyCanSeePlayer(enemy, px, py))
+		enemy->direction = atan2f(py - (enemy->rect.y + enemy->rect.h / 2),
+				px - (enemy->rect.x + enemy->rect.w / 2)) * 180 / M_PI;
+
+	next.x += lroundf(cosf(DEG_TO_RAD(enemy->direction)) * step);
+	next.y += lroundf(sinf(DEG_TO_RAD(enemy->direction)) * step);
+	if (!enemyBlocked(&next))
+	{
+		enemy->rect = next;
+		return;
+	}
+
+	seed = state->rng ^ ((Uint64)state->tick << 32 | (Uint32)index);
+	enemy->direction = fmodf(enemy->direction + 90 *
+			(1 + rng_range(&seed, 3)), 360);
+}
+
+/**
+ * enemy_lod - Picks how often an enemy is updated.
+ * @enemy: The enemy.
+ * @state: The game state holding the player.
+ *
+ * Alert enemies, those seeing the player and those within LOD_NEAR_TILES
+ * of them update every tick. Others within LOD_SLEEP_TILES update every
+ * LOD_DISTANT_PERIOD ticks, and the rest sleep until something alerts
+ * them.
+ *
+ * Return: LOD_ACTIVE, LOD_DISTANT or LOD_ASLEEP.
+ */
+
+int enemy_lod(const Enemy *enemy, const GameState *state)
+{
+	float distance = distanceSquared(enemy, state);
+
+	if (state->tick < enemy->alertUntil ||
+			distance <= LOD_NEAR_TILES * LOD_NEAR_TILES * TILE_SIZE * TILE_SIZE ||
+			enemyCanSeePlayer(enemy, state->player.x + state->player.w / 2,
+				state->player.y + state->player.h / 2))
+		return (LOD_ACTIVE);
+	if (distance <= LOD_SLEEP_TILES * LOD_SLEEP_TILES * TILE_SIZE * TILE_SIZE)
+		return (LOD_DISTANT);
+
+	return (LOD_ASLEEP);
+}
+
+/**
+ * alert_enemy - Wakes an enemy up, whatever its distance.
+ * @enemy: The enemy.
+ *
+ * The enemy updates every tick for LOD_ALERT_TICKS from the next call of
+ * update_enemies. Weapons call it for every enemy they hit.
+ */
+
+void alert_enemy(Enemy *enemy)
+{
+	enemy->alertUntil = LOD_ALERT_PENDING;
+}
+
+/**
+ * hearsShot - Tells whether an enemy hears a player's shot of this tick.
+ * @enemy: The enemy.
+ * @state: The game state holding the player.
+ *
+ * Return: true if the player fired and is within LOD_HEARING_TILES.
+ */
+
+static bool hearsShot(const Enemy *enemy, const GameState *state)
+{
+	return (state->lastShot == state->tick &&
+			distanceSquared(enemy, state) <= LOD_HEARING_TILES *
+			LOD_HEARING_TILES * TILE_SIZE * TILE_SIZE);
+}
+
+/**
+ * updateEnemy - Runs one tick of a live enemy.
+ * @enemy: The enemy.
+ * @index: Its index among the level's enemies.
+ * @state: The game state holding the player it follows.
+ * @heard: Whether a shot of this tick alerts it.
+ * @stats: Receives its bucket, or NULL.
+ *
+ * Return: true if the enemy was updated, false if its bucket skips it.
+ */
+
+static bool updateEnemy(Enemy *enemy, int index, const GameState *state,
+		bool heard, EnemyLodStats *stats)
+{
+	int lod;
+
+	if (heard)
+		alert_enemy(enemy);
+	if (enemy->alertUntil == LOD_ALERT_PENDING)
+		enemy->alertUntil = state->tick + LOD_ALERT_TICKS;
+
+	lod = enemy_lod(enemy, state);
+	if (stats)
+		stats->occupancy[lod]++;
+	if (lod == LOD_ASLEEP || (lod == LOD_DISTANT &&
+				(state->tick + index) % LOD_DISTANT_PERIOD != 0))
+		return (false);
+	thinkEnemy(enemy, state, index);
+	return (true);
+}
+
+/**
+ * update_enemies - Runs one tick of the enemies.
+ * @enemies: The level's enemies.
+ * @numEnemies: Number of entries of @enemies.
+ * @state: The game state, its tick already advanced.
+ * @stats: Receives the bucket occupancy and cost of the tick, or NULL.
+ *
+ * Each live enemy is put in a bucket by enemy_lod. Distant enemies are
+ * spread over LOD_DISTANT_PERIOD ticks by their index, so about the same
+ * number of them updates every tick rather than all on one. A shot in
+ * this tick alerts the enemies within LOD_HEARING_TILES.
+ */
+
+void update_enemies(Enemy *enemies, int numEnemies, const GameState *state,
+		EnemyLodStats *stats)
+{
+	Uint64 start = SDL_GetPerformanceCounter(), counter;
+	Uint32 updates = 0;
+	int i;
+
+	for (i = 0; i < numEnemies; i++)
+	{
+		if (enemies[i].health > 0 && updateEnemy(&enemies[i], i, state,
+					hearsShot(&enemies[i], state), stats))
+			updates++;
+	}
+
+	if (!stats)
+		return;
+	counter = SDL_GetPerformanceCounter() - start;
+	stats->ticks++;
+	stats->updates += updates;
+	stats->counter += counter;
+	if (updates > stats->maxUpdates)
+		stats->maxUpdates = updates;
+	if (counter > stats->maxCounter)
+		stats->maxCounter = counter;
+}
+
+/**
+ * update_shared_enemies - Runs one tick of enemies several players share.
+ * @enemies: The level's enemies.
+ * @numEnemies: Number of entries of @enemies.
+ * @players: The players, all on the same tick, already advanced.
+ * @numPlayers: Number of entries of @players, at least 1.
+ *
+ * As update_enemies, but each enemy is bucketed by and follows the
+ * nearest player, and hears the shots of all of them. Used by the server.
+ */
+
+void update_shared_enemies(Enemy *enemies, int numEnemies,
+		const GameState *players, int numPlayers)
+{
+	float distance, nearestDistance;
+	bool heard;
+	int i, p, nearest;
+
+	for (i = 0; i < numEnemies; i++)
+	{
+		if (enemies[i].health <= 0)
+			continue;
+		nearest = 0;
+		nearestDistance = distanceSquared(&enemies[i], &players[0]);
+		heard = false;
+		for (p = 0; p < numPlayers; p++)
+		{
+			distance = distanceSquared(&enemies[i], &players[p]);
+			if (distance < nearestDistance)
+			{
+				nearest = p;
+				nearestDistance = distance;
+			}
+			heard = heard || hearsShot(&enemies[i], &players[p]);
+		}
+		updateEnemy(&enemies[i], i, &players[nearest], heard, NULL);
+	}
+}
+
+/**
+ * report_enemy_lod - Prints what update_enemies did over a session.
+ * @stats: The statistics.
+ */
+
+void report_enemy_lod(const EnemyLodStats *stats)
+{
+	double frequency = SDL_GetPerformanceFrequency() / 1e6;
+	double ticks = stats->ticks;
+
+	if (stats->ticks == 0)
+		return;
+
+	printf("enemies: %u ticks, avg %.1f active, %.1f distant, %.1f asleep\n",
+			stats->ticks, stats->occupancy[LOD_ACTIVE] / ticks,
+			stats->occupancy[LOD_DISTANT] / ticks,
+			stats->occupancy[LOD_ASLEEP] / ticks);
+	printf("enemies: avg %.2f updates, max %u per tick; avg %.2f us, "
+			"max %.2f us per tick\n", stats->updates / ticks,
+			stats->maxUpdates, stats->counter / frequency / ticks,
+			stats->maxCounter / frequency);
+}
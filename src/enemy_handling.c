@@ -1,35 +1,17 @@
 #include "../headers/mazemania.h"
 
-/**
- * depthBuffer - Array to store the corrected perpendicular distance for each
- * ray cast in the rendering process.
- *
- * This buffer stores the corrected perpendicular distance (corrected for the
- * fisheye effect) for each ray cast, corresponding to each vertical column on
- * the screen. It ensures that closer objects are rendered in front of farther
- * ones, aids in realistic scaling of objects based on their distance from the
- * player, and enhances the 3D effect and rendering performance.
- */
-float depthBuffer[SCREEN_WIDTH];
-
-
 /**
  * init_Enemy - Initializes an enemy with the specified parameters.
  * @enemy: Pointer to the Enemy structure to initialize.
  * @x: The x-coordinate of the enemy's position.
  * @y: The y-coordinate of the enemy's position.
- * @texturePath: The path to the texture file for the enemy.
- * @renderer: Pointer to the SDL_Renderer structure for rendering.
- *
- * Return: 0 on success else 1 on failure.
+ * @texture: The texture the enemy is drawn with, shared by its level.
  *
  * This function initializes an enemy with the specified position, size, speed,
- * health, and direction. It also loads the enemy texture from the specified
- * file path using the provided renderer.
+ * health, direction and texture.
  */
 
-int init_Enemy(Enemy *enemy, int x, int y, const char *texturePath,
-		SDL_Renderer *renderer)
+void init_Enemy(Enemy *enemy, int x, int y, SDL_Texture *texture)
 {
 	enemy->rect.x = x;
 	enemy->rect.y = y;
@@ -38,15 +20,35 @@ int init_Enemy(Enemy *enemy, int x, int y, const char *texturePath,
 	enemy->speed = 100.0f;
 	enemy->health = 100;
 	enemy->direction = 0.0f;
+	enemy->lastThink = 0;
+	enemy->alertUntil = 0;
+	enemy->texture = texture;
+}
 
-	/* Load the enemy texture */
-	if (load_EnemyTexture(renderer, texturePath, &enemy->texture, false) != 0)
+/**
+ * free_enemies - Destroys the texture of a level's enemies.
+ * @enemies: The enemies.
+ * @numEnemies: Number of entries of @enemies.
+ *
+ * The enemies of a level share one texture, which is destroyed once. Each
+ * texture pointer is cleared, so freeing the same enemies twice is
+ * harmless.
+ */
+
+void free_enemies(Enemy *enemies, int numEnemies)
+{
+	SDL_Texture *destroyed = NULL;
+	int i;
+
+	for (i = 0; i < numEnemies; i++)
 	{
-		fprintf(stderr, "Failed to load enemy texture: %s\n", texturePath);
-		return (1);
+		if (enemies[i].texture != destroyed)
+		{
+			destroyed = enemies[i].texture;
+			mem_destroy_texture(destroyed);
+		}
+		enemies[i].texture = NULL;
 	}
-
-	return (0);
 }
 
 /**
@@ -63,14 +65,26 @@ int init_Enemy(Enemy *enemy, int x, int y, const char *texturePath,
  * angle. It calculates the distance and angle to each enemy, adjusts their
  * positions on the screen accordingly, and scales them based on their distance
  * to create a 3D effect. Only enemies within the player's field of view and
- * in front of the player are rendered.
+ * in front of the player are rendered. Enemies standing in tiles that are not
+ * in the player's visibility set are rejected before any projection maths,
+ * and dead enemies are not drawn at all.
  */
 
-void renderEnemies3D(SDL_Instance *instance, Enemy *enemies, int numEnemies,
-		float playerX, float playerY, float playerAngle)
+void renderEnemies3D(SDL_Instance *instance, const Enemy *enemies,
+		int numEnemies, float playerX, float playerY, float playerAngle)
 {
+	int playerTileX = (int)playerX / TILE_SIZE;
+	int playerTileY = (int)playerY / TILE_SIZE;
+
 	for (int i = 0; i < numEnemies; i++)
 	{
+		/* The dead stay in the array until the level ends */
+		if (enemies[i].health <= 0)
+			continue;
+		if (!tileVisible(playerTileX, playerTileY,
+					enemies[i].rect.x / TILE_SIZE, enemies[i].rect.y / TILE_SIZE))
+			continue;
+
 		float dx = enemies[i].rect.x - playerX;
 		float dy = enemies[i].rect.y - playerY;
 		float distanceToEnemy = sqrtf(dx * dx + dy * dy);
@@ -96,7 +110,9 @@ void renderEnemies3D(SDL_Instance *instance, Enemy *enemies, int numEnemies,
 				(2 * tan(DEG_TO_RAD(FOV_ANGLE) / 2)));
 		float enemyWidth = enemyHeight;
 
-		if (distanceToEnemy > 0 && depthBuffer[(int)screenX] > distanceToEnemy)
+		if (distanceToEnemy > 0 && screenX >= 0 &&
+				(int)screenX < NUM_RAYS &&
+				rayHits.perpDistance[(int)screenX] > distanceToEnemy)
 		{
 			SDL_Rect enemyRect;
 
@@ -104,8 +120,11 @@ void renderEnemies3D(SDL_Instance *instance, Enemy *enemies, int numEnemies,
 			enemyRect.y = screenY - enemyHeight / 2;
 			enemyRect.w = enemyWidth;
 			enemyRect.h = enemyHeight;
-			SDL_RenderCopyEx(instance->renderer, enemies[i].texture, NULL,
-					&enemyRect, 0, NULL, SDL_FLIP_NONE);
+			if (gpuBatchMode)
+				batchSprite(enemies[i].texture, &enemyRect);
+			else
+				SDL_RenderCopyEx(instance->renderer, enemies[i].texture, NULL,
+						&enemyRect, 0, NULL, SDL_FLIP_NONE);
 		}
 	}
 }
@@ -145,20 +164,25 @@ void findSpawnPoints(int *spawnPointsX, int *spawnPointsY, int *numSpawnPoints)
  * @enemies: Pointer to an array of Enemy structures to store loaded enemies.
  * @level: The level for which enemies are to be loaded.
  * @instance: Pointer to the SDL_Instance structure with window and renderer.
+ * @rng: Pointer to the game state's random number generator.
  *
  * This function loads enemies for the specified level. It randomly selects
- * spawn points from the world map and initializes enemies at those points
- * with the specified texture and renderer. It returns 0 on success and 1
- * on failure.
+ * spawn points from the world map and initializes enemies at those points.
+ * The enemy texture is created once and shared by all of them, so the GPU
+ * path draws every sprite of the level in one batch. The choice only
+ * depends on the generator state, so a seeded session always spawns the
+ * same enemies. It returns 0 on success and 1 on failure.
  *
  * Return: 0 on success, 1 on failure.
  */
 
-int load_enemies(Enemy *enemies, int level, SDL_Instance *instance)
+int load_enemies(Enemy *enemies, int level, SDL_Instance *instance,
+		Uint64 *rng)
 {
 	int spawnPointsX[mapHeight * mapWidth];
 	int spawnPointsY[mapHeight * mapWidth];
 	int numSpawnPoints, i, j, numEnemies, index;
+	SDL_Texture *texture;
 
 	findSpawnPoints(spawnPointsX, spawnPointsY, &numSpawnPoints);
 
@@ -168,20 +192,20 @@ int load_enemies(Enemy *enemies, int level, SDL_Instance *instance)
 		fprintf(stderr, "Not enough spawn points for enemies.\n");
 		return (1);
 	}
-
-	/* Seed the random number generator */
-	srand(time(NULL));
+	if (load_EnemyTexture(instance->renderer, ENEMY_TEXTURE_PATH, &texture,
+				false) != 0)
+	{
+		fprintf(stderr, "Failed to load enemy texture: %s\n",
+				ENEMY_TEXTURE_PATH);
+		return (1);
+	}
 
 	for (i = 0; i < numEnemies; i++)
 	{
-		index = rand() % numSpawnPoints;
-		if ((init_Enemy(&enemies[i], spawnPointsX[index] * TILE_SIZE +
+		index = rng_range(rng, numSpawnPoints);
+		init_Enemy(&enemies[i], spawnPointsX[index] * TILE_SIZE +
 				(TILE_SIZE / 3), spawnPointsY[index] * TILE_SIZE + (TILE_SIZE / 3),
-				"../images/Enemy2.png", instance->renderer)) != 0)
-		{
-			fprintf(stderr, "Could not completely initialize enemies.\n");
-			return (1);
-		}
+				texture);
 
 		/* Remove the selected spawn point */
 		for (j = index; j < numSpawnPoints - 1; j++)
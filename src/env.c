@@ -0,0 +1,435 @@
+#include "../headers/mazemania.h"
+
+/*
+ * View geometry shared by every instance: each column's ray direction
+ * relative to the player and the inverse of its fisheye factor, and the
+ * perpendicular distance of the floor seen by each row below the horizon.
+ */
+static double columnCos[ENV_OBS_WIDTH];
+static double columnSin[ENV_OBS_WIDTH];
+static double columnStretch[ENV_OBS_WIDTH];
+static double rowDistance[ENV_OBS_HEIGHT];
+static double projection;
+
+/**
+ * initViewTables - Fills the view geometry tables.
+ */
+
+static void initViewTables(void)
+{
+	double offset;
+	int i;
+
+	projection = (ENV_OBS_WIDTH / 2) / tan(DEG_TO_RAD(FOV_ANGLE) / 2);
+	for (i = 0; i < ENV_OBS_WIDTH; i++)
+	{
+		offset = DEG_TO_RAD(FOV_ANGLE * ((i + 0.5) / ENV_OBS_WIDTH - 0.5));
+		columnCos[i] = cos(offset);
+		columnSin[i] = sin(offset);
+		columnStretch[i] = 1 / columnCos[i];
+	}
+	for (i = 0; i < ENV_OBS_HEIGHT; i++)
+		rowDistance[i] = i + 0.5 > ENV_OBS_HEIGHT / 2.0 ? projection / 2 /
+			(i + 0.5 - ENV_OBS_HEIGHT / 2.0) : 0;
+}
+
+/**
+ * copyEnvRow - Stores a generated tile row in an instance's map.
+ * @row: Tile row.
+ * @width: Number of tiles.
+ * @y: Tile row index.
+ * @context: Pointer to the MazeEnv.
+ */
+
+static void copyEnvRow(const int *row, int width, int y, void *context)
+{
+	MazeEnv *env = context;
+
+	memcpy(env->map[y], row, width * sizeof(int));
+}
+
+/**
+ * resetEnv - Starts a new episode of one instance.
+ * @batch: The batch.
+ * @env: The instance.
+ *
+ * The level is either a copy of a built-in level or a maze generated from
+ * the instance's seed, the same way --generate builds the game's levels.
+ */
+
+static void resetEnv(const MazeEnvBatch *batch, MazeEnv *env)
+{
+	MazeParams params = {env->seed, mapWidth, mapHeight, 0};
+
+	if (batch->level > 0)
+		memcpy(env->map, batch->levels[batch->level - 1], sizeof(env->map));
+	else
+		generate_maze(&params, 1, copyEnvRow, env);
+
+	memset(&env->state, 0, sizeof(env->state));
+	env->state.player.x = 80;
+	env->state.player.y = 80;
+	env->state.player.w = ENV_PLAYER_SIZE;
+	env->state.player.h = ENV_PLAYER_SIZE;
+	env->state.level = batch->level;
+	seed_rng(&env->state.rng, env->seed);
+}
+
+/**
+ * observe - Renders an instance's low-resolution view.
+ * @env: The instance.
+ * @view: Receives ENV_OBS_SIZE grey levels, row after row.
+ *
+ * Each column casts one grid-walking ray from the player's centre. Walls
+ * are shaded by side and distance, the exit tile shows up bright on the
+ * floor, and ceiling and floor are flat, which is all an agent needs to
+ * find its way.
+ */
+
+static void observe(const MazeEnv *env, Uint8 *view)
+{
+	double posX = (env->state.player.x + env->state.player.w / 2.0) /
+		TILE_SIZE;
+	double posY = (env->state.player.y + env->state.player.h / 2.0) /
+		TILE_SIZE;
+	double viewCos = cos(DEG_TO_RAD(env->state.degrees));
+	double viewSin = sin(DEG_TO_RAD(env->state.degrees));
+	double dirX, dirY, deltaX, deltaY, sideX, sideY;
+	double distance, exitNear, exitFar, perp, height, floorDistance;
+	int column, y, mapX, mapY, stepX, stepY, side, tile, top, bottom;
+	Uint8 shade;
+
+	for (column = 0; column < ENV_OBS_WIDTH; column++)
+	{
+		/* The player's direction turned by the column's offset */
+		dirX = viewCos * columnCos[column] - viewSin * columnSin[column];
+		dirY = viewSin * columnCos[column] + viewCos * columnSin[column];
+		mapX = (int)posX;
+		mapY = (int)posY;
+		stepX = dirX < 0 ? -1 : 1;
+		stepY = dirY < 0 ? -1 : 1;
+		deltaX = dirX == 0 ? 1e30 : fabs(1 / dirX);
+		deltaY = dirY == 0 ? 1e30 : fabs(1 / dirY);
+		sideX = (dirX < 0 ? posX - mapX : mapX + 1 - posX) * deltaX;
+		sideY = (dirY < 0 ? posY - mapY : mapY + 1 - posY) * deltaY;
+		distance = 0;
+		exitNear = -1;
+		exitFar = -1;
+		side = 0;
+
+		while (true)
+		{
+			if (sideX < sideY)
+			{
+				distance = sideX;
+				sideX += deltaX;
+				mapX += stepX;
+				side = 0;
+			}
+			else
+			{
+				distance = sideY;
+				sideY += deltaY;
+				mapY += stepY;
+				side = 1;
+			}
+			if (exitNear >= 0 && exitFar < 0)
+				exitFar = distance;
+			if (mapX < 0 || mapX >= mapWidth || mapY < 0 || mapY >= mapHeight)
+				break;
+			tile = env->map[mapY][mapX];
+			if (tile == 1 || tile == 2)
+				break;
+			if (tile == 3 && exitNear < 0)
+				exitNear = distance;
+		}
+		if (exitNear >= 0 && exitFar < 0)
+			exitFar = distance;
+
+		perp = distance * columnCos[column];
+		height = projection / (perp > 1e-3 ? perp : 1e-3);
+		top = (int)ceil(ENV_OBS_HEIGHT / 2.0 - height / 2 - 0.5);
+		bottom = (int)floor(ENV_OBS_HEIGHT / 2.0 + height / 2 - 0.5);
+		shade = (side ? 200 : 150) / (1 + perp / 4);
+		for (y = 0; y < ENV_OBS_HEIGHT; y++)
+		{
+			if (y < top)
+				view[y * ENV_OBS_WIDTH + column] = 32;
+			else if (y <= bottom)
+				view[y * ENV_OBS_WIDTH + column] = shade;
+			else
+			{
+				/* Distance along the ray of the floor seen by this pixel */
+				floorDistance = rowDistance[y] * columnStretch[column];
+				view[y * ENV_OBS_WIDTH + column] = floorDistance >= exitNear &&
+					floorDistance < exitFar ? 255 : 96;
+			}
+		}
+	}
+}
+
+/**
+ * stepEnv - Advances one instance by one tick.
+ * @batch: The batch.
+ * @i: Index of the instance.
+ *
+ * Reaching the exit is worth 1 and every tick costs ENV_TICK_REWARD, so an
+ * episode that times out after ENV_MAX_TICKS scores -1. A finished episode
+ * restarts at once on its next seed, and the observation returned is the
+ * first of the new episode.
+ */
+
+static void stepEnv(MazeEnvBatch *batch, int i)
+{
+	MazeEnv *env = &batch->envs[i];
+	GameState *state = &env->state;
+	bool done;
+
+	move_player(state, env->map, batch->actions[i], ENV_SPEED,
+			1.0f / TICK_RATE);
+	state->tick++;
+
+	batch->rewards[i] = ENV_TICK_REWARD;
+	done = state->tick >= ENV_MAX_TICKS;
+	if (env->map[state->player.y / TILE_SIZE][state->player.x / TILE_SIZE] ==
+			3)
+	{
+		batch->rewards[i] += 1;
+		done = true;
+	}
+	batch->dones[i] = done;
+	if (done)
+	{
+		env->seed += batch->count;
+		resetEnv(batch, env);
+	}
+}
+
+/**
+ * runInstances - Claims and runs chunks of instances until none remain.
+ * @batch: The batch.
+ */
+
+static void runInstances(MazeEnvBatch *batch)
+{
+	int first, i, last;
+
+	while ((first = SDL_AtomicAdd(&batch->next, ENV_CHUNK)) < batch->count)
+	{
+		last = first + ENV_CHUNK < batch->count ? first + ENV_CHUNK :
+			batch->count;
+		for (i = first; i < last; i++)
+		{
+			if (batch->job == ENV_JOB_RESET)
+			{
+				batch->envs[i].seed = batch->seed + i;
+				resetEnv(batch, &batch->envs[i]);
+				batch->rewards[i] = 0;
+				batch->dones[i] = 0;
+			}
+			else
+			{
+				stepEnv(batch, i);
+			}
+			observe(&batch->envs[i], batch->observations +
+					(size_t)i * ENV_OBS_SIZE);
+		}
+	}
+}
+
+/**
+ * envWorker - Thread body waiting for jobs until the batch is freed.
+ * @data: Pointer to the MazeEnvBatch.
+ *
+ * Return: Always 0.
+ */
+
+static int envWorker(void *data)
+{
+	MazeEnvBatch *batch = data;
+
+	while (true)
+	{
+		SDL_SemWait(batch->start);
+		if (batch->quit)
+			break;
+		runInstances(batch);
+		SDL_SemPost(batch->finished);
+	}
+
+	return (0);
+}
+
+/**
+ * runJob - Runs a reset or step over every instance on every worker.
+ * @batch: The batch.
+ * @job: ENV_JOB_RESET or ENV_JOB_STEP.
+ */
+
+static void runJob(MazeEnvBatch *batch, int job)
+{
+	int i;
+
+	batch->job = job;
+	SDL_AtomicSet(&batch->next, 0);
+	for (i = 1; i < batch->numThreads; i++)
+		SDL_SemPost(batch->start);
+	runInstances(batch);
+	for (i = 1; i < batch->numThreads; i++)
+		SDL_SemWait(batch->finished);
+}
+
+/**
+ * loadLevels - Reads the six built-in levels of a level file.
+ * @batch: The batch.
+ * @path: Level file in the format of worlds.txt.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int loadLevels(MazeEnvBatch *batch, const char *path)
+{
+	FILE *file = fopen(path, "r");
+	int i, status = 0;
+
+	batch->levels = malloc(6 * sizeof(*batch->levels));
+	if (!file || !batch->levels)
+	{
+		fprintf(stderr, "Could not load the levels from %s\n", path);
+		if (file)
+			fclose(file);
+		return (1);
+	}
+	for (i = 0; i < 6 && status == 0; i++)
+		status = load_up_world(file, batch->levels[i]) != 0;
+	fclose(file);
+
+	return (status);
+}
+
+/**
+ * env_batch_init - Creates a batch of headless game instances.
+ * @batch: The batch to initialize.
+ * @count: Number of instances.
+ * @numThreads: Workers to step them with, including the calling thread.
+ * @levelsPath: Level file with the built-in levels, or NULL to only play
+ * generated mazes.
+ *
+ * The instances are ready after env_batch_reset.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int env_batch_init(MazeEnvBatch *batch, int count, int numThreads,
+		const char *levelsPath)
+{
+	int i;
+
+	memset(batch, 0, sizeof(*batch));
+	initViewTables();
+	batch->count = count;
+	batch->numThreads = numThreads < 1 ? 1 : numThreads;
+	batch->envs = calloc(count, sizeof(MazeEnv));
+	batch->observations = calloc(count, ENV_OBS_SIZE);
+	batch->rewards = calloc(count, sizeof(float));
+	batch->dones = calloc(count, 1);
+	batch->threads = calloc(batch->numThreads, sizeof(SDL_Thread *));
+	batch->start = SDL_CreateSemaphore(0);
+	batch->finished = SDL_CreateSemaphore(0);
+	if (count < 1 || !batch->envs || !batch->observations ||
+			!batch->rewards || !batch->dones || !batch->threads ||
+			!batch->start || !batch->finished ||
+			(levelsPath && loadLevels(batch, levelsPath) != 0))
+	{
+		fprintf(stderr, "Could not create %d environments\n", count);
+		env_batch_free(batch);
+		return (1);
+	}
+
+	for (i = 1; i < batch->numThreads; i++)
+	{
+		batch->threads[i] = SDL_CreateThread(envWorker, "env", batch);
+		if (!batch->threads[i])
+		{
+			fprintf(stderr, "Could not start an environment thread: %s\n",
+					SDL_GetError());
+			batch->numThreads = i;
+			env_batch_free(batch);
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+/**
+ * env_batch_reset - Starts a new episode on every instance.
+ * @batch: The batch.
+ * @seed: Instance i plays seed + i, then seed + i + count and so on.
+ * @level: Built-in level 1 to 6, or 0 for mazes generated from the seed.
+ *
+ * Fills the observations of the first tick and clears rewards and dones.
+ *
+ * Return: 0 on success, 1 if the level is not available.
+ */
+
+int env_batch_reset(MazeEnvBatch *batch, Uint64 seed, int level)
+{
+	if (level < 0 || level > 6 || (level > 0 && !batch->levels))
+	{
+		fprintf(stderr, "Level %d is not available\n", level);
+		return (1);
+	}
+
+	batch->level = level;
+	batch->seed = seed;
+	runJob(batch, ENV_JOB_RESET);
+	return (0);
+}
+
+/**
+ * env_batch_step - Advances every instance by one tick.
+ * @batch: The batch.
+ * @actions: One input word per instance, INPUT_* bits as in a recording.
+ *
+ * Fills the observations, rewards and dones of the tick.
+ */
+
+void env_batch_step(MazeEnvBatch *batch, const Uint16 *actions)
+{
+	batch->actions = actions;
+	runJob(batch, ENV_JOB_STEP);
+}
+
+/**
+ * env_batch_free - Stops the workers and frees a batch.
+ * @batch: The batch.
+ */
+
+void env_batch_free(MazeEnvBatch *batch)
+{
+	int i;
+
+	batch->quit = true;
+	for (i = 1; i < batch->numThreads; i++)
+	{
+		if (batch->threads && batch->threads[i])
+			SDL_SemPost(batch->start);
+	}
+	for (i = 1; i < batch->numThreads; i++)
+	{
+		if (batch->threads && batch->threads[i])
+			SDL_WaitThread(batch->threads[i], NULL);
+	}
+	if (batch->start)
+		SDL_DestroySemaphore(batch->start);
+	if (batch->finished)
+		SDL_DestroySemaphore(batch->finished);
+	free(batch->envs);
+	free(batch->observations);
+	free(batch->rewards);
+	free(batch->dones);
+	free(batch->levels);
+	free(batch->threads);
+	memset(batch, 0, sizeof(*batch));
+}
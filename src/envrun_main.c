@@ -0,0 +1,105 @@
+#include "../headers/mazemania.h"
+
+/**
+ * randomActions - Picks a random movement and turn for every instance.
+ * @actions: Receives one input word per instance.
+ * @count: Number of instances.
+ * @rng: Random state.
+ */
+
+static void randomActions(Uint16 *actions, int count, Uint64 *rng)
+{
+	static const Uint16 moves[] = {0, INPUT_FORWARD, INPUT_FORWARD,
+		INPUT_BACK, INPUT_LEFT, INPUT_RIGHT};
+	static const Uint16 turns[] = {0, 0, INPUT_TURN_LEFT, INPUT_TURN_RIGHT};
+	int i;
+
+	for (i = 0; i < count; i++)
+		actions[i] = moves[rng_range(rng, 6)] | turns[rng_range(rng, 4)];
+}
+
+/**
+ * main - Entry point of the environment throughput driver.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: envrun [--envs N] [--threads N] [--steps N] [--level N]
+ * [--seed N] [--levels FILE] steps a batch of headless instances with a
+ * random policy that changes its mind every half second of game time, and
+ * prints the throughput and episode statistics as one JSON object.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int main(int argc, char *argv[])
+{
+	MazeEnvBatch batch;
+	Uint16 *actions;
+	const char *levelsPath = NULL;
+	int count = 4096, numThreads = SDL_GetCPUCount(), level = 0, i;
+	long steps = 1000, step, episodes = 0;
+	double reward = 0, seconds;
+	Uint64 seed = 1, rng, start;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--envs") == 0 && i + 1 < argc)
+			count = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			numThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+			steps = atol(argv[++i]);
+		else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+			level = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc)
+			levelsPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "Usage: %s [--envs N] [--threads N] [--steps N] "
+					"[--level N] [--seed N] [--levels FILE]\n", argv[0]);
+			return (1);
+		}
+	}
+
+	actions = calloc(count > 0 ? count : 1, sizeof(Uint16));
+	if (!actions || env_batch_init(&batch, count, numThreads,
+				levelsPath) != 0)
+	{
+		free(actions);
+		return (1);
+	}
+	if (env_batch_reset(&batch, seed, level) != 0)
+	{
+		env_batch_free(&batch);
+		free(actions);
+		return (1);
+	}
+
+	seed_rng(&rng, seed);
+	start = SDL_GetPerformanceCounter();
+	for (step = 0; step < steps; step++)
+	{
+		if (step % (TICK_RATE / 2) == 0)
+			randomActions(actions, count, &rng);
+		env_batch_step(&batch, actions);
+		for (i = 0; i < count; i++)
+		{
+			reward += batch.rewards[i];
+			episodes += batch.dones[i];
+		}
+	}
+	seconds = (double)(SDL_GetPerformanceCounter() - start) /
+		SDL_GetPerformanceFrequency();
+
+	printf("{\"envs\":%d,\"threads\":%d,\"steps\":%ld,\"seconds\":%.3f,"
+			"\"stepsPerSecond\":%.0f,\"episodes\":%ld,\"rewardPerStep\":%.6f}\n",
+			count, batch.numThreads, steps, seconds,
+			count * steps / seconds, episodes, reward / (count * steps));
+
+	env_batch_free(&batch);
+	free(actions);
+
+	return (0);
+}
@@ -0,0 +1,110 @@
+#include "../headers/mazemania.h"
+
+/*
+ * Tiles of the current level the player has seen, one bit per tile
+ * (y * mapWidth + x). The render thread adds to it once per frame and the
+ * simulation thread saves and restores it, so both go through the lock.
+ */
+static Uint64 explored[PVS_WORDS];
+static SDL_SpinLock lock;
+
+/**
+ * mark_explored - Sets the bits of the tiles a ray crossed.
+ * @tiles: Tile set to mark, PVS_WORDS long.
+ * @cells: Indices of the tiles, -1 for a crossing outside the map.
+ * @count: Number of entries of @cells to mark.
+ *
+ * Rays mark a set of their own frame, see castRays, which merge_explored
+ * then adds to the level's in one go.
+ */
+
+void mark_explored(Uint64 *tiles, const int *cells, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (cells[i] >= 0)
+			tiles[cells[i] / 64] |= (Uint64)1 << (cells[i] % 64);
+	}
+}
+
+/**
+ * merge_explored - Adds a frame's tiles to the level's explored set.
+ * @tiles: The frame's tile set.
+ */
+
+void merge_explored(const Uint64 *tiles)
+{
+	int i;
+
+	SDL_AtomicLock(&lock);
+	for (i = 0; i < PVS_WORDS; i++)
+		explored[i] |= tiles[i];
+	SDL_AtomicUnlock(&lock);
+}
+
+/**
+ * get_explored - Copies the level's explored set.
+ * @tiles: Receives the set, PVS_WORDS long.
+ */
+
+void get_explored(Uint64 *tiles)
+{
+	SDL_AtomicLock(&lock);
+	memcpy(tiles, explored, sizeof(explored));
+	SDL_AtomicUnlock(&lock);
+}
+
+/**
+ * set_explored - Replaces the level's explored set, as a save state does.
+ * @tiles: The new set.
+ */
+
+void set_explored(const Uint64 *tiles)
+{
+	SDL_AtomicLock(&lock);
+	memcpy(explored, tiles, sizeof(explored));
+	SDL_AtomicUnlock(&lock);
+}
+
+/**
+ * clear_explored - Forgets every explored tile. Called by loadCurrentLevel.
+ */
+
+void clear_explored(void)
+{
+	SDL_AtomicLock(&lock);
+	memset(explored, 0, sizeof(explored));
+	SDL_AtomicUnlock(&lock);
+}
+
+/**
+ * count_explored - Counts the tiles of the level seen so far.
+ *
+ * Return: The number of explored tiles, walls included.
+ */
+
+int count_explored(void)
+{
+	Uint64 tiles[PVS_WORDS];
+	int count = 0, i;
+
+	get_explored(tiles);
+	for (i = 0; i < PVS_WORDS; i++)
+		count += __builtin_popcountll(tiles[i]);
+
+	return (count);
+}
+
+/**
+ * report_explored - Prints how much of the current level was seen.
+ */
+
+void report_explored(void)
+{
+	int count = count_explored();
+
+	printf("explored: %d of %d tiles (%.1f%%)\n", count,
+			mapWidth * mapHeight, 100.0 * count / (mapWidth * mapHeight));
+}
@@ -0,0 +1,759 @@
+#include "../headers/mazemania.h"
+
+/**
+ * struct CameraPose - A fixed viewpoint rendered for every level.
+ * @atExit: Place the camera on the exit tile instead of the start.
+ * @degrees: Viewing angle.
+ */
+
+typedef struct CameraPose
+{
+	bool atExit;
+	double degrees;
+} CameraPose;
+
+/**
+ * struct RenderPath - One way of drawing the golden poses.
+ * @name: Name used in the report and in the names of failure images.
+ * @fixedPoint: Cast rays in 16.16 fixed point, as --fixed does.
+ * @gpuBatch: Batch walls and sprites, as --gpu does.
+ * @palette: Draw through the 8-bit palette, as --palette does, without
+ * fog and side shading.
+ * @lighting: Shade by the light grid, as --lighting does.
+ * @tolerance: Largest per-channel difference from the scalar frame that
+ * still counts as equal, or -1 for a scalar path.
+ * @permille: Pixels per thousand allowed over @tolerance.
+ */
+
+typedef struct RenderPath
+{
+	const char *name;
+	bool fixedPoint;
+	bool gpuBatch;
+	bool palette;
+	bool lighting;
+	int tolerance;
+	int permille;
+} RenderPath;
+
+/*
+ * The scalar paths, float rays drawn by the plain kernels with and
+ * without lighting, are checked against the images in the golden
+ * directory with --tolerance. Every other path is checked against the
+ * scalar frame of the same pose and lighting, rendered just before it:
+ * - fixed: 16.16 distances round differently from float ones, which can
+ *   move a wall end by a pixel or a column onto the next texel. Colours
+ *   are otherwise exact.
+ * - gpu: the renderer scales textured columns and sprites itself and may
+ *   pick the next texel row at a texel edge. Light becomes a colour
+ *   modulation, which rounds by up to 2.
+ * - palette: the nearest entry of the 6x6x6 cube is at most 25.5 away in
+ *   each channel, so the nearest palette entry is within
+ *   sqrt(3) * 25.5 = 44, plus 4 for the 15-bit inverse table. Lit, the 32
+ *   colormap bands add up to 255 / 32 = 8.
+ */
+static const RenderPath renderPaths[] = {
+	{"scalar", false, false, false, false, -1, 0},
+	{"fixed", true, false, false, false, 0, 20},
+	{"gpu", false, true, false, false, 2, 30},
+	{"palette", false, false, true, false, 48, 10},
+	{"lit", false, false, false, true, -1, 0},
+	{"lit_fixed", true, false, false, true, 0, 20},
+	{"lit_gpu", false, true, false, true, 2, 30},
+	{"lit_palette", false, false, true, true, 56, 10},
+};
+
+/* Seed of the enemies placed in every golden level */
+#define GOLDEN_SEED 1
+
+/*
+ * cast_views walks the grid with a DDA while castSingleRay intersects the
+ * grid lines, so distances differ by float rounding: at most 0.0004 pixels
+ * over the golden poses and 0.04 over random ones. That can move texX or
+ * a wall height across a rounding edge, but never the tile hit.
+ */
+#define PACKET_DISTANCE_TOLERANCE 0.05f
+#define PACKET_PIXEL_TOLERANCE 1
+
+/* Recording replayed by checkSimulationThread, created in the cwd */
+#define GOLDEN_REPLAY "golden_replay.tmp"
+
+/**
+ * struct ScriptStep - A run of ticks of the scripted session.
+ * @input: Input bits held for the run.
+ * @ticks: Length of the run.
+ */
+
+typedef struct ScriptStep
+{
+	Uint16 input;
+	int ticks;
+} ScriptStep;
+
+/*
+ * Walks, shoots and turns, and takes every path through which the
+ * simulation thread hands work to the render thread: a save and load and
+ * a tile edit.
+ */
+static const ScriptStep goldenScript[] = {
+	{INPUT_FORWARD, 30}, {INPUT_SAVE, 1}, {INPUT_TURN_RIGHT | INPUT_FIRE, 40},
+	{INPUT_FORWARD, 20}, {INPUT_EDIT, 1}, {INPUT_TURN_LEFT, 20},
+	{INPUT_LOAD, 1}, {INPUT_FORWARD | INPUT_LAUNCH, 30}
+};
+
+/* Hits of the two ray casters compared by checkPacketCaster */
+static RayHits scalarHits, packetHits;
+
+/*
+ * Odd angles are included on purpose: they put texture seams and the
+ * fisheye correction away from the axis-aligned cases.
+ */
+static const CameraPose goldenPoses[] = {
+	{false, 0}, {false, 45}, {false, 90}, {false, 137.5}, {false, 200},
+	{false, 300}, {true, 0}, {true, 90}, {true, 180}, {true, 270}
+};
+
+/**
+ * write_ppm - Writes an RGB24 frame as a binary PPM (P6) file.
+ * @path: Output file path.
+ * @pixels: Tightly packed RGB24 pixels.
+ * @width: Frame width.
+ * @height: Frame height.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int write_ppm(const char *path, const Uint8 *pixels, int width, int height)
+{
+	FILE *file = fopen(path, "wb");
+	size_t size = (size_t)width * height * 3;
+
+	if (!file)
+	{
+		fprintf(stderr, "Could not create %s\n", path);
+		return (1);
+	}
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	if (fwrite(pixels, 1, size, file) != size)
+	{
+		fprintf(stderr, "Could not write %s\n", path);
+		fclose(file);
+		return (1);
+	}
+	fclose(file);
+
+	return (0);
+}
+
+/**
+ * read_ppm - Reads a binary PPM (P6) file of a known size.
+ * @path: Input file path.
+ * @pixels: Buffer of width * height * 3 bytes that receives the pixels.
+ * @width: Expected width.
+ * @height: Expected height.
+ *
+ * Return: 0 on success, 1 if the file is missing or has another size.
+ */
+
+int read_ppm(const char *path, Uint8 *pixels, int width, int height)
+{
+	FILE *file = fopen(path, "rb");
+	int w, h, maxValue;
+	size_t size = (size_t)width * height * 3;
+
+	if (!file)
+	{
+		fprintf(stderr, "Could not open %s\n", path);
+		return (1);
+	}
+	if (fscanf(file, "P6 %d %d %d", &w, &h, &maxValue) != 3 ||
+			w != width || h != height || maxValue != 255 ||
+			fgetc(file) == EOF || fread(pixels, 1, size, file) != size)
+	{
+		fprintf(stderr, "%s is not a %dx%d PPM image\n", path, width, height);
+		fclose(file);
+		return (1);
+	}
+	fclose(file);
+
+	return (0);
+}
+
+/**
+ * compare_frames - Compares a frame against a reference.
+ * @actual: RGB24 pixels of the rendered frame.
+ * @expected: RGB24 pixels of the reference frame.
+ * @diff: Buffer of the same size that receives the diff image.
+ * @count: Number of pixels.
+ * @tolerance: Largest per-channel difference that still counts as equal.
+ *
+ * Mismatching pixels are red in the diff image, matching ones are a dimmed
+ * grey copy of the reference so the failure can be located at a glance.
+ *
+ * Return: The number of mismatching pixels.
+ */
+
+int compare_frames(const Uint8 *actual, const Uint8 *expected, Uint8 *diff,
+		int count, int tolerance)
+{
+	int i, c, mismatches = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		bool same = true;
+
+		for (c = 0; c < 3; c++)
+		{
+			if (abs(actual[i * 3 + c] - expected[i * 3 + c]) > tolerance)
+				same = false;
+		}
+		if (same)
+		{
+			Uint8 grey = (expected[i * 3] + expected[i * 3 + 1] +
+					expected[i * 3 + 2]) / 9;
+
+			diff[i * 3] = grey;
+			diff[i * 3 + 1] = grey;
+			diff[i * 3 + 2] = grey;
+		}
+		else
+		{
+			diff[i * 3] = 255;
+			diff[i * 3 + 1] = 0;
+			diff[i * 3 + 2] = 0;
+			mismatches++;
+		}
+	}
+
+	return (mismatches);
+}
+
+/**
+ * findTileCenter - Finds the centre of the first tile with a given id.
+ * @tile: Tile id to look for.
+ * @x: Receives the x-coordinate in world pixels, left as is if not found.
+ * @y: Receives the y-coordinate in world pixels, left as is if not found.
+ */
+
+static void findTileCenter(int tile, int *x, int *y)
+{
+	int row, col;
+
+	for (row = 0; row < mapHeight; row++)
+	{
+		for (col = 0; col < mapWidth; col++)
+		{
+			if (worldMap[row][col] == tile)
+			{
+				*x = col * TILE_SIZE + TILE_SIZE / 2;
+				*y = row * TILE_SIZE + TILE_SIZE / 2;
+				return;
+			}
+		}
+	}
+}
+
+/**
+ * reportFailure - Prints a failed frame and writes it and its diff image.
+ * @name: Pose name, e.g. level1_pose00.
+ * @path: Render path of the frame.
+ * @actual: The frame.
+ * @diff: Its diff image.
+ * @mismatches: Pixels over the tolerance.
+ * @allowed: Pixels allowed over the tolerance.
+ */
+
+static void reportFailure(const char *name, const RenderPath *path,
+		const Uint8 *actual, const Uint8 *diff, int mismatches, int allowed)
+{
+	char file[128];
+
+	printf("FAIL %s %s: %d pixels differ, %d allowed\n", name, path->name,
+			mismatches, allowed);
+	snprintf(file, sizeof(file), "%s_%s.actual.ppm", name, path->name);
+	write_ppm(file, actual, SCREEN_WIDTH, SCREEN_HEIGHT);
+	snprintf(file, sizeof(file), "%s_%s.diff.ppm", name, path->name);
+	write_ppm(file, diff, SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+/**
+ * placeCamera - Fills in the state of one camera pose of the loaded level.
+ * @state: Receives the pose.
+ * @level: Level number, from 1.
+ * @pose: Index into goldenPoses.
+ */
+
+static void placeCamera(GameState *state, int level, int pose)
+{
+	memset(state, 0, sizeof(*state));
+	state->level = level;
+	state->isMinimap = true;
+	state->degrees = goldenPoses[pose].degrees;
+	state->player.x = 80;
+	state->player.y = 80;
+	if (goldenPoses[pose].atExit)
+		findTileCenter(3, &state->player.x, &state->player.y);
+}
+
+/**
+ * readFrame - Draws a state and reads the frame back.
+ * @instance: Headless SDL_Instance, see init_headless_instance.
+ * @assets: Textures used by renderFrame.
+ * @state: The state to draw.
+ * @enemies: Its enemies, or NULL.
+ * @numEnemies: Number of entries of @enemies.
+ * @pixels: Receives the frame as RGB24.
+ */
+
+static void readFrame(SDL_Instance *instance, RenderAssets *assets,
+		const GameState *state, const Enemy *enemies, int numEnemies,
+		Uint8 *pixels)
+{
+	/* Each image shows only what its own pose explores */
+	clear_explored();
+	renderFrame(instance, state, enemies, numEnemies, assets);
+	SDL_RenderReadPixels(instance->renderer, NULL, SDL_PIXELFORMAT_RGB24,
+			pixels, SCREEN_WIDTH * 3);
+}
+
+/**
+ * renderPose - Renders one camera pose of the loaded level and reads it
+ * back.
+ * @instance: Headless SDL_Instance, see init_headless_instance.
+ * @assets: Textures used by renderFrame.
+ * @enemies: The level's enemies, 4 * @level of them.
+ * @level: Level number, from 1.
+ * @pose: Index into goldenPoses.
+ * @pixels: Receives the frame as RGB24.
+ */
+
+static void renderPose(SDL_Instance *instance, RenderAssets *assets,
+		const Enemy *enemies, int level, int pose, Uint8 *pixels)
+{
+	GameState state;
+
+	placeCamera(&state, level, pose);
+	readFrame(instance, assets, &state, enemies, 4 * level, pixels);
+}
+
+/**
+ * checkPacketCaster - Checks a full-screen cast_views against castRays.
+ * @name: Pose name, e.g. level1_pose00.
+ * @level: Level number, from 1.
+ * @pose: Index into goldenPoses.
+ *
+ * Every ray must hit the same tile on the same side; distances, texX and
+ * wall heights may differ by the PACKET_ tolerances.
+ *
+ * Return: 0 if every ray matches, 1 otherwise.
+ */
+
+static int checkPacketCaster(const char *name, int level, int pose)
+{
+	GameState state;
+	CameraView view = {worldMap, 0, 0, 0, {0, 0, NUM_RAYS, SCREEN_HEIGHT},
+		&packetHits};
+	const RayHits *a = &scalarHits, *b = &packetHits;
+	int ray, texX;
+
+	placeCamera(&state, level, pose);
+	castRays(state.player.x, state.player.y, state.degrees, &scalarHits);
+	view.x = state.player.x;
+	view.y = state.player.y;
+	view.rotation = state.degrees;
+	cast_views(&view, 1);
+
+	for (ray = 0; ray < NUM_RAYS; ray++)
+	{
+		texX = abs(a->texX[ray] - b->texX[ray]);
+		if (a->tile[ray] == b->tile[ray] && (a->tile[ray] == 0 ||
+					(a->tileX[ray] == b->tileX[ray] &&
+					 a->tileY[ray] == b->tileY[ray] &&
+					 a->verticalRay[ray] == b->verticalRay[ray] &&
+					 fabsf(a->distance[ray] - b->distance[ray]) <=
+					 PACKET_DISTANCE_TOLERANCE &&
+					 abs(a->wallHeight[ray] - b->wallHeight[ray]) <=
+					 PACKET_PIXEL_TOLERANCE &&
+					 /* texX wraps from TILE_SIZE - 1 to 0 */
+					 (texX <= PACKET_PIXEL_TOLERANCE ||
+					  texX >= TILE_SIZE - PACKET_PIXEL_TOLERANCE))))
+			continue;
+
+		printf("FAIL %s cast_views: ray %d hit tile %d at (%d, %d) %.3f "
+				"away, castRays tile %d at (%d, %d) %.3f away\n", name, ray,
+				b->tile[ray], b->tileX[ray], b->tileY[ray], b->distance[ray],
+				a->tile[ray], a->tileX[ray], a->tileY[ray], a->distance[ray]);
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * writeScript - Records goldenScript to GOLDEN_REPLAY.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int writeScript(void)
+{
+	int numSteps = sizeof(goldenScript) / sizeof(goldenScript[0]);
+	Recording recording;
+	int step, tick;
+
+	if (start_recording(&recording, GOLDEN_REPLAY, GOLDEN_SEED, 1, 0) != 0)
+		return (1);
+	for (step = 0; step < numSteps; step++)
+	{
+		for (tick = 0; tick < goldenScript[step].ticks; tick++)
+			record_input(&recording, goldenScript[step].input);
+	}
+	return (stop_recording(&recording));
+}
+
+/**
+ * playScript - Plays GOLDEN_REPLAY back and draws its last snapshot.
+ * @instance: Headless SDL_Instance, see init_headless_instance.
+ * @levelManager: Pointer to the LevelManager holding every level.
+ * @assets: Textures used by renderFrame.
+ * @threaded: Run the ticks on the simulation thread, serving its level
+ * changes and tile edits as the game's render loop does, rather than in
+ * lockstep.
+ * @state: Receives the state of the last snapshot.
+ * @pixels: Receives the frame as RGB24.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int playScript(SDL_Instance *instance, LevelManager *levelManager,
+		RenderAssets *assets, bool threaded, GameState *state,
+		Uint8 *pixels)
+{
+	Simulation sim;
+	Recording recording;
+	const Snapshot *snapshot;
+	int status = 0;
+
+	if (open_replay(&recording, GOLDEN_REPLAY) != 0)
+		return (1);
+	memset(&sim, 0, sizeof(sim));
+	sim.state.player.x = 80;
+	sim.state.player.y = 80;
+	sim.state.player.w = assets->mini.width;
+	sim.state.player.h = assets->mini.height;
+	sim.state.isMinimap = true;
+	sim.state.level = recording.level;
+	seed_rng(&sim.state.rng, recording.seed);
+	levelManager->current_Level = recording.level - 1;
+	loadCurrentLevel(levelManager);
+	if (load_enemies(sim.enemies, sim.state.level, instance,
+				&sim.state.rng) != 0)
+	{
+		close_replay(&recording);
+		return (1);
+	}
+	sim.levelManager = levelManager;
+	sim.instance = instance;
+	sim.recording = &recording;
+	sim.replaying = true;
+	sim.speed = 200;
+
+	if (init_simulation(&sim) != 0)
+		status = -1;
+	else if (threaded && start_simulation(&sim) == 0)
+	{
+		while (SDL_AtomicGet(&sim.running))
+		{
+			service_level_change(&sim);
+			SDL_Delay(1);
+		}
+		stop_simulation(&sim);
+		status = sim.status;
+	}
+	else if (threaded)
+		status = -1;
+	else
+	{
+		while (status == 0)
+			status = step_simulation(&sim);
+	}
+
+	if (status >= 0)
+	{
+		snapshot = latest_snapshot(&sim.snapshots);
+		*state = snapshot->state;
+		readFrame(instance, assets, &snapshot->state, snapshot->enemies,
+				snapshot->numEnemies, pixels);
+	}
+	free_simulation(&sim);
+	free_enemies(sim.enemies, 4 * sim.state.level);
+	close_replay(&recording);
+
+	return (status < 0);
+}
+
+/**
+ * checkSimulationThread - Checks the threaded simulation against
+ * lockstep ticks.
+ * @instance: Headless SDL_Instance, see init_headless_instance.
+ * @levelManager: Pointer to the LevelManager holding every level.
+ * @assets: Textures used by renderFrame.
+ * @expected: Scratch buffer for the lockstep frame.
+ * @actual: Scratch buffer for the threaded frame.
+ * @diff: Scratch buffer for the diff image.
+ *
+ * goldenScript is replayed both ways; the last ticks must agree and draw
+ * the same frame, pixel for pixel.
+ *
+ * Return: 0 if they match, 1 otherwise.
+ */
+
+static int checkSimulationThread(SDL_Instance *instance,
+		LevelManager *levelManager, RenderAssets *assets, Uint8 *expected,
+		Uint8 *actual, Uint8 *diff)
+{
+	static const RenderPath path = {"thread", false, false, false, false,
+		0, 0};
+	GameState lockstep, threaded;
+	int mismatches, status;
+
+	status = writeScript() || playScript(instance, levelManager, assets,
+			false, &lockstep, expected) || playScript(instance, levelManager,
+			assets, true, &threaded, actual);
+	remove(GOLDEN_REPLAY);
+	if (status != 0)
+	{
+		printf("FAIL simulation: could not play the script\n");
+		return (1);
+	}
+	if (lockstep.tick != threaded.tick ||
+			lockstep.player.x != threaded.player.x ||
+			lockstep.player.y != threaded.player.y ||
+			lockstep.degrees != threaded.degrees)
+	{
+		printf("FAIL simulation thread: tick %u at (%d, %d) %.2f degrees, "
+				"lockstep tick %u at (%d, %d) %.2f degrees\n",
+				(unsigned int)threaded.tick, threaded.player.x,
+				threaded.player.y, threaded.degrees,
+				(unsigned int)lockstep.tick, lockstep.player.x,
+				lockstep.player.y, lockstep.degrees);
+		return (1);
+	}
+
+	mismatches = compare_frames(actual, expected, diff,
+			SCREEN_WIDTH * SCREEN_HEIGHT, 0);
+	if (mismatches == 0)
+		return (0);
+	reportFailure("simulation", &path, actual, diff, mismatches, 0);
+	return (1);
+}
+
+/**
+ * selectRenderPath - Sets the render mode flags of a path.
+ * @path: The path.
+ * @level: Level number, from 1, whose kernels are picked.
+ */
+
+static void selectRenderPath(const RenderPath *path, int level)
+{
+	fixedPointMode = path->fixedPoint;
+	gpuBatchMode = path->gpuBatch;
+	paletteMode = path->palette;
+	paletteShading = !path->palette;
+	lightingMode = path->lighting;
+	select_render_kernels(level);
+}
+
+/**
+ * checkReference - Writes a scalar frame or checks it against its image.
+ * @directory: Directory holding the reference images.
+ * @name: Pose name, e.g. level1_pose00.
+ * @path: The scalar path the frame was drawn with.
+ * @compare: false to write the image, true to compare against it.
+ * @tolerance: Per-channel tolerance used when comparing.
+ * @frame: The frame.
+ * @expected: Scratch buffer for the reference image.
+ * @diff: Scratch buffer for the diff image.
+ *
+ * Lit frames are stored as <name>_lit.ppm, unlit ones as <name>.ppm.
+ *
+ * Return: 0 if the frame was written or matched, 1 otherwise.
+ */
+
+static int checkReference(const char *directory, const char *name,
+		const RenderPath *path, bool compare, int tolerance,
+		const Uint8 *frame, Uint8 *expected, Uint8 *diff)
+{
+	int count = SCREEN_WIDTH * SCREEN_HEIGHT, mismatches = count;
+	char file[4096];
+
+	snprintf(file, sizeof(file), "%s/%s%s.ppm", directory, name,
+			path->lighting ? "_lit" : "");
+	if (!compare)
+		return (write_ppm(file, frame, SCREEN_WIDTH, SCREEN_HEIGHT));
+
+	if (read_ppm(file, expected, SCREEN_WIDTH, SCREEN_HEIGHT) == 0)
+		mismatches = compare_frames(frame, expected, diff, count, tolerance);
+	else
+		memset(diff, 255, count * 3);
+	if (mismatches == 0)
+		return (0);
+
+	reportFailure(name, path, frame, diff, mismatches, 0);
+	return (1);
+}
+
+/**
+ * hasReferences - Tells whether a directory holds golden images.
+ * @directory: The directory.
+ *
+ * Return: true if the first reference image can be read.
+ */
+
+static bool hasReferences(const char *directory)
+{
+	char file[4096];
+	FILE *stream;
+
+	snprintf(file, sizeof(file), "%s/level1_pose00.ppm", directory);
+	stream = fopen(file, "rb");
+	if (!stream)
+		return (false);
+	fclose(stream);
+	return (true);
+}
+
+/**
+ * run_golden - Renders every camera pose of every level offscreen and
+ * either writes the frames or checks them against reference frames.
+ * @instance: Headless SDL_Instance, see init_headless_instance.
+ * @levelManager: Pointer to the LevelManager holding every level.
+ * @assets: Textures used by renderFrame; quantized for the palette when
+ * comparing.
+ * @directory: Directory holding the reference frames.
+ * @compare: false to write references, true to compare against them.
+ * @tolerance: Per-channel tolerance used when comparing.
+ *
+ * Each level's enemies are spawned from GOLDEN_SEED, so the sprites,
+ * and with the GPU path the sprite batch, are checked too. Only the
+ * scalar paths are written. A compare also draws every other
+ * path of renderPaths and checks it against the scalar frame, whatever
+ * render flags were given, checks the packet caster against castRays at
+ * every pose and the simulation thread against lockstep ticks. On a
+ * mismatch the rendered frame and a diff image are written to the current
+ * directory as <name>_<path>.actual.ppm and <name>_<path>.diff.ppm.
+ *
+ * Return: The number of failed frames and checks, 1 if there are no
+ * references to compare against, or -1 if a buffer cannot be allocated.
+ */
+
+int run_golden(SDL_Instance *instance, LevelManager *levelManager,
+		RenderAssets *assets, const char *directory, bool compare,
+		int tolerance)
+{
+	int count = SCREEN_WIDTH * SCREEN_HEIGHT, failures = 0, frames = 0;
+	int numPoses = sizeof(goldenPoses) / sizeof(goldenPoses[0]);
+	int numPaths = sizeof(renderPaths) / sizeof(renderPaths[0]);
+	int level, pose, i, mismatches, allowed;
+	Uint8 *reference = mem_alloc(MEM_RENDER, count * 3);
+	Uint8 *actual = mem_alloc(MEM_RENDER, count * 3);
+	Uint8 *expected = mem_alloc(MEM_RENDER, count * 3);
+	Uint8 *diff = mem_alloc(MEM_RENDER, count * 3);
+	Enemy enemies[MAX_ENEMIES];
+	Uint64 rng;
+	RenderPath flags = {"flags", fixedPointMode, gpuBatchMode, paletteMode,
+		lightingMode, -1, 0};
+	char name[64];
+
+	if (compare && !hasReferences(directory))
+	{
+		fprintf(stderr, "No golden images in %s, run make goldens first\n",
+				directory);
+		return (1);
+	}
+	if (!reference || !actual || !expected || !diff)
+	{
+		fprintf(stderr, "Could not allocate golden image buffers\n");
+		mem_free(reference);
+		mem_free(actual);
+		mem_free(expected);
+		mem_free(diff);
+		return (-1);
+	}
+
+	for (level = 0; level < 6; level++)
+	{
+		levelManager->current_Level = level;
+		loadCurrentLevel(levelManager);
+		seed_rng(&rng, GOLDEN_SEED);
+		memset(enemies, 0, sizeof(enemies));
+		if (load_enemies(enemies, level + 1, instance, &rng) != 0)
+		{
+			free_enemies(enemies, 4 * (level + 1));
+			failures++;
+			continue;
+		}
+
+		for (pose = 0; pose < numPoses; pose++)
+		{
+			snprintf(name, sizeof(name), "level%d_pose%02d", level + 1, pose);
+			for (i = 0; i < numPaths; i++)
+			{
+				const RenderPath *path = &renderPaths[i];
+
+				if (path->tolerance < 0)
+				{
+					selectRenderPath(path, level + 1);
+					renderPose(instance, assets, enemies, level + 1, pose,
+							reference);
+					failures += checkReference(directory, name, path, compare,
+							tolerance, reference, expected, diff);
+					frames++;
+					continue;
+				}
+				if (!compare)
+					continue;
+
+				selectRenderPath(path, level + 1);
+				renderPose(instance, assets, enemies, level + 1, pose,
+						actual);
+				mismatches = compare_frames(actual, reference, diff, count,
+						path->tolerance);
+				allowed = (int)((Sint64)count * path->permille / 1000);
+				if (mismatches > allowed)
+				{
+					reportFailure(name, path, actual, diff, mismatches,
+							allowed);
+					failures++;
+				}
+				frames++;
+			}
+			if (compare)
+			{
+				selectRenderPath(&renderPaths[0], level + 1);
+				failures += checkPacketCaster(name, level + 1, pose);
+				frames++;
+			}
+		}
+		free_enemies(enemies, 4 * (level + 1));
+	}
+
+	if (compare)
+	{
+		selectRenderPath(&renderPaths[0], 1);
+		failures += checkSimulationThread(instance, levelManager, assets,
+				expected, actual, diff);
+		frames++;
+	}
+
+	selectRenderPath(&flags, levelManager->current_Level + 1);
+	paletteShading = true;
+	printf("%s %d frames, %d failed\n", compare ? "Compared" : "Wrote",
+			frames, failures);
+	mem_free(reference);
+	mem_free(actual);
+	mem_free(expected);
+	mem_free(diff);
+
+	return (failures);
+}
@@ -0,0 +1,220 @@
+#include "../headers/mazemania.h"
+
+/**
+ * gpuBatchMode - True when walls and sprites are collected into batches
+ * and drawn by the GPU with a handful of calls per frame.
+ */
+bool gpuBatchMode;
+
+/* Flat wall slices, one rectangle list per side colour */
+static SDL_Rect flatRects[2][SCREEN_WIDTH];
+static int flatCount[2];
+
+/* Lit flat wall slices, one untextured quad per column in its own colour */
+static SDL_Vertex litVertices[SCREEN_WIDTH * 4];
+static int litIndices[SCREEN_WIDTH * 6];
+static int litCount;
+
+/* Textured wall columns, one quad per column, all from one texture */
+static SDL_Vertex wallVertices[SCREEN_WIDTH * 4];
+static int wallIndices[SCREEN_WIDTH * 6];
+static int wallCount;
+static SDL_Texture *wallBatchTexture;
+
+/* Enemy sprites, one quad each, in submission order */
+static SDL_Vertex spriteVertices[MAX_ENEMIES * 4];
+static int spriteIndices[MAX_ENEMIES * 6];
+static SDL_Texture *spriteTextures[MAX_ENEMIES];
+static int spriteCount;
+
+/**
+ * setQuad - Fills the four vertices and six indices of a textured quad.
+ * @vertices: Receives the vertices.
+ * @indices: Receives the indices of the two triangles.
+ * @first: Index of the quad's first vertex in the whole vertex array.
+ * @rect: Screen rectangle, left, top, right and bottom.
+ * @uv: Texture rectangle, left, top, right and bottom.
+ * @color: Vertex colour, which SDL multiplies the texels by.
+ */
+
+static void setQuad(SDL_Vertex *vertices, int *indices, int first,
+		const float rect[4], const float uv[4], SDL_Color color)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		vertices[i].position.x = rect[(i == 1 || i == 2) ? 2 : 0];
+		vertices[i].position.y = rect[i >= 2 ? 3 : 1];
+		vertices[i].tex_coord.x = uv[(i == 1 || i == 2) ? 2 : 0];
+		vertices[i].tex_coord.y = uv[i >= 2 ? 3 : 1];
+		vertices[i].color = color;
+	}
+	indices[0] = first;
+	indices[1] = first + 1;
+	indices[2] = first + 2;
+	indices[3] = first;
+	indices[4] = first + 2;
+	indices[5] = first + 3;
+}
+
+/**
+ * batchWallSlice - Batched counterpart of drawWallSlice.
+ * @rayIndex: The index of the ray corresponding to the column being drawn.
+ * @wallHeight: The calculated height of the wall slice.
+ * @horizontalRay: Flag indicating if the hit was on a horizontal surface.
+ * @verticalRay: Flag indicating if the hit was on a vertical surface.
+ * @light: Light level of the wall face.
+ *
+ * The slice becomes a one pixel wide rectangle covering the same pixels as
+ * drawWallSlice's line, in the list for its side colour. A slice below
+ * LIGHT_FULL has a colour of its own, so it becomes an untextured quad of
+ * that colour instead.
+ */
+
+void batchWallSlice(int rayIndex, int wallHeight, int horizontalRay,
+		int verticalRay, int light)
+{
+	int wallTop = (SCREEN_HEIGHT / 2) - (wallHeight / 2);
+	int wallBottom = (SCREEN_HEIGHT / 2) + (wallHeight / 2);
+	int side = horizontalRay ? 0 : 1;
+	const Uint8 *ramp = light_ramp(light);
+	float quad[4], uv[4] = {0, 0, 0, 0};
+	SDL_Color color = {ramp[side ? 255 : 64], ramp[side ? 253 : 64],
+		ramp[side ? 208 : 64], 255};
+	SDL_Rect *rect;
+
+	if (!horizontalRay && !verticalRay)
+		return;
+
+	if (light != LIGHT_FULL)
+	{
+		quad[0] = rayIndex;
+		quad[1] = wallTop;
+		quad[2] = rayIndex + 1;
+		quad[3] = wallBottom + 1;
+		setQuad(&litVertices[litCount * 4], &litIndices[litCount * 6],
+				litCount * 4, quad, uv, color);
+		litCount++;
+		return;
+	}
+
+	rect = &flatRects[side][flatCount[side]++];
+	rect->x = rayIndex;
+	rect->y = wallTop;
+	rect->w = 1;
+	rect->h = wallBottom - wallTop + 1;
+}
+
+/**
+ * batchWallTexture - Batched counterpart of drawWallTexture.
+ * @renderer: Renderer used to flush the batch if the texture changes.
+ * @rayIndex: The index of the ray corresponding to the wall slice.
+ * @wallHeight: The height of the wall slice to be drawn.
+ * @texture: Pointer to the wallTexture structure containing texture data.
+ * @texX: The texture column to draw.
+ * @light: Light level of the wall face, passed as the vertex colour.
+ *
+ * The column becomes a one pixel wide quad whose texture coordinates span
+ * the middle of a single texel column, so the GPU does the vertical scaling
+ * and clipping that drawWallTexture does point by point.
+ */
+
+void batchWallTexture(SDL_Renderer *renderer, int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, int light)
+{
+	Uint8 level = light_ramp(light)[255];
+	SDL_Color color = {level, level, level, 255};
+	float rect[4], uv[4];
+
+	if (wallBatchTexture && wallBatchTexture != texture->texture)
+		flushGpuBatches(renderer);
+	wallBatchTexture = texture->texture;
+
+	rect[0] = rayIndex;
+	rect[1] = (SCREEN_HEIGHT / 2) - (wallHeight / 2);
+	rect[2] = rayIndex + 1;
+	rect[3] = rect[1] + wallHeight;
+	uv[0] = (texX + 0.5f) / texture->width;
+	uv[1] = 0;
+	uv[2] = uv[0];
+	uv[3] = 1;
+	setQuad(&wallVertices[wallCount * 4], &wallIndices[wallCount * 6],
+			wallCount * 4, rect, uv, color);
+	wallCount++;
+}
+
+/**
+ * batchSprite - Queues an enemy sprite for the batched sprite pass.
+ * @texture: The sprite's texture.
+ * @rect: Screen rectangle of the sprite.
+ */
+
+void batchSprite(SDL_Texture *texture, const SDL_Rect *rect)
+{
+	SDL_Color white = {255, 255, 255, 255};
+	float quad[4], uv[4] = {0, 0, 1, 1};
+
+	if (spriteCount == MAX_ENEMIES)
+		return;
+
+	quad[0] = rect->x;
+	quad[1] = rect->y;
+	quad[2] = rect->x + rect->w;
+	quad[3] = rect->y + rect->h;
+	setQuad(&spriteVertices[spriteCount * 4], &spriteIndices[spriteCount * 6],
+			spriteCount * 4, quad, uv, white);
+	spriteTextures[spriteCount++] = texture;
+}
+
+/**
+ * flushGpuBatches - Draws and empties every batch.
+ * @renderer: Renderer to draw with.
+ *
+ * Walls go first: both flat colours as one SDL_RenderFillRects each, lit
+ * flat slices and all textured columns as one SDL_RenderGeometry call
+ * each. Sprites follow as one
+ * SDL_RenderGeometry call per run of sprites that share a texture; a
+ * level's enemies share one, see load_enemies, so they take one call.
+ */
+
+void flushGpuBatches(SDL_Renderer *renderer)
+{
+	int first = 0, last;
+
+	if (flatCount[0] > 0)
+	{
+		SDL_SetRenderDrawColor(renderer, 64, 64, 64, 255);
+		SDL_RenderFillRects(renderer, flatRects[0], flatCount[0]);
+	}
+	if (flatCount[1] > 0)
+	{
+		SDL_SetRenderDrawColor(renderer, 255, 253, 208, 255);
+		SDL_RenderFillRects(renderer, flatRects[1], flatCount[1]);
+	}
+	if (litCount > 0)
+		SDL_RenderGeometry(renderer, NULL, litVertices, litCount * 4,
+				litIndices, litCount * 6);
+	if (wallCount > 0)
+		SDL_RenderGeometry(renderer, wallBatchTexture, wallVertices,
+				wallCount * 4, wallIndices, wallCount * 6);
+
+	while (first < spriteCount)
+	{
+		last = first + 1;
+		while (last < spriteCount &&
+				spriteTextures[last] == spriteTextures[first])
+			last++;
+		SDL_RenderGeometry(renderer, spriteTextures[first], spriteVertices,
+				spriteCount * 4, &spriteIndices[first * 6],
+				(last - first) * 6);
+		first = last;
+	}
+
+	flatCount[0] = 0;
+	flatCount[1] = 0;
+	litCount = 0;
+	wallCount = 0;
+	wallBatchTexture = NULL;
+	spriteCount = 0;
+}
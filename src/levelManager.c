@@ -16,9 +16,10 @@ int init_LevelManager(LevelManager *levelManager)
 	int i;
 
 	levelManager->current_Level = 0;
+	levelManager->onLoad = NULL;
 
 	/* Allocate memory for 6 levels */
-	levelManager->worldMap = malloc(6 * sizeof(int *));
+	levelManager->worldMap = mem_alloc(MEM_LEVELS, 6 * sizeof(int *));
 	if (levelManager->worldMap == NULL)
 	{
 		fprintf(stderr, "Failed to allocate memory for worldMap\n");
@@ -26,7 +27,8 @@ int init_LevelManager(LevelManager *levelManager)
 	}
 	for (i = 0; i < 6; ++i)
 	{
-		levelManager->worldMap[i] = malloc(mapHeight * mapWidth * sizeof(int));
+		levelManager->worldMap[i] = mem_alloc(MEM_LEVELS,
+				mapHeight * mapWidth * sizeof(int));
 
 		if (levelManager->worldMap[i] == NULL)
 		{
@@ -70,6 +72,73 @@ int *getWorldMap(int index)
 	}
 }
 
+/**
+ * struct LevelTarget - Destination of a maze generated into a level.
+ * @map: The level map, mapHeight * mapWidth tiles.
+ * @spawns: Number of spawn tiles written so far.
+ */
+
+typedef struct LevelTarget
+{
+	int *map;
+	int spawns;
+} LevelTarget;
+
+/**
+ * copyLevelRow - Copies a generated tile row into a level map.
+ * @row: Tile row.
+ * @width: Number of tiles, always mapWidth here.
+ * @y: Tile row index.
+ * @context: Pointer to the LevelTarget.
+ */
+
+static void copyLevelRow(const int *row, int width, int y, void *context)
+{
+	LevelTarget *target = context;
+	int x;
+
+	for (x = 0; x < width; x++)
+	{
+		target->map[y * mapWidth + x] = row[x];
+		if (row[x] == 4)
+			target->spawns++;
+	}
+}
+
+/**
+ * generate_levels - Replaces every level with a generated maze.
+ * @levelManager: Pointer to an initialized LevelManager.
+ * @seed: Seed of the session; the same seed always gives the same levels.
+ *
+ * Each level must hold the 4 * level enemies load_enemies places, so a maze
+ * with too few spawn tiles is regenerated from the next seed.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int generate_levels(LevelManager *levelManager, Uint64 seed)
+{
+	MazeParams params;
+	LevelTarget target;
+	int i;
+
+	params.width = mapWidth;
+	params.height = mapHeight;
+	params.spawnPercent = 70;
+	params.seed = seed;
+	for (i = 0; i < 6; ++i)
+	{
+		target.map = levelManager->worldMap[i];
+		do {
+			target.spawns = 0;
+			params.seed++;
+			if (generate_maze(&params, 1, copyLevelRow, &target) != 0)
+				return (1);
+		} while (target.spawns < 4 * (i + 1));
+	}
+
+	return (0);
+}
 
 /**
  * free_LevelManager - Frees the memory allocated for the LevelManager
@@ -85,9 +154,9 @@ void free_LevelManager(LevelManager *levelManager)
 
 	for (i = 0; i < 6; ++i)
 	{
-		free(levelManager->worldMap[i]);
+		mem_free(levelManager->worldMap[i]);
 	}
-	free(levelManager->worldMap);
+	mem_free(levelManager->worldMap);
 }
 
 /**
@@ -96,11 +165,32 @@ void free_LevelManager(LevelManager *levelManager)
  * @levelManager: Pointer to the LevelManager structure containing world maps.
  *
  * This function loads the world map of the current level from the LevelManager
- * structure into the main world map.
+ * structure into the main world map, forgets the explored tiles and
+ * rebuilds the tile visibility sets and the light grid for it, then runs
+ * the manager's onLoad hook.
  */
 
 void loadCurrentLevel(LevelManager *levelManager)
 {
 	memcpy(worldMap, levelManager->worldMap[levelManager->current_Level],
 			sizeof(worldMap));
+	clear_tile_changes();
+	clear_explored();
+	build_visibility();
+	bake_lighting();
+	if (levelManager->onLoad)
+		levelManager->onLoad(levelManager->current_Level + 1);
+}
+
+/**
+ * atLevelExit - Tells whether the player stands on the exit tile.
+ * @state: Pointer to the GameState.
+ *
+ * Return: true on the exit tile.
+ */
+
+bool atLevelExit(const GameState *state)
+{
+	return (worldMap[state->player.y / TILE_SIZE]
+			[state->player.x / TILE_SIZE] == 3);
 }
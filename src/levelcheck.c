@@ -0,0 +1,289 @@
+#include "../headers/mazemania.h"
+
+/**
+ * init_level_grid - Allocates an empty level grid.
+ * @grid: Pointer to the LevelGrid to initialize.
+ * @width: Width in tiles.
+ * @height: Height in tiles.
+ *
+ * Every tile starts out as a wall; see set_level_tile.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int init_level_grid(LevelGrid *grid, int width, int height)
+{
+	size_t words;
+
+	grid->width = width;
+	grid->height = height;
+	grid->stride = (width + 63) / 64;
+	grid->exitX = -1;
+	grid->exitY = -1;
+	grid->exits = 0;
+	words = (size_t)grid->stride * (height > 0 ? height : 1);
+	grid->open = calloc(words, sizeof(Uint64));
+	grid->spawns = calloc(words, sizeof(Uint64));
+	if (!grid->open || !grid->spawns)
+	{
+		fprintf(stderr, "Failed to allocate a %dx%d level grid\n", width,
+				height);
+		free_level_grid(grid);
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * free_level_grid - Frees the bitsets of a level grid.
+ * @grid: Pointer to the LevelGrid.
+ */
+
+void free_level_grid(LevelGrid *grid)
+{
+	free(grid->open);
+	free(grid->spawns);
+	grid->open = NULL;
+	grid->spawns = NULL;
+}
+
+/**
+ * set_level_tile - Records one tile of a level in its grid.
+ * @grid: Pointer to the LevelGrid.
+ * @x: Column.
+ * @y: Row.
+ * @tile: Tile id as used in worlds.txt.
+ *
+ * Border (1) and inner (2) walls block the player; everything else is
+ * walkable. The first exit tile found is the one paths are measured to.
+ */
+
+void set_level_tile(LevelGrid *grid, int x, int y, int tile)
+{
+	size_t word = (size_t)y * grid->stride + x / 64;
+	Uint64 bit = (Uint64)1 << (x % 64);
+
+	if (tile == 1 || tile == 2)
+		return;
+
+	grid->open[word] |= bit;
+	if (tile == 4)
+		grid->spawns[word] |= bit;
+	if (tile == 3)
+	{
+		if (grid->exits++ == 0)
+		{
+			grid->exitX = x;
+			grid->exitY = y;
+		}
+	}
+}
+
+/**
+ * countBits - Counts the set bits of a bitset, optionally masked.
+ * @bits: The bitset.
+ * @mask: Bitset to AND with, or NULL.
+ * @words: Number of words.
+ *
+ * Return: The number of set bits.
+ */
+
+static long countBits(const Uint64 *bits, const Uint64 *mask, size_t words)
+{
+	long count = 0;
+	size_t i;
+
+	for (i = 0; i < words; i++)
+		count += __builtin_popcountll(mask ? bits[i] & mask[i] : bits[i]);
+	return (count);
+}
+
+/**
+ * expandRow - Computes the next BFS frontier for one row.
+ * @grid: The level grid.
+ * @frontier: Current frontier.
+ * @visited: Tiles reached so far.
+ * @next: Receives the row of the next frontier.
+ * @y: Row to compute.
+ *
+ * A tile joins the frontier if it is open, not yet visited and next to a
+ * frontier tile. Shifting a row left and right by one bit, with the carry
+ * between words, covers the horizontal neighbours of 64 tiles at once.
+ *
+ * Return: true if the row of the next frontier is not empty.
+ */
+
+static bool expandRow(const LevelGrid *grid, const Uint64 *frontier,
+		const Uint64 *visited, Uint64 *next, int y)
+{
+	const Uint64 *row = frontier + (size_t)y * grid->stride;
+	size_t base = (size_t)y * grid->stride;
+	Uint64 any = 0, word;
+	int i;
+
+	for (i = 0; i < grid->stride; i++)
+	{
+		word = row[i] | (row[i] << 1) | (row[i] >> 1);
+		if (i > 0)
+			word |= row[i - 1] >> 63;
+		if (i + 1 < grid->stride)
+			word |= row[i + 1] << 63;
+		if (y > 0)
+			word |= row[i - grid->stride];
+		if (y + 1 < grid->height)
+			word |= row[i + grid->stride];
+		word &= grid->open[base + i] & ~visited[base + i];
+		next[base + i] = word;
+		any |= word;
+	}
+
+	return (any != 0);
+}
+
+/**
+ * isOpen - Tests a tile of a level grid.
+ * @grid: The level grid.
+ * @x: Column, may be outside the grid.
+ * @y: Row, may be outside the grid.
+ *
+ * Return: true if the tile is inside the grid and walkable.
+ */
+
+static bool isOpen(const LevelGrid *grid, int x, int y)
+{
+	if (x < 0 || x >= grid->width || y < 0 || y >= grid->height)
+		return (false);
+	return ((grid->open[(size_t)y * grid->stride + x / 64] >> (x % 64)) & 1);
+}
+
+/**
+ * countDeadEnds - Counts reachable tiles with exactly one open neighbour.
+ * @grid: The level grid.
+ * @visited: Tiles reachable from the start.
+ *
+ * Return: The number of dead ends.
+ */
+
+static long countDeadEnds(const LevelGrid *grid, const Uint64 *visited)
+{
+	long deadEnds = 0;
+	int x, y, i;
+	Uint64 word;
+
+	for (y = 0; y < grid->height; y++)
+	{
+		for (i = 0; i < grid->stride; i++)
+		{
+			word = visited[(size_t)y * grid->stride + i];
+			while (word)
+			{
+				x = i * 64 + __builtin_ctzll(word);
+				word &= word - 1;
+				if (isOpen(grid, x - 1, y) + isOpen(grid, x + 1, y) +
+						isOpen(grid, x, y - 1) + isOpen(grid, x, y + 1) == 1)
+					deadEnds++;
+			}
+		}
+	}
+
+	return (deadEnds);
+}
+
+/**
+ * check_level - Runs a breadth-first search from the start tile and
+ * gathers the level's statistics.
+ * @grid: The level grid.
+ * @startX: Column of the start tile.
+ * @startY: Row of the start tile.
+ * @stats: Receives the statistics.
+ *
+ * The search advances a whole frontier per step using bitset operations,
+ * and only touches the rows between the highest and lowest frontier tile,
+ * so each step costs a few word operations per 64 tiles.
+ *
+ * Return: 0 on success, 1 if the search buffers cannot be allocated.
+ */
+
+int check_level(const LevelGrid *grid, int startX, int startY,
+		LevelStats *stats)
+{
+	size_t words = (size_t)grid->stride * grid->height;
+	Uint64 *visited = calloc(words, sizeof(Uint64));
+	Uint64 *frontier = calloc(words, sizeof(Uint64));
+	Uint64 *next = calloc(words, sizeof(Uint64)), *swap;
+	int low = startY, high = startY, newLow, newHigh, y;
+	long depth = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->pathLength = -1;
+	if (!visited || !frontier || !next)
+	{
+		fprintf(stderr, "Failed to allocate the search buffers\n");
+		free(visited);
+		free(frontier);
+		free(next);
+		return (1);
+	}
+
+	stats->startOpen = isOpen(grid, startX, startY);
+	if (stats->startOpen)
+	{
+		frontier[(size_t)startY * grid->stride + startX / 64] =
+			(Uint64)1 << (startX % 64);
+		visited[(size_t)startY * grid->stride + startX / 64] =
+			frontier[(size_t)startY * grid->stride + startX / 64];
+	}
+
+	while (stats->startOpen && low <= high)
+	{
+		if (grid->exits > 0 && stats->pathLength < 0 &&
+				grid->exitY >= low && grid->exitY <= high &&
+				((frontier[(size_t)grid->exitY * grid->stride +
+				 grid->exitX / 64] >> (grid->exitX % 64)) & 1))
+			stats->pathLength = depth;
+
+		newLow = grid->height;
+		newHigh = -1;
+		for (y = (low > 0 ? low - 1 : 0);
+				y <= high + 1 && y < grid->height; y++)
+		{
+			if (expandRow(grid, frontier, visited, next, y))
+			{
+				newLow = y < newLow ? y : newLow;
+				newHigh = y;
+			}
+		}
+		for (y = (low > 0 ? low - 1 : 0);
+				y <= high + 1 && y < grid->height; y++)
+		{
+			size_t i, base = (size_t)y * grid->stride;
+
+			for (i = 0; i < (size_t)grid->stride; i++)
+			{
+				visited[base + i] |= next[base + i];
+				frontier[base + i] = 0;
+			}
+		}
+
+		swap = frontier;
+		frontier = next;
+		next = swap;
+		low = newLow;
+		high = newHigh;
+		depth++;
+	}
+
+	stats->exitReachable = stats->pathLength >= 0;
+	stats->openArea = countBits(grid->open, NULL, words);
+	stats->reachableArea = countBits(visited, NULL, words);
+	stats->spawns = countBits(grid->spawns, NULL, words);
+	stats->reachableSpawns = countBits(grid->spawns, visited, words);
+	stats->deadEnds = countDeadEnds(grid, visited);
+
+	free(visited);
+	free(frontier);
+	free(next);
+
+	return (0);
+}
@@ -0,0 +1,364 @@
+#include "../headers/mazemania.h"
+
+/**
+ * struct CheckJob - One level to validate.
+ * @source: File the level came from, or NULL for a generated level.
+ * @index: 1-based level number within its file, or the generated level's
+ * index.
+ * @required: Reachable spawn tiles the level needs.
+ * @grid: The level, already loaded for levels read from files.
+ * @seed: Generator seed for generated levels.
+ * @stats: Filled in by the worker.
+ * @status: 0 on success, 1 if the level could not be checked.
+ */
+
+typedef struct CheckJob
+{
+	const char *source;
+	int index;
+	int required;
+	LevelGrid grid;
+	Uint64 seed;
+	LevelStats stats;
+	int status;
+} CheckJob;
+
+/**
+ * struct CheckQueue - Jobs shared by the worker threads.
+ * @jobs: Array of jobs.
+ * @count: Number of jobs.
+ * @next: Index of the next unclaimed job.
+ * @maze: Size and spawn density of generated levels.
+ */
+
+typedef struct CheckQueue
+{
+	CheckJob *jobs;
+	int count;
+	SDL_atomic_t next;
+	MazeParams maze;
+} CheckQueue;
+
+/**
+ * copyGridRow - Stores a generated tile row in a LevelGrid.
+ * @row: Tile row.
+ * @width: Number of tiles.
+ * @y: Tile row index.
+ * @context: Pointer to the LevelGrid.
+ */
+
+static void copyGridRow(const int *row, int width, int y, void *context)
+{
+	int x;
+
+	for (x = 0; x < width; x++)
+		set_level_tile(context, x, y, row[x]);
+}
+
+/**
+ * checkWorker - Thread body that claims and validates jobs until none
+ * remain.
+ * @data: Pointer to the CheckQueue.
+ *
+ * Return: Always 0.
+ */
+
+static int checkWorker(void *data)
+{
+	CheckQueue *queue = data;
+	CheckJob *job;
+	MazeParams params = queue->maze;
+	int i;
+
+	while ((i = SDL_AtomicAdd(&queue->next, 1)) < queue->count)
+	{
+		job = &queue->jobs[i];
+		if (!job->source)
+		{
+			params.seed = job->seed;
+			job->status = init_level_grid(&job->grid, params.width,
+					params.height) || generate_maze(&params, 1, copyGridRow,
+					&job->grid);
+		}
+		if (job->status == 0)
+			job->status = check_level(&job->grid, 80 / TILE_SIZE,
+					80 / TILE_SIZE, &job->stats);
+		free_level_grid(&job->grid);
+	}
+
+	return (0);
+}
+
+/**
+ * appendRow - Parses one text row of a level and appends it to a grid.
+ * @grid: Pointer to the LevelGrid, initialized with height 0.
+ * @line: The row, whitespace separated tile ids.
+ *
+ * Return: 0 on success, 1 on a malformed row.
+ */
+
+static int appendRow(LevelGrid *grid, char *line)
+{
+	int x, width = 0;
+	char *token, *end;
+	size_t words;
+	Uint64 *open, *spawns;
+
+	for (token = line; ; token = end)
+	{
+		strtol(token, &end, 10);
+		if (end == token)
+			break;
+		width++;
+	}
+	if (width == 0)
+		return (1);
+	if (!grid->open && init_level_grid(grid, width, 0) != 0)
+		return (1);
+	if (width != grid->width)
+		return (1);
+
+	words = (size_t)(grid->height + 1) * grid->stride;
+	open = realloc(grid->open, words * sizeof(Uint64));
+	if (open)
+		grid->open = open;
+	spawns = realloc(grid->spawns, words * sizeof(Uint64));
+	if (spawns)
+		grid->spawns = spawns;
+	if (!open || !spawns)
+		return (1);
+	memset(grid->open + words - grid->stride, 0,
+			grid->stride * sizeof(Uint64));
+	memset(grid->spawns + words - grid->stride, 0,
+			grid->stride * sizeof(Uint64));
+
+	for (token = line, x = 0; x < width; token = end, x++)
+		set_level_tile(grid, x, grid->height, (int)strtol(token, &end, 10));
+	grid->height++;
+
+	return (0);
+}
+
+/**
+ * addJob - Appends a job to a growing job array.
+ * @jobs: Pointer to the job array.
+ * @count: Pointer to the number of jobs.
+ * @job: Job to append.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int addJob(CheckJob **jobs, int *count, const CheckJob *job)
+{
+	CheckJob *grown = realloc(*jobs, (*count + 1) * sizeof(CheckJob));
+
+	if (!grown)
+		return (1);
+	*jobs = grown;
+	grown[(*count)++] = *job;
+	return (0);
+}
+
+/**
+ * loadLevels - Reads every level of a level file into jobs.
+ * @path: Level file; levels are separated by blank lines.
+ * @level: Level number used for the spawn requirement, or 0 to use each
+ * level's position in the file.
+ * @jobs: Pointer to the job array.
+ * @count: Pointer to the number of jobs.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int loadLevels(const char *path, int level, CheckJob **jobs,
+		int *count)
+{
+	FILE *file = fopen(path, "r");
+	char *line = NULL;
+	size_t size = 0;
+	int lineNumber = 0, status = 0;
+	CheckJob job;
+
+	if (!file)
+	{
+		fprintf(stderr, "Could not open %s\n", path);
+		return (1);
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.source = path;
+	while (status == 0)
+	{
+		bool more = getline(&line, &size, file) != -1;
+		bool blank = !more || strspn(line, " \t\r\n") == strlen(line);
+
+		lineNumber++;
+		if (!blank && appendRow(&job.grid, line) != 0)
+		{
+			fprintf(stderr, "%s:%d: malformed level row\n", path, lineNumber);
+			status = 1;
+		}
+		else if (blank && job.grid.height > 0)
+		{
+			job.index++;
+			job.required = 4 * (level ? level : job.index);
+			status = addJob(jobs, count, &job);
+			memset(&job.grid, 0, sizeof(job.grid));
+		}
+		if (!more)
+			break;
+	}
+	free_level_grid(&job.grid);
+	free(line);
+	fclose(file);
+
+	return (status);
+}
+
+/**
+ * printStats - Prints the result of one job as a JSON object on one line.
+ * @job: The validated job.
+ *
+ * Return: true if the level passed every check.
+ */
+
+static bool printStats(const CheckJob *job)
+{
+	const LevelStats *stats = &job->stats;
+	const char *problem = NULL;
+
+	if (job->status != 0)
+		problem = "could not be checked";
+	else if (!stats->startOpen)
+		problem = "start tile is a wall";
+	else if (job->grid.exits == 0)
+		problem = "level has no exit";
+	else if (!stats->exitReachable)
+		problem = "exit is not reachable";
+	else if (stats->reachableSpawns < job->required)
+		problem = "not enough reachable spawn points";
+
+	if (job->source)
+		printf("{\"source\":\"%s\",\"level\":%d,", job->source, job->index);
+	else
+		printf("{\"seed\":%llu,", (unsigned long long)job->seed);
+	printf("\"ok\":%s,\"problem\":", problem ? "false" : "true");
+	if (problem)
+		printf("\"%s\",", problem);
+	else
+		printf("null,");
+	printf("\"pathLength\":%ld,\"openArea\":%ld,\"reachableArea\":%ld,"
+			"\"deadEnds\":%ld,\"spawns\":%ld,\"reachableSpawns\":%ld,"
+			"\"requiredSpawns\":%d}\n", stats->pathLength, stats->openArea,
+			stats->reachableArea, stats->deadEnds, stats->spawns,
+			stats->reachableSpawns, job->required);
+
+	return (problem == NULL);
+}
+
+/**
+ * main - Entry point of the level validator.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: levelcheck [options] FILE... checks every level of the given
+ * level files; levelcheck --generate COUNT [options] checks COUNT mazes
+ * from the procedural generator with consecutive seeds. Each level is
+ * checked for a walkable start tile at (80, 80), an exit reachable from it
+ * and enough reachable spawn points for load_enemies. Levels are spread
+ * over --threads workers (one per CPU by default) and reported one JSON
+ * object per line, in input order.
+ *
+ * Return: 0 if every level passed, 1 otherwise.
+ */
+
+int main(int argc, char *argv[])
+{
+	CheckQueue queue;
+	CheckJob job;
+	SDL_Thread **threads;
+	const char **files = calloc(argc, sizeof(char *));
+	int numThreads = SDL_GetCPUCount(), generate = 0, level = 0, i;
+	int numFiles = 0, failures = 0, status = 0;
+	Uint64 seed = 1;
+
+	if (!files)
+		return (1);
+
+	memset(&queue, 0, sizeof(queue));
+	queue.maze.width = mapWidth;
+	queue.maze.height = mapHeight;
+	queue.maze.spawnPercent = 70;
+	for (i = 1; i < argc && status == 0; i++)
+	{
+		if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc)
+			generate = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			status = sscanf(argv[++i], "%dx%d", &queue.maze.width,
+					&queue.maze.height) != 2;
+		else if (strcmp(argv[i], "--spawns") == 0 && i + 1 < argc)
+			queue.maze.spawnPercent = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+			level = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			numThreads = atoi(argv[++i]);
+		else if (argv[i][0] != '-')
+			files[numFiles++] = argv[i];
+		else
+			status = 1;
+	}
+	if (status != 0 || (numFiles == 0) == (generate <= 0))
+	{
+		fprintf(stderr, "Usage: %s [--threads N] [--level N] FILE...\n"
+				"       %s --generate COUNT [--seed N] [--size WxH] "
+				"[--spawns PERCENT] [--level N] [--threads N]\n",
+				argv[0], argv[0]);
+		status = 1;
+	}
+
+	for (i = 0; i < numFiles && status == 0; i++)
+		status = loadLevels(files[i], level, &queue.jobs, &queue.count);
+	free(files);
+
+	memset(&job, 0, sizeof(job));
+	job.required = 4 * (level ? level : 6);
+	for (i = 0; i < generate && status == 0; i++)
+	{
+		job.index = i + 1;
+		job.seed = seed + i;
+		status = addJob(&queue.jobs, &queue.count, &job);
+	}
+
+	if (numThreads < 1)
+		numThreads = 1;
+	threads = calloc(numThreads, sizeof(SDL_Thread *));
+	if (status != 0 || !threads)
+	{
+		for (i = 0; i < queue.count; i++)
+			free_level_grid(&queue.jobs[i].grid);
+		free(queue.jobs);
+		free(threads);
+		return (1);
+	}
+
+	SDL_AtomicSet(&queue.next, 0);
+	for (i = 1; i < numThreads; i++)
+		threads[i] = SDL_CreateThread(checkWorker, "levelcheck", &queue);
+	checkWorker(&queue);
+	for (i = 1; i < numThreads; i++)
+	{
+		if (threads[i])
+			SDL_WaitThread(threads[i], NULL);
+	}
+
+	for (i = 0; i < queue.count; i++)
+		failures += !printStats(&queue.jobs[i]);
+	fprintf(stderr, "Checked %d levels, %d failed\n", queue.count, failures);
+
+	free(queue.jobs);
+	free(threads);
+
+	return (failures > 0);
+}
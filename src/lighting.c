@@ -0,0 +1,338 @@
+#include "../headers/mazemania.h"
+
+/**
+ * lightingMode - True when walls, floor and ceiling are shaded by the
+ * tile light grid.
+ */
+bool lightingMode;
+
+/* Light level of every tile from the level's lamps alone */
+static Uint8 bakedLight[mapHeight][mapWidth];
+/* Baked light raised by this frame's dynamic lights */
+static Uint8 tileLight[mapHeight][mapWidth];
+/* Tiles a dynamic light raised, restored by clear_dynamic_lights */
+static int touchedTiles[mapHeight * mapWidth];
+static bool touched[mapHeight * mapWidth];
+static int numTouched;
+/* lightRamps[level][c] is colour component c at that light level */
+static Uint8 lightRamps[LIGHT_LEVELS][256];
+static bool rampsReady;
+
+/**
+ * isLitTile - Tells whether light spreads through a tile.
+ * @tile: Tile id from the world map.
+ *
+ * Return: false for border and inner walls.
+ */
+
+static bool isLitTile(int tile)
+{
+	return (tile != 1 && tile != 2);
+}
+
+/**
+ * floodLight - Spreads one light source through the open tiles.
+ * @grid: Light grid to raise; a tile only ever gets brighter.
+ * @x: Column of the source tile.
+ * @y: Row of the source tile.
+ * @level: Light level at the source, LIGHT_FALLOFF less per step.
+ * @record: Remember every raised tile so it can be restored later.
+ *
+ * A breadth-first walk reaches every tile at its shortest distance first,
+ * so no tile is queued twice for one source.
+ */
+
+static void floodLight(Uint8 grid[mapHeight][mapWidth], int x, int y,
+		int level, bool record)
+{
+	static const int dx[] = {1, -1, 0, 0}, dy[] = {0, 0, 1, -1};
+	int queue[mapHeight * mapWidth];
+	int head = 0, tail = 0, tile, value, nx, ny, i;
+
+	if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight ||
+			!isLitTile(worldMap[y][x]) || grid[y][x] >= level)
+		return;
+	grid[y][x] = level;
+	queue[tail++] = y * mapWidth + x;
+
+	while (head < tail)
+	{
+		tile = queue[head++];
+		x = tile % mapWidth;
+		y = tile / mapWidth;
+		if (record && !touched[tile])
+		{
+			touched[tile] = true;
+			touchedTiles[numTouched++] = tile;
+		}
+		value = grid[y][x] - LIGHT_FALLOFF;
+		for (i = 0; i < 4; i++)
+		{
+			nx = x + dx[i];
+			ny = y + dy[i];
+			if (nx < 0 || nx >= mapWidth || ny < 0 || ny >= mapHeight ||
+					!isLitTile(worldMap[ny][nx]) || grid[ny][nx] >= value)
+				continue;
+			grid[ny][nx] = value;
+			queue[tail++] = ny * mapWidth + nx;
+		}
+	}
+}
+
+/**
+ * bake_lighting - Builds the light grid of the current world map.
+ *
+ * Every tile starts at LIGHT_AMBIENT and each LIGHT_TILE lamp floods its
+ * light out through the open tiles, walls casting hard shadows. Called by
+ * loadCurrentLevel, so it also drops any dynamic lights.
+ */
+
+void bake_lighting(void)
+{
+	int x, y;
+
+	memset(bakedLight, LIGHT_AMBIENT, sizeof(bakedLight));
+	for (y = 0; y < mapHeight; y++)
+	{
+		for (x = 0; x < mapWidth; x++)
+		{
+			if (worldMap[y][x] == LIGHT_TILE)
+				floodLight(bakedLight, x, y, LIGHT_LAMP, false);
+		}
+	}
+
+	memcpy(tileLight, bakedLight, sizeof(tileLight));
+	memset(touched, 0, sizeof(touched));
+	numTouched = 0;
+}
+
+/* Furthest a lamp raises a tile above LIGHT_AMBIENT, in steps */
+#define LIGHT_REACH ((LIGHT_LAMP - LIGHT_AMBIENT - 1) / LIGHT_FALLOFF)
+
+/**
+ * withinReach - Tells whether a tile is within LIGHT_REACH steps of any
+ * tile of a set.
+ * @set: The set.
+ * @x: Column of the tile.
+ * @y: Row of the tile.
+ *
+ * Return: true if so; a step is one tile across or down.
+ */
+
+static bool withinReach(bool set[mapHeight][mapWidth], int x, int y)
+{
+	int dx, dy;
+
+	for (dy = -LIGHT_REACH; dy <= LIGHT_REACH; dy++)
+	{
+		for (dx = abs(dy) - LIGHT_REACH; dx <= LIGHT_REACH - abs(dy); dx++)
+		{
+			if (y + dy >= 0 && y + dy < mapHeight && x + dx >= 0 &&
+					x + dx < mapWidth && set[y + dy][x + dx])
+				return (true);
+		}
+	}
+
+	return (false);
+}
+
+/**
+ * relight_tiles - Repairs the light grid after tile edits.
+ * @tiles: Indices (y * mapWidth + x) of the edited tiles.
+ * @count: Number of entries of @tiles.
+ *
+ * Light only travels LIGHT_REACH steps, so only lamps that close to an
+ * edit can have lit through it, and only tiles that close to an edit or
+ * to one of those lamps can change. Every lamp able to reach that region
+ * floods a scratch grid, which then replaces the region; the tiles
+ * outside it keep their values. A setTile subscriber.
+ */
+
+void relight_tiles(const int *tiles, int count)
+{
+	bool edited[mapHeight][mapWidth] = {{false}};
+	bool sources[mapHeight][mapWidth] = {{false}};
+	bool region[mapHeight][mapWidth] = {{false}};
+	Uint8 grid[mapHeight][mapWidth];
+	int x, y, i;
+
+	for (i = 0; i < count; i++)
+	{
+		edited[tiles[i] / mapWidth][tiles[i] % mapWidth] = true;
+		sources[tiles[i] / mapWidth][tiles[i] % mapWidth] = true;
+	}
+	for (y = 0; y < mapHeight; y++)
+		for (x = 0; x < mapWidth; x++)
+			if (worldMap[y][x] == LIGHT_TILE && withinReach(edited, x, y))
+				sources[y][x] = true;
+
+	for (y = 0; y < mapHeight; y++)
+		for (x = 0; x < mapWidth; x++)
+			region[y][x] = withinReach(sources, x, y);
+
+	/* The region's light may come round through tiles outside it */
+	memset(grid, LIGHT_AMBIENT, sizeof(grid));
+	for (y = 0; y < mapHeight; y++)
+		for (x = 0; x < mapWidth; x++)
+			if (worldMap[y][x] == LIGHT_TILE && withinReach(region, x, y))
+				floodLight(grid, x, y, LIGHT_LAMP, false);
+
+	/* Dynamic lights are added again next frame */
+	for (y = 0; y < mapHeight; y++)
+	{
+		for (x = 0; x < mapWidth; x++)
+		{
+			if (!region[y][x])
+				continue;
+			bakedLight[y][x] = grid[y][x];
+			tileLight[y][x] = grid[y][x];
+		}
+	}
+}
+
+/**
+ * clear_dynamic_lights - Drops last frame's dynamic lights.
+ *
+ * Only the tiles they raised are restored from the baked grid.
+ */
+
+void clear_dynamic_lights(void)
+{
+	int i, tile;
+
+	for (i = 0; i < numTouched; i++)
+	{
+		tile = touchedTiles[i];
+		tileLight[tile / mapWidth][tile % mapWidth] =
+			bakedLight[tile / mapWidth][tile % mapWidth];
+		touched[tile] = false;
+	}
+	numTouched = 0;
+}
+
+/**
+ * add_dynamic_light - Adds a light for the current frame, such as the
+ * player's lantern or a muzzle flash.
+ * @x: Light x in world pixels.
+ * @y: Light y in world pixels.
+ * @level: Light level at the source, at most LIGHT_FULL.
+ *
+ * Only tiles within reach of the light are visited; they are restored by
+ * the next clear_dynamic_lights.
+ */
+
+void add_dynamic_light(float x, float y, int level)
+{
+	if (x < 0 || y < 0)
+		return;
+	floodLight(tileLight, (int)(x / TILE_SIZE), (int)(y / TILE_SIZE),
+			level > LIGHT_FULL ? LIGHT_FULL : level, true);
+}
+
+/**
+ * tile_light - Returns a tile's light level.
+ * @x: Column.
+ * @y: Row.
+ *
+ * Return: The level, or LIGHT_AMBIENT outside the map.
+ */
+
+int tile_light(int x, int y)
+{
+	if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+		return (LIGHT_AMBIENT);
+	return (tileLight[y][x]);
+}
+
+/**
+ * face_light - Returns the light level of the wall face a ray hit.
+ * @tileX: Column of the wall tile hit.
+ * @tileY: Row of the wall tile hit.
+ * @verticalRay: Non-zero if the ray hit a vertical grid line.
+ * @angle: Ray angle in degrees.
+ *
+ * A face is lit like the open tile in front of it, the one the ray came
+ * through, so each of a wall's four faces has its own level.
+ *
+ * Return: The face's light level.
+ */
+
+int face_light(int tileX, int tileY, int verticalRay, float angle)
+{
+	if (verticalRay)
+		tileX += cos(DEG_TO_RAD(angle)) > 0 ? -1 : 1;
+	else
+		tileY += sin(DEG_TO_RAD(angle)) > 0 ? -1 : 1;
+	return (tile_light(tileX, tileY));
+}
+
+/**
+ * light_ramp - Returns the scaling table of a light level.
+ * @level: Light level, 0 to LIGHT_FULL.
+ *
+ * The tables are built on first use, so the renderers can use them
+ * before any level is baked.
+ *
+ * Return: 256 entries mapping a colour component to its lit value;
+ * LIGHT_FULL leaves components unchanged.
+ */
+
+const Uint8 *light_ramp(int level)
+{
+	int l, c;
+
+	if (!rampsReady)
+	{
+		for (l = 0; l < LIGHT_LEVELS; l++)
+			for (c = 0; c < 256; c++)
+				lightRamps[l][c] = c * (l + 1) / LIGHT_LEVELS;
+		rampsReady = true;
+	}
+	return (lightRamps[level]);
+}
+
+/**
+ * light_plane_row - Looks up the light of every pixel of a floor or
+ * ceiling row.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @p: Distance of the row from the horizon in pixels, at least 1.
+ * @lights: Receives SCREEN_WIDTH light levels.
+ *
+ * The row is walked across the tile grid at the distance a wall whose
+ * edge lands on it would have, so floor and wall light meet at the wall's
+ * foot. Runs of pixels over one tile share a single grid read.
+ */
+
+void light_plane_row(float playerX, float playerY, float playerAngle, int p,
+		Uint8 *lights)
+{
+	float scale = (TILE_SIZE / 2) * DIST_TO_PROJ_PLANE / p /
+		cos(DEG_TO_RAD(FOV_ANGLE / 2)) / TILE_SIZE;
+	float dirX0 = cos(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2));
+	float dirY0 = sin(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2));
+	float dirX1 = cos(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2));
+	float dirY1 = sin(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2));
+	float planeX = playerX / TILE_SIZE + scale * dirX0;
+	float planeY = playerY / TILE_SIZE + scale * dirY0;
+	float stepX = scale * (dirX1 - dirX0) / SCREEN_WIDTH;
+	float stepY = scale * (dirY1 - dirY0) / SCREEN_WIDTH;
+	int x, tileX, tileY, lastX = INT_MIN, lastY = INT_MIN;
+	Uint8 level = LIGHT_AMBIENT;
+
+	for (x = 0; x < SCREEN_WIDTH; x++)
+	{
+		tileX = (int)floorf(planeX);
+		tileY = (int)floorf(planeY);
+		if (tileX != lastX || tileY != lastY)
+		{
+			level = tile_light(tileX, tileY);
+			lastX = tileX;
+			lastY = tileY;
+		}
+		lights[x] = level;
+		planeX += stepX;
+		planeY += stepY;
+	}
+}
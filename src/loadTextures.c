@@ -21,7 +21,7 @@ void freeTexture(Texture *t)
 {
 	if (t->texture)
 	{
-		SDL_DestroyTexture(t->texture);
+		mem_destroy_texture(t->texture);
 		t->texture = NULL;
 		t->width = 0;
 		t->height = 0;
@@ -39,6 +39,9 @@ void freeTexture(Texture *t)
  * mini-map. If true, the function performs operations specific to the
  * mini-map. If false, it performs the standard operations.
  *
+ * Images found in the asset pack are used from it instead of decoding
+ * @path.
+ *
  * Return: 0 on success, 1 on failure.
  */
 
@@ -46,7 +49,8 @@ int loadTexture(SDL_Renderer *renderer, const char *path, Texture *texture,
 		bool is_miniPlayer)
 {
 	float scale = is_miniPlayer ? MINIMAP_SCALE : 1.0f;
-	SDL_Surface *surface = IMG_Load(path);
+	const PackEntry *entry = find_pack_entry(path);
+	SDL_Surface *surface = entry ? pack_surface(entry) : IMG_Load(path);
 
 	if (!surface)
 	{
@@ -54,7 +58,8 @@ int loadTexture(SDL_Renderer *renderer, const char *path, Texture *texture,
 		return (1);
 	}
 
-	texture->texture = SDL_CreateTextureFromSurface(renderer, surface);
+	texture->texture = mem_texture_from_surface(MEM_TEXTURES, renderer,
+			surface);
 	if (!texture->texture)
 	{
 		fprintf(stderr, "Unable to create texture from %s: %s\n", path,
@@ -63,8 +68,9 @@ int loadTexture(SDL_Renderer *renderer, const char *path, Texture *texture,
 		return (1);
 	}
 
-	texture->width = surface->w * scale;
-	texture->height = surface->h * scale;
+	/* Packed images may be resampled; keep the size of the source image */
+	texture->width = (entry ? (int)entry->sourceWidth : surface->w) * scale;
+	texture->height = (entry ? (int)entry->sourceHeight : surface->h) * scale;
 	SDL_FreeSurface(surface);
 
 	return (0);
@@ -80,6 +86,7 @@ int loadTexture(SDL_Renderer *renderer, const char *path, Texture *texture,
  * This function loads an enemy texture from the specified file using the
  * provided renderer. If colorKey is true, it sets the color key for
  * transparency. It stores the loaded texture in the pointer provided.
+ * Images found in the asset pack are used from it without decoding.
  * Returns 0 on success, and non-zero on failure.
  *
  * Return: 0 on success, non-zero on failure.
@@ -89,7 +96,8 @@ int loadTexture(SDL_Renderer *renderer, const char *path, Texture *texture,
 int load_EnemyTexture(SDL_Renderer *renderer, const char *file,
 		SDL_Texture **texture, bool colorKey)
 {
-	SDL_Surface *surface = IMG_Load(file);
+	const PackEntry *entry = find_pack_entry(file);
+	SDL_Surface *surface = entry ? pack_surface(entry) : IMG_Load(file);
 
 	if (!surface)
 	{
@@ -103,7 +111,7 @@ int load_EnemyTexture(SDL_Renderer *renderer, const char *file,
 				SDL_MapRGB(surface->format, 255, 0, 255));
 	}
 
-	*texture = SDL_CreateTextureFromSurface(renderer, surface);
+	*texture = mem_texture_from_surface(MEM_ENEMIES, renderer, surface);
 	SDL_FreeSurface(surface);
 
 	if (!*texture)
@@ -14,6 +14,9 @@ void init_wallTexture(wallTexture *t)
 	t->width = 0;
 	t->height = 0;
 	t->pixels = NULL;
+	t->indices = NULL;
+	t->columns = NULL;
+	t->mapped = false;
 }
 
 /**
@@ -22,24 +25,74 @@ void init_wallTexture(wallTexture *t)
  *
  * This function frees the resources allocated for a wallTexture structure,
  * including the texture and pixels, and resets the width and height.
+ * Pixels that live in the asset pack are left to close_asset_pack.
  */
 
 void free_wallTexture(wallTexture *t)
 {
 	if (t->texture)
 	{
-		SDL_DestroyTexture(t->texture);
+		mem_destroy_texture(t->texture);
 		t->texture = NULL;
 		t->width = 0;
 		t->height = 0;
 	}
 	if (t->pixels)
 	{
-		free(t->pixels);
+		if (!t->mapped)
+			mem_free(t->pixels);
 		t->pixels = NULL;
+		t->columns = NULL;
+		t->mapped = false;
+	}
+	if (t->indices)
+	{
+		mem_free(t->indices);
+		t->indices = NULL;
 	}
 }
 
+/**
+ * loadPackedWallTexture - Sets up a wall texture from the asset pack.
+ * @renderer: Pointer to the SDL_Renderer structure for rendering.
+ * @entry: The texture's entry in the asset pack.
+ * @texture: Pointer to the wallTexture structure to fill.
+ *
+ * The pixels and the optional column-major copy are used in place, so the
+ * only work left is uploading the texture to the renderer.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int loadPackedWallTexture(SDL_Renderer *renderer,
+		const PackEntry *entry, wallTexture *texture)
+{
+	SDL_Surface *surface = pack_surface(entry);
+
+	if (!surface)
+	{
+		printf("Failed to wrap packed texture %s: %s\n", entry->name,
+				SDL_GetError());
+		return (1);
+	}
+	texture->texture = mem_texture_from_surface(MEM_TEXTURES, renderer,
+			surface);
+	SDL_FreeSurface(surface);
+	if (!texture->texture)
+	{
+		printf("Failed to create texture: %s\n", SDL_GetError());
+		return (1);
+	}
+
+	texture->width = entry->width;
+	texture->height = entry->height;
+	texture->pixels = (Uint32 *)pack_texels(entry, 0);
+	texture->columns = pack_columns(entry);
+	texture->mapped = true;
+
+	return (0);
+}
+
 /**
  * load_wallTexture - Loads a wall texture from a file.
  * @renderer: Pointer to the SDL_Renderer structure for rendering.
@@ -48,7 +101,10 @@ void free_wallTexture(wallTexture *t)
  *
  * This function loads a wall texture from specified file using the provided
  * renderer. It creates a texture from the loaded surface and stores it in the
- * wallTexture structure. Returns 0 on success, and non-zero on failure.
+ * wallTexture structure. When the palettized renderer is enabled the pixels
+ * are also quantized once here. Textures found in the asset pack are used
+ * from it directly instead of decoding @path. Returns 0 on success, and
+ * non-zero on failure.
  *
  * Return: 0 on success, non-zero on failure.
  */
@@ -56,15 +112,22 @@ void free_wallTexture(wallTexture *t)
 int load_wallTexture(SDL_Renderer *renderer, const char *path,
 		wallTexture *texture)
 {
-	SDL_Surface *loadedSurface = IMG_Load(path);
+	const PackEntry *entry = find_pack_entry(path);
+	SDL_Surface *loadedSurface;
+
+	if (entry)
+		return (loadPackedWallTexture(renderer, entry, texture) != 0 ||
+				(paletteMode && quantize_wallTexture(texture) != 0));
 
+	loadedSurface = IMG_Load(path);
 	if (!loadedSurface)
 	{
 		printf("Failed to load texture: %s\n", IMG_GetError());
 		return (1);
 	}
 
-	texture->texture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
+	texture->texture = mem_texture_from_surface(MEM_TEXTURES, renderer,
+			loadedSurface);
 	if (!texture->texture)
 	{
 		printf("Failed to create texture: %s\n", SDL_GetError());
@@ -74,12 +137,13 @@ int load_wallTexture(SDL_Renderer *renderer, const char *path,
 
 	texture->width = loadedSurface->w;
 	texture->height = loadedSurface->h;
-	texture->pixels = (Uint32 *)malloc(texture->width * texture->height *
-			sizeof(Uint32));
+	texture->pixels = mem_alloc(MEM_TEXTURES, texture->width *
+			texture->height * sizeof(Uint32));
 	if (!texture->pixels)
 	{
 		printf("Failed to allocate memory for texture pixels\n");
-		SDL_DestroyTexture(texture->texture);
+		mem_destroy_texture(texture->texture);
+		texture->texture = NULL;
 		SDL_FreeSurface(loadedSurface);
 		return (1);
 	}
@@ -87,5 +151,8 @@ int load_wallTexture(SDL_Renderer *renderer, const char *path,
 			texture->height * sizeof(Uint32));
 	SDL_FreeSurface(loadedSurface);
 
+	if (paletteMode && quantize_wallTexture(texture) != 0)
+		return (1);
+
 	return (0);
 }
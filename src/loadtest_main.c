@@ -0,0 +1,113 @@
+#include "../headers/mazemania.h"
+
+/**
+ * main - Entry point of the multiplayer load tester.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: mazeload [--connect HOST[:PORT]] [--clients N] [--seconds N]
+ * [--seed N] connects N simulated players, each with its own socket,
+ * sends their random inputs at TICK_RATE, decodes every snapshot they
+ * receive and prints the traffic each player saw as one JSON object.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int main(int argc, char *argv[])
+{
+	static const Uint16 moves[] = {0, INPUT_FORWARD, INPUT_FORWARD,
+		INPUT_BACK, INPUT_LEFT, INPUT_RIGHT};
+	static const Uint16 turns[] = {0, 0, INPUT_TURN_LEFT, INPUT_TURN_RIGHT};
+	const char *address = "127.0.0.1";
+	NetClient *clients;
+	Uint16 *inputs;
+	Uint64 rng, seed = 1, start, next, frequency;
+	Uint64 snapshots = 0, deltas = 0, bytes = 0, undecodable = 0;
+	double seconds = 10, elapsed;
+	long tick;
+	int count = NET_MAX_PLAYERS, connected = 0, i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc)
+			address = argv[++i];
+		else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc)
+			count = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = atof(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 0);
+		else
+			count = 0;
+	}
+	if (count < 1 || seconds <= 0)
+	{
+		fprintf(stderr, "Usage: %s [--connect HOST[:PORT]] [--clients N] "
+				"[--seconds N] [--seed N]\n", argv[0]);
+		return (1);
+	}
+
+	clients = calloc(count, sizeof(NetClient));
+	inputs = calloc(count, sizeof(Uint16));
+	if (!clients || !inputs)
+	{
+		free(clients);
+		free(inputs);
+		return (1);
+	}
+	for (connected = 0; connected < count; connected++)
+	{
+		if (client_connect(&clients[connected], address) != 0)
+			break;
+	}
+
+	seed_rng(&rng, seed);
+	frequency = SDL_GetPerformanceFrequency();
+	start = SDL_GetPerformanceCounter();
+	next = start;
+	for (tick = 0; connected == count &&
+			tick < (long)(seconds * TICK_RATE); tick++)
+	{
+		/* Every player changes its mind every half second */
+		for (i = 0; i < count; i++)
+		{
+			if ((tick + i) % (TICK_RATE / 2) == 0)
+				inputs[i] = moves[rng_range(&rng, 6)] |
+					turns[rng_range(&rng, 4)];
+			client_poll(&clients[i]);
+			client_send_input(&clients[i], inputs[i]);
+		}
+
+		next += frequency / TICK_RATE;
+		while (SDL_GetPerformanceCounter() < next)
+			SDL_Delay(1);
+	}
+	elapsed = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+
+	for (i = 0; i < connected; i++)
+	{
+		client_poll(&clients[i]);
+		snapshots += clients[i].snapshots;
+		deltas += clients[i].deltas;
+		bytes += clients[i].bytesReceived;
+		undecodable += clients[i].undecodable;
+		client_disconnect(&clients[i]);
+	}
+
+	if (connected == count)
+		printf("{\"clients\":%d,\"seconds\":%.2f,"
+				"\"snapshotsPerClientPerSecond\":%.1f,\"bytesPerSnapshot\":%.1f,"
+				"\"bytesPerClientPerSecond\":%.0f,\"deltaShare\":%.4f,"
+				"\"undecodable\":%llu}\n", count, elapsed,
+				snapshots / elapsed / count, snapshots ? (double)bytes /
+				snapshots : 0.0, bytes / elapsed / count, snapshots ?
+				(double)deltas / snapshots : 0.0,
+				(unsigned long long)undecodable);
+	else
+		fprintf(stderr, "Only %d of %d players could connect\n", connected,
+				count);
+	free(clients);
+	free(inputs);
+
+	return (connected == count ? 0 : 1);
+}
@@ -6,12 +6,14 @@ int worldMap[mapHeight][mapWidth];
  * init_instance - Initializes the SDL instance, including the
  * window and renderer.
  * @instance: Pointer to the SDL_Instance structure to initialize.
+ * @vsync: Whether presenting should wait for the display's refresh.
  *
  * Return: 0 on success, 1 on failure.
  */
 
-int init_instance(SDL_Instance *instance)
+int init_instance(SDL_Instance *instance, bool vsync)
 {
+	instance->surface = NULL;
 	if (SDL_Init(SDL_INIT_VIDEO) != 0)
 	{
 		fprintf(stderr, "Unable to initialize SDL: %s\n", SDL_GetError());
@@ -30,7 +32,8 @@ int init_instance(SDL_Instance *instance)
 
 	/* Create a renderer instance linked to the window */
 	instance->renderer = SDL_CreateRenderer(instance->window, -1,
-			SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+			SDL_RENDERER_ACCELERATED |
+			(vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
 	if (instance->renderer == NULL)
 	{
 		fprintf(stderr, "SDL_CreateRenderer Error: %s\n", SDL_GetError());
@@ -52,6 +55,196 @@ int init_instance(SDL_Instance *instance)
 	return (0);
 }
 
+/**
+ * init_headless_instance - Initializes SDL for offscreen rendering.
+ * @instance: Pointer to the SDL_Instance structure to initialize.
+ *
+ * Uses the dummy video driver and a software renderer drawing into a
+ * screen-sized surface, so frames can be rendered and read back on a
+ * machine with no display.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int init_headless_instance(SDL_Instance *instance)
+{
+	instance->window = NULL;
+	instance->renderer = NULL;
+	instance->surface = NULL;
+
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+	{
+		fprintf(stderr, "Unable to initialize SDL: %s\n", SDL_GetError());
+		return (1);
+	}
+
+	instance->surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH,
+			SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (instance->surface == NULL)
+	{
+		fprintf(stderr, "SDL_CreateRGBSurface Error: %s\n", SDL_GetError());
+		SDL_Quit();
+		return (1);
+	}
+
+	instance->renderer = SDL_CreateSoftwareRenderer(instance->surface);
+	if (instance->renderer == NULL)
+	{
+		fprintf(stderr, "SDL_CreateSoftwareRenderer Error: %s\n",
+				SDL_GetError());
+		SDL_FreeSurface(instance->surface);
+		SDL_Quit();
+		return (1);
+	}
+
+	if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG))
+	{
+		printf("SDL_image could not initialize! SDL_image Error: %s\n",
+				IMG_GetError());
+		SDL_DestroyRenderer(instance->renderer);
+		SDL_FreeSurface(instance->surface);
+		SDL_Quit();
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * parse_options - Parses the command-line arguments into GameOptions.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ * @options: Pointer to the GameOptions structure to fill.
+ *
+ * Return: 0 on success, 1 on an unknown argument.
+ */
+
+int parse_options(int argc, char *argv[], GameOptions *options)
+{
+	int i;
+
+	memset(options, 0, sizeof(*options));
+	options->level = 1;
+	options->tolerance = 2;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--palette") == 0)
+		{
+			options->palette = true;
+		}
+		else if (strcmp(argv[i], "--fixed") == 0)
+		{
+			options->fixedPoint = true;
+		}
+		else if (strcmp(argv[i], "--gpu") == 0)
+		{
+			options->gpuBatch = true;
+		}
+		else if (strcmp(argv[i], "--lighting") == 0)
+		{
+			options->lighting = true;
+		}
+		else if (strcmp(argv[i], "--generate") == 0)
+		{
+			options->generate = true;
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			options->recordPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--replay") == 0 ||
+					strcmp(argv[i], "--timedemo") == 0) && i + 1 < argc)
+		{
+			options->timedemo = (strcmp(argv[i], "--timedemo") == 0);
+			options->replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			options->hasSeed = true;
+			options->seed = strtoull(argv[++i], NULL, 0);
+		}
+		else if ((strcmp(argv[i], "--snapshot") == 0 ||
+					strcmp(argv[i], "--compare") == 0) && i + 1 < argc)
+		{
+			options->goldenCompare = (strcmp(argv[i], "--compare") == 0);
+			options->goldenDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc)
+		{
+			options->connectAddress = argv[++i];
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+		{
+			options->capturePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc)
+		{
+			options->memoryPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			options->headless = true;
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+		{
+			options->tolerance = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+		{
+			options->level = atoi(argv[++i]);
+			if (options->level < 1 || options->level > 6)
+			{
+				fprintf(stderr, "Level must be between 1 and 6\n");
+				return (1);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--palette | --gpu] [--fixed] "
+					"[--lighting] [--generate] [--seed N] [--level N] "
+					"[--record FILE | --replay FILE | --timedemo FILE] "
+					"[--snapshot DIR | --compare DIR [--tolerance N]] "
+					"[--connect HOST[:PORT]] [--capture FILE.y4m | DIR] "
+					"[--memory FILE] [--headless]\n",
+					argv[0]);
+			return (1);
+		}
+	}
+
+	if (options->recordPath && options->replayPath)
+	{
+		fprintf(stderr, "Cannot record and replay at the same time\n");
+		return (1);
+	}
+	if (options->connectAddress && (options->recordPath ||
+				options->replayPath || options->goldenDir))
+	{
+		fprintf(stderr, "--connect plays what the server simulates; it "
+				"cannot record, replay or render snapshots\n");
+		return (1);
+	}
+	if (options->capturePath && options->goldenDir)
+	{
+		fprintf(stderr, "--capture records the game loop; use it without "
+				"--snapshot and --compare\n");
+		return (1);
+	}
+	if (options->headless && !options->replayPath)
+	{
+		fprintf(stderr, "--headless has no keyboard, so it needs --replay "
+				"or --timedemo\n");
+		return (1);
+	}
+	if (options->palette && options->gpuBatch)
+	{
+		fprintf(stderr, "--palette and --gpu are separate renderers\n");
+		return (1);
+	}
+
+	return (0);
+}
+
 /**
  * render_world - Renders the world map.
  * @instance: Pointer to SDL_Instance structure with window and renderer.
@@ -62,22 +255,28 @@ int init_instance(SDL_Instance *instance)
  *
  * This function renders the world map using the SDL renderer specified in the
  * SDL_Instance structure. The size of each map element is defined by
- * the dimensions provided in the SDL_Rect structure.
+ * the dimensions provided in the SDL_Rect structure. The mini-map only
+ * shows the tiles of the level the player has explored.
  */
 
 void render_world(SDL_Instance *instance, SDL_Rect *rect, bool isMinimap)
 {
 	float scale = isMinimap ? MINIMAP_SCALE : 1.0f;
-	int y, x;
+	Uint64 explored[PVS_WORDS];
+	int y, x, tile;
 
 	rect->w = TILE_SIZE * scale;
 	rect->h = TILE_SIZE * scale;
 	if (isMinimap)
 	{
+		get_explored(explored);
 		for (y = 0; y < mapHeight; y++)
 		{
 			for (x = 0; x < mapWidth; x++)
 			{
+				tile = y * mapWidth + x;
+				if (!((explored[tile / 64] >> (tile % 64)) & 1))
+					continue;
 				rect->x = x * TILE_SIZE * scale;
 				rect->y = y * TILE_SIZE * scale;
 
@@ -101,6 +300,11 @@ void render_world(SDL_Instance *instance, SDL_Rect *rect, bool isMinimap)
 					SDL_SetRenderDrawColor(instance->renderer, 255, 253, 208,
 							255);
 				}
+				else if (worldMap[y][x] == LIGHT_TILE)
+				{
+					SDL_SetRenderDrawColor(instance->renderer, 255, 200, 64,
+							255);
+				}
 
 				SDL_RenderFillRect(instance->renderer, rect);
 			}
@@ -109,154 +313,345 @@ void render_world(SDL_Instance *instance, SDL_Rect *rect, bool isMinimap)
 }
 
 /**
- * handleEvent - Handles SDL events for object movement and rotation.
+ * handleEvent - Translates SDL keyboard events into input bits.
  * @event: Pointer to the SDL_Event structure containing event data.
- * @object: Pointer to the SDL_Rect structure representing object's position.
- * @texture: Pointer to the Texture structure representing object's texture.
- * @speed: Speed at which the object moves.
- * @degrees: Pointer to the angle in degrees to rotate the object.
- * @deltaTime: Time elapsed since the last frame.
- * @isMinimap: Pointer to a boolean indicating if the minimap is enabled.
+ * @input: Pointer to the input word for the next simulation tick.
  *
- * This function processes SDL events such as keyboard input to move and
- * rotate the object within the game world. It updates the object's position
- * and rotation angle based on the input events, ensuring the movement is
- * frame-rate independent by using the deltaTime parameter.
+ * Movement, rotation, fire and rewind keys set their bit while held. The
+ * mini-map, save, load and restart keys only set a one-shot bit that is
+ * cleared once a tick has consumed it.
+ * Keeping the tick input in one word is what lets a session be recorded
+ * and replayed exactly.
  */
 
-void handleEvent(SDL_Event *event, SDL_Rect *object, Texture *texture,
-		float speed, double *degrees, float deltaTime, bool *isMinimap)
+void handleEvent(SDL_Event *event, Uint16 *input)
 {
-	SDL_Rect prevPosition = *object;
-	int y, x;
+	Uint16 bit = 0;
 
-	/* Define key states */
-	static bool keyW, keyS, keyA, keyD;
+	if (event->type != SDL_KEYDOWN && event->type != SDL_KEYUP)
+		return;
 
-	/* Handle keyboard input for movement */
-	if (event->type == SDL_KEYDOWN || event->type == SDL_KEYUP)
-	{
-		bool isKeyDown = (event->type == SDL_KEYDOWN);
+	bool isKeyDown = (event->type == SDL_KEYDOWN);
 
-		switch (event->key.keysym.sym)
-		{
-			case SDLK_w:
-				keyW = isKeyDown;
-				break;
-			case SDLK_s:
-				keyS = isKeyDown;
-				break;
-			case SDLK_a:
-				keyA = isKeyDown;
-				break;
-			case SDLK_d:
-				keyD = isKeyDown;
-				break;
-			case SDLK_LEFT:
-				if (isKeyDown)
-					*degrees -= 180 * deltaTime;
-				break;
-			case SDLK_RIGHT:
-				if (isKeyDown)
-					*degrees += 180 * deltaTime;
-				break;
-			case SDLK_ESCAPE:
-				if (isKeyDown)
-					*isMinimap = !*isMinimap; /* Toggle mini-map state */
-				break;
-			case SDLK_RETURN:
-				if (isKeyDown)
-					*isMinimap = true;
-				break;
-		}
+	switch (event->key.keysym.sym)
+	{
+		case SDLK_w:
+			bit = INPUT_FORWARD;
+			break;
+		case SDLK_s:
+			bit = INPUT_BACK;
+			break;
+		case SDLK_a:
+			bit = INPUT_LEFT;
+			break;
+		case SDLK_d:
+			bit = INPUT_RIGHT;
+			break;
+		case SDLK_LEFT:
+			bit = INPUT_TURN_LEFT;
+			break;
+		case SDLK_RIGHT:
+			bit = INPUT_TURN_RIGHT;
+			break;
+		case SDLK_SPACE:
+			bit = INPUT_FIRE;
+			break;
+		case SDLK_LCTRL:
+			bit = INPUT_LAUNCH;
+			break;
+		case SDLK_BACKSPACE:
+			bit = INPUT_REWIND;
+			break;
+		case SDLK_ESCAPE:
+			if (isKeyDown)
+				*input |= INPUT_TOGGLE_MAP; /* Toggle mini-map state */
+			return;
+		case SDLK_RETURN:
+			if (isKeyDown)
+				*input |= INPUT_SHOW_MAP;
+			return;
+		case SDLK_e:
+			if (isKeyDown)
+				*input |= INPUT_EDIT;
+			return;
+		case SDLK_F5:
+			if (isKeyDown)
+				*input |= INPUT_SAVE;
+			return;
+		case SDLK_F8:
+			if (isKeyDown)
+				*input |= INPUT_RESTART;
+			return;
+		case SDLK_F9:
+			if (isKeyDown)
+				*input |= INPUT_LOAD;
+			return;
+		default:
+			return;
 	}
 
-	/* Determine the resulting movement based on key states */
-	float moveX = 0, moveY = 0;
+	if (isKeyDown)
+		*input |= bit;
+	else
+		*input &= ~bit;
+}
+
+/**
+ * updatePlayer - Advances the player by one simulation tick.
+ * @state: Pointer to the GameState holding the player.
+ * @input: Input bits for this tick, see handleEvent.
+ * @speed: Speed at which the player moves.
+ * @deltaTime: Length of the tick in seconds.
+ *
+ * Moves the player through the current level; see move_player.
+ */
+
+void updatePlayer(GameState *state, Uint16 input, float speed,
+		float deltaTime)
+{
+	move_player(state, worldMap, input, speed, deltaTime);
+}
+
+/**
+ * checkLevelCompletion - Moves to the next level when the player stands on
+ * the exit tile.
+ * @state: Pointer to the GameState.
+ * @levelManager: Pointer to the LevelManager holding every level.
+ * @enemies: Array of the current level's enemies.
+ * @instance: Pointer to the SDL_Instance used to load enemy textures.
+ *
+ * Return: 0 to keep playing, 1 when every level is complete, -1 on error.
+ */
+
+int checkLevelCompletion(GameState *state, LevelManager *levelManager,
+		Enemy *enemies, SDL_Instance *instance)
+{
+	if (!atLevelExit(state))
+		return (0);
+
+	free_enemies(enemies, 4 * state->level);
 
-	if ((keyW && keyS) || (keyA && keyD))
+	if (levelManager->current_Level >= 5)
 	{
-		moveX = 0;
-		moveY = 0;
+		printf("You have completed all levels!\n");
+		return (1);
 	}
-	else
+
+	levelManager->current_Level++;
+	state->level = levelManager->current_Level + 1;
+	loadCurrentLevel(levelManager);
+	state->player.x = 80;
+	state->player.y = 80;
+	state->degrees = 0;
+	if (load_enemies(enemies, state->level, instance, &state->rng) != 0)
 	{
-		if (keyW && keyA)
-		{
-			moveY = -speed * deltaTime;
-			moveX = -speed * deltaTime;
-		}
-		else if (keyW && keyD)
-		{
-			moveY = -speed * deltaTime;
-			moveX = speed * deltaTime;
-		}
-		else if (keyA && keyS)
-		{
-			moveX = -speed * deltaTime;
-			moveY = speed * deltaTime;
-		}
-		else if (keyS && keyD)
-		{
-			moveX = speed * deltaTime;
-			moveY = speed * deltaTime;
-		}
-		else if (keyW && !keyS)
-		{
-			moveY = -speed * deltaTime;
-		}
-		else if (keyA && !keyD)
-		{
-			moveX = -speed * deltaTime;
-		}
-		else if (keyS && !keyW)
-		{
-			moveY = speed * deltaTime;
-		}
-		else if (keyD && !keyA)
-		{
-			moveX = speed * deltaTime;
-		}
+		fprintf(stderr, "Could not complete loading the enemies\n");
+		return (-1);
 	}
 
-	object->x += moveX;
-	object->y += moveY;
+	return (0);
+}
 
-	/* Boundary checks. Added 10 pixels so that the player will go into open */
-	/* space when the world is rendered with textures */
-	if (object->x < TILE_SIZE + 10)
-		object->x = TILE_SIZE + 10;
 
-	if ((object->x + texture->width) > SCREEN_WIDTH - TILE_SIZE - 10)
-		object->x = SCREEN_WIDTH - TILE_SIZE - 10 - texture->width;
+/**
+ * renderFrame - Draws one frame of the game without presenting it.
+ * @instance: Pointer to the SDL_Instance to draw with.
+ * @state: Pointer to the GameState to draw.
+ * @enemies: The level's enemies as of @state, or NULL to draw none.
+ * @numEnemies: Number of entries of @enemies.
+ * @assets: Textures for walls, floor, ceiling and the mini-map marker.
+ *
+ * This function only reads the game state, so it can be used both by the
+ * game loop and by the offscreen golden-image runs. With lighting on, the
+ * player carries a lantern, a dynamic light moved with them every frame,
+ * and each shot lights the surroundings for a few ticks.
+ * The walls, floor and ceiling are drawn by the kernels chosen for the
+ * loaded level.
+ */
 
-	if (object->y < TILE_SIZE + 10)
-		object->y = TILE_SIZE + 10;
+void renderFrame(SDL_Instance *instance, const GameState *state,
+		const Enemy *enemies, int numEnemies, RenderAssets *assets)
+{
+	SDL_Rect rect;
+	SDL_Rect miniobject = {0, 0, assets->mini.width, assets->mini.height};
+	const RenderKernels *kernels = renderKernels;
+
+	/* Update miniobject based on object position */
+	miniobject.x = state->player.x * MINIMAP_SCALE;
+	miniobject.y = state->player.y * MINIMAP_SCALE;
 
-	if ((object->y + texture->height) > SCREEN_HEIGHT - TILE_SIZE - 10)
-		object->y = SCREEN_HEIGHT - TILE_SIZE - 10 - texture->height;
+	/* Clear the window with a grey color */
+	SDL_SetRenderDrawColor(instance->renderer, 128, 128, 128, 255);
+	SDL_RenderClear(instance->renderer);
 
-	/* Check for collision with internal walls */
-	for (y = 0; y < mapHeight; y++)
+	if (lightingMode)
 	{
-		for (x = 0; x < mapWidth; x++)
-		{
-			if (worldMap[y][x] == 2)
-			{
-				SDL_Rect wallRect = {x * TILE_SIZE, y * TILE_SIZE,
-					TILE_SIZE, TILE_SIZE};
+		clear_dynamic_lights();
+		add_dynamic_light(state->player.x, state->player.y, LIGHT_LANTERN);
+		if (state->lastShot &&
+				state->tick - state->lastShot < MUZZLE_FLASH_TICKS)
+			add_dynamic_light(state->player.x, state->player.y, LIGHT_FULL);
+	}
 
-				if (checkIntersection(object, &wallRect))
-				{
-					/* Move the object back to its previous position */
-					*object = prevPosition;
-					return;
-				}
-			}
+	/* Main game rendering */
+	render_world(instance, &rect, false);
+
+	/*
+	 * Cast every column's ray once, so the ceiling and floor only shade
+	 * the pixels around each column's wall, then draw the walls from the
+	 * same hits
+	 */
+	castRays(state->player.x, state->player.y, state->degrees, &rayHits);
+
+	/* The level's kernels, or the sky and plain ground where they have none */
+	if (paletteMode)
+		renderTopHalfPalette(!kernels->ceiling, !kernels->floor);
+	else if (!kernels->ceiling)
+		renderTopHalf(instance, &rayHits);
+
+	if (kernels->ceiling)
+		kernels->ceiling(instance, state->player.x, state->player.y,
+				state->degrees, &assets->ceiling, &rayHits);
+	if (kernels->floor)
+		kernels->floor(instance, state->player.x, state->player.y,
+				state->degrees, &assets->floor, &rayHits);
+	kernels->walls(instance, &rayHits, &assets->wall);
+
+	/* Expand the palettized frame before drawing sprites and overlays */
+	if (paletteMode)
+		presentPaletteFramebuffer(instance);
+
+	/* Render enemies */
+	if (enemies)
+		renderEnemies3D(instance, enemies, numEnemies, state->player.x,
+				state->player.y, state->degrees);
+
+	/* Draw the batched walls and sprites before the overlays */
+	if (gpuBatchMode)
+		flushGpuBatches(instance->renderer);
+
+	if (state->isMinimap)
+	{
+		/* Minimap rendering */
+		render_world(instance, &rect, true);
+
+		/* Render the moving miniobject with rotation */
+		SDL_RenderCopyEx(instance->renderer, assets->mini.texture, NULL,
+				&miniobject, state->degrees, NULL, SDL_FLIP_NONE);
+
+		/* The mini-map ray fan reuses the main view's hits */
+		drawMiniMapRays(instance->renderer, &rayHits, miniobject.x,
+				miniobject.y);
+	}
+}
+
+/**
+ * followServer - Exchanges one frame's input and state with the server.
+ * @client: The connection.
+ * @state: Receives the local player's pose and level from the newest
+ * snapshot; its mini-map flag stays local.
+ * @levelManager: Used to load the level when the server changes it.
+ * @input: Input word built by handleEvent; its one-shot bits are applied
+ * here and cleared.
+ *
+ * Return: 0 to keep playing, 1 once the server has been silent for
+ * NET_TIMEOUT ticks.
+ */
+
+static int followServer(NetClient *client, GameState *state,
+		LevelManager *levelManager, Uint16 *input)
+{
+	const NetWorld *world;
+	const NetPlayer *player;
+
+	client_poll(client);
+	client_send_input(client, *input);
+	if (*input & INPUT_TOGGLE_MAP)
+		state->isMinimap = !state->isMinimap;
+	if (*input & INPUT_SHOW_MAP)
+		state->isMinimap = true;
+	*input &= ~INPUT_ONESHOT_MASK;
+
+	world = client_world(client);
+	if (world)
+	{
+		player = &world->players[client->id];
+		state->player.x = player->x;
+		state->player.y = player->y;
+		state->degrees = player->angle * 360.0 / 65536;
+		state->tick = world->tick;
+		if (world->level != state->level && world->level >= 1 &&
+				world->level <= 6)
+		{
+			state->level = world->level;
+			levelManager->current_Level = world->level - 1;
+			loadCurrentLevel(levelManager);
 		}
 	}
+
+	if (SDL_GetTicks() - client->lastHeard > NET_TIMEOUT * 1000 / TICK_RATE)
+	{
+		fprintf(stderr, "Lost the connection to the server\n");
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * followEnemies - Takes the enemies of the newest snapshot for drawing.
+ * @client: The connection.
+ * @level: The level the client has loaded.
+ * @enemies: Receives the enemies.
+ * @texture: Texture every enemy is drawn with.
+ *
+ * Return: The number of enemies, 0 until a snapshot of @level arrived.
+ */
+
+static int followEnemies(const NetClient *client, int level, Enemy *enemies,
+		SDL_Texture *texture)
+{
+	const NetWorld *world = client_world(client);
+	int i;
+
+	if (!world || world->level != level)
+		return (0);
+	for (i = 0; i < world->numEnemies && i < MAX_ENEMIES; i++)
+	{
+		memset(&enemies[i], 0, sizeof(enemies[i]));
+		enemies[i].rect.x = world->enemies[i].x;
+		enemies[i].rect.y = world->enemies[i].y;
+		enemies[i].rect.w = TILE_SIZE / 3;
+		enemies[i].rect.h = TILE_SIZE / 3;
+		enemies[i].health = world->enemies[i].health;
+		enemies[i].texture = texture;
+	}
+	return (i);
 }
 
+/**
+ * drawRemotePlayers - Marks the other players on the mini-map.
+ * @renderer: Renderer to draw with.
+ * @client: The connection.
+ * @mini: The mini-map player marker.
+ */
+
+static void drawRemotePlayers(SDL_Renderer *renderer, const NetClient *client,
+		Texture *mini)
+{
+	const NetWorld *world = client_world(client);
+	SDL_Rect marker = {0, 0, mini->width, mini->height};
+	int i;
+
+	for (i = 0; world && i < NET_MAX_PLAYERS; i++)
+	{
+		if (i == client->id || !world->players[i].active)
+			continue;
+		marker.x = world->players[i].x * MINIMAP_SCALE;
+		marker.y = world->players[i].y * MINIMAP_SCALE;
+		SDL_RenderCopyEx(renderer, mini->texture, NULL, &marker,
+				world->players[i].angle * 360.0 / 65536, NULL, SDL_FLIP_NONE);
+	}
+}
 
 /**
  * cleanup - Cleans up and frees SDL resources.
@@ -274,39 +669,114 @@ void cleanup(SDL_Instance *instance)
 	{
 		SDL_DestroyWindow(instance->window);
 	}
+	if (instance->surface)
+	{
+		SDL_FreeSurface(instance->surface);
+	}
 	IMG_Quit();
 	SDL_Quit();
 }
 
 /**
  * main - Entry point of the program.
+ * @argc: Argument count.
+ * @argv: Argument vector, see parse_options for the accepted flags.
  * Initializes SDL, manages the game loop,
  * handles events, updates the game state, and cleans up resources.
  *
+ * The simulation runs at a fixed TICK_RATE on its own thread, independent
+ * of the frame rate, so that a recording made on one machine replays
+ * identically on another and a slow frame never holds up a tick. The
+ * render thread draws whatever tick was published last.
+ *
  * Return: 0 on success, 1 on failure.
  */
 
-int main(void)
+int main(int argc, char *argv[])
 {
 	SDL_Instance instance;
+	GameOptions options;
+	Recording recording;
+
+	if (parse_options(argc, argv, &options) != 0)
+		return (1);
+
+	if (options.replayPath && open_replay(&recording, options.replayPath) != 0)
+		return (1);
+
+	if (options.goldenDir || options.headless)
+	{
+		if (init_headless_instance(&instance) != 0)
+			return (1);
+	}
+	else if (init_instance(&instance, !options.timedemo) != 0)
+		return (1);
 
-	if (init_instance(&instance) != 0)
+	init_fixed_tables();
+	fixedPointMode = options.fixedPoint;
+	paletteMode = options.palette;
+	gpuBatchMode = options.gpuBatch;
+	lightingMode = options.lighting;
+	/* A golden compare draws the palettized path too, see run_golden */
+	if (options.goldenDir && options.goldenCompare)
+		paletteMode = true;
+	if (paletteMode && init_palette(instance.renderer) != 0)
+	{
+		cleanup(&instance);
 		return (1);
+	}
 
 	SDL_Event event;
-	SDL_Rect rect;
-	SDL_Rect object = {80, 80, 0, 0};
-	SDL_Rect miniobject = {96, 96, 0, 0};
-	int running = 1, level = 1, numEnemies, i;
-	double degrees = 0;
-	Texture objectTexture, miniTexture;
-	wallTexture wall1Texture, floorTexture, ceilingTexture;
-	float speed = 200;
-	float deltaTime;
-	Uint32 lastFrameTime = SDL_GetTicks();
-	bool isMinimap = true;
+	Simulation sim;
+	NetClient client;
+	FrameCapture capture;
+	int running = 1, status;
+	Texture objectTexture;
+	SDL_Texture *remoteEnemyTexture = NULL;
+	RenderAssets assets;
+	double *frameTimes = NULL;
+	Uint32 frames = 0;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint16 input = 0;
+	bool showMemory = false;
 	LevelManager LevelManager;
-	Enemy enemies[MAX_ENEMIES];
+
+	memset(&sim, 0, sizeof(sim));
+	sim.state.player.x = 80;
+	sim.state.player.y = 80;
+	sim.state.isMinimap = true;
+	sim.state.level = options.replayPath ? recording.level : options.level;
+	if (options.replayPath)
+	{
+		options.seed = recording.seed;
+		options.generate = (recording.flags & RECORDING_GENERATED) != 0;
+	}
+	else if (options.connectAddress)
+	{
+		/* Build the same levels as the server */
+		if (client_connect(&client, options.connectAddress) != 0)
+		{
+			cleanup(&instance);
+			exit(1);
+		}
+		options.seed = client.seed;
+		options.generate = client.generate;
+	}
+	else if (!options.hasSeed)
+		options.seed = time(NULL);
+	seed_rng(&sim.state.rng, options.seed);
+
+	if (options.timedemo)
+	{
+		frameTimes = mem_alloc(MEM_RENDER, (recording.ticks + 1) *
+				sizeof(double));
+		if (!frameTimes)
+		{
+			fprintf(stderr, "Could not allocate timedemo frame times\n");
+			cleanup(&instance);
+			exit(1);
+		}
+	}
 
 	if ((load_worlds_from_file()) != 0)
 	{
@@ -315,21 +785,36 @@ int main(void)
 		exit(1);
 	}
 
+	/* Use the baked textures when present, see packbake */
+	open_asset_pack(ASSET_PACK_PATH);
+
 	initTexture(&objectTexture);
-	initTexture(&miniTexture);
-	init_wallTexture(&wall1Texture);
-	init_wallTexture(&floorTexture);
-	init_wallTexture(&ceilingTexture);
+	initTexture(&assets.mini);
+	init_wallTexture(&assets.wall);
+	init_wallTexture(&assets.floor);
+	init_wallTexture(&assets.ceiling);
 	if (init_LevelManager(&LevelManager) != 0)
 	{
 		fprintf(stderr, "Could not complete initializinfg the levels\n");
 		cleanup(&instance);
 		exit(1);
 	}
+	LevelManager.onLoad = select_render_kernels;
+	if (options.generate && generate_levels(&LevelManager, options.seed) != 0)
+	{
+		fprintf(stderr, "Could not generate the levels\n");
+		cleanup(&instance);
+		exit(1);
+	}
 
+	LevelManager.current_Level = sim.state.level - 1;
 	loadCurrentLevel(&LevelManager);
 
-	if (load_enemies(enemies, level, &instance) != 0)
+	/* A client draws the server's enemies, all with one texture */
+	if (options.connectAddress ? load_EnemyTexture(instance.renderer,
+				ENEMY_TEXTURE_PATH, &remoteEnemyTexture, false) != 0 :
+			load_enemies(sim.enemies, sim.state.level, &instance,
+				&sim.state.rng) != 0)
 	{
 		fprintf(stderr, "Could not complete loading the enemies\n");
 		cleanup(&instance);
@@ -337,31 +822,66 @@ int main(void)
 	}
 
 	if ((loadTexture(instance.renderer, "../images/dot.bmp", &objectTexture, false) != 0) ||
-			(loadTexture(instance.renderer, "../images/dot.bmp", &miniTexture, true) != 0) ||
-			(load_wallTexture(instance.renderer, "../images/wall1.png", &wall1Texture) != 0) ||
-			(load_wallTexture(instance.renderer, "../images/floor_Tiles.png", &floorTexture) != 0) ||
-			(load_wallTexture(instance.renderer, "../images/wall1.png", &ceilingTexture) != 0))
+			(loadTexture(instance.renderer, "../images/dot.bmp", &assets.mini, true) != 0) ||
+			(load_wallTexture(instance.renderer, "../images/wall1.png", &assets.wall) != 0) ||
+			(load_wallTexture(instance.renderer, "../images/floor_Tiles.png", &assets.floor) != 0) ||
+			(load_wallTexture(instance.renderer, "../images/wall1.png", &assets.ceiling) != 0))
 	{
 		printf("Failed to load wall texture.\n");
 		cleanup(&instance);
 		exit(1);
 	}
 
+	if (options.goldenDir)
+	{
+		status = run_golden(&instance, &LevelManager, &assets,
+				options.goldenDir, options.goldenCompare, options.tolerance);
+		running = 0;
+	}
 
-	/* Update the object rectangle with the texture's dimensions */
-	object.w = objectTexture.width;
-	object.h = objectTexture.height;
+	if (options.recordPath && start_recording(&recording, options.recordPath,
+				options.seed, sim.state.level,
+				options.generate ? RECORDING_GENERATED : 0) != 0)
+	{
+		cleanup(&instance);
+		exit(1);
+	}
+	if (options.capturePath && start_capture(&capture,
+				options.capturePath, SCREEN_WIDTH, SCREEN_HEIGHT) != 0)
+	{
+		cleanup(&instance);
+		exit(1);
+	}
 
-	/* Update the miniobject rectangle with the texture's dimensions */
-	miniobject.w = miniTexture.width;
-	miniobject.h = miniTexture.height;
+	/* Update the object rectangle with the texture's dimensions */
+	sim.state.player.w = objectTexture.width;
+	sim.state.player.h = objectTexture.height;
+
+	sim.levelManager = &LevelManager;
+	sim.instance = &instance;
+	sim.recording = options.replayPath || options.recordPath ? &recording :
+		NULL;
+	sim.replaying = options.replayPath != NULL;
+	sim.speed = 200;
+	/* A networked game is simulated by the server */
+	if (running && !options.connectAddress && init_simulation(&sim) != 0)
+	{
+		cleanup(&instance);
+		exit(1);
+	}
+	/* A timedemo times one tick per frame, so it keeps them in lockstep */
+	if (running && !options.connectAddress && !options.timedemo &&
+			start_simulation(&sim) != 0)
+	{
+		cleanup(&instance);
+		exit(1);
+	}
 
 	while (running)
 	{
-		Uint32 currentTime = SDL_GetTicks();
-
-		deltaTime = (currentTime - lastFrameTime) / 1000.0f;
-		lastFrameTime = currentTime;
+		Uint64 frameStart = SDL_GetPerformanceCounter();
+		const Snapshot *snapshot;
+		bool current;
 
 		while (SDL_PollEvent(&event))
 		{
@@ -370,101 +890,125 @@ int main(void)
 				running = 0;
 			}
 
-			handleEvent(&event, &object, &objectTexture, speed, &degrees,
-					deltaTime, &isMinimap);
+			/* F2 switches ray casters; it is not part of the simulation */
+			if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F2)
+				fixedPointMode = !fixedPointMode;
+			/* F3 shows the memory use per subsystem */
+			if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3)
+				showMemory = !showMemory;
 
-			/* Update miniobject based on object position */
-			miniobject.x = object.x * MINIMAP_SCALE;
-			miniobject.y = object.y * MINIMAP_SCALE;
+			if (!options.replayPath)
+				handleEvent(&event, &input);
 		}
 
-		/* Clear the window with a grey color */
-		SDL_SetRenderDrawColor(instance.renderer, 128, 128, 128, 255);
-		SDL_RenderClear(instance.renderer);
-
-		renderTopHalf(&instance);
-
-		/* Render the ceiling */
-		if (level >= 5)
+		if (options.connectAddress)
 		{
-			drawCeiling(&instance, object.x, object.y, degrees,
-					&ceilingTexture);
+			if (followServer(&client, &sim.state, &LevelManager, &input) != 0)
+				break;
 		}
-
-		/* Render the floor */
-		if (level >= 3)
-			drawFloor(&instance, object.x, object.y, degrees, &floorTexture);
-
-		/* Main game rendering */
-		render_world(&instance, &rect, false);
-
-		/* Cast rays for lighting effect for main map */
-		castRays(&instance, object.x, object.y, degrees, false,
-				&wall1Texture, level);
-
-		/* Render enemies */
-		numEnemies = 4 * level;
-		/*renderEnemies3D(&instance, enemies, numEnemies, object.x, object.y,
-				degrees);*/
-
-		if (isMinimap)
+		else if (options.timedemo)
 		{
-			/* Minimap rendering */
-			render_world(&instance, &rect, true);
-
-			/* Render the moving miniobject with rotation */
-			SDL_RenderCopyEx(instance.renderer, miniTexture.texture, NULL,
-					&miniobject, degrees, NULL, SDL_FLIP_NONE);
+			send_input(&sim, &input);
+			status = step_simulation(&sim);
+			if (status < 0)
+			{
+				cleanup(&instance);
+				exit(1);
+			}
+			if (status > 0)
+				break;
+		}
+		else
+		{
+			send_input(&sim, &input);
+			service_level_change(&sim);
+			if (!SDL_AtomicGet(&sim.running))
+				break;
+		}
 
-			/* Cast rays for lighting effect in mini_map */
-			castRays(&instance, miniobject.x, miniobject.y, degrees, true,
-					&wall1Texture, level);
+		/*
+		 * Draw the newest tick the simulation or the server has finished.
+		 * A snapshot taken before a level change points at the old level's
+		 * enemy textures, so its enemies wait for the next one
+		 */
+		if (options.connectAddress)
+			renderFrame(&instance, &sim.state, sim.enemies,
+					followEnemies(&client, sim.state.level, sim.enemies,
+						remoteEnemyTexture), &assets);
+		else
+		{
+			snapshot = latest_snapshot(&sim.snapshots);
+			current = snapshot->state.level == LevelManager.current_Level + 1;
+			renderFrame(&instance, &snapshot->state,
+					current ? snapshot->enemies : NULL, snapshot->numEnemies,
+					&assets);
 		}
+		if (options.connectAddress && sim.state.isMinimap)
+			drawRemotePlayers(instance.renderer, &client, &assets.mini);
+		if (showMemory)
+			draw_memory_overlay(instance.renderer);
+
+		/* Read the frame back before presenting leaves it undefined */
+		if (options.capturePath)
+			capture_frame(&capture, instance.renderer);
 
 		/* Present the renderer */
 		SDL_RenderPresent(instance.renderer);
 
-		/* Add a small delay to prevent high CPU usage */
-		SDL_Delay(16); /* Roughly 60 frames per second */
-
-		/* Check for level completion */
-		if (worldMap[object.y / TILE_SIZE][object.x / TILE_SIZE] == 3)
+		if (options.timedemo)
 		{
-			for (i = 0; i < 4 * level; i++)
-			{
-				freeTexture(enemies[i].texture);
-			}
-
-			if (LevelManager.current_Level < 5)
-			{
-				LevelManager.current_Level++;
-				level = LevelManager.current_Level + 1;
-				loadCurrentLevel(&LevelManager);
-				object.x = 80;
-				object.y = 80;
-				degrees = 0;
-				if (load_enemies(enemies, level, &instance) != 0)
-				{
-					fprintf(stderr, "Could not complete loading the enemies\n");
-					cleanup(&instance);
-					exit(1);
-				}
-			}
-			else
-			{
-				printf("You have completed all levels!\n");
-				running = false;
-			}
+			if (frames <= recording.ticks)
+				frameTimes[frames++] = (SDL_GetPerformanceCounter() -
+						frameStart) * 1000.0 / frequency;
+		}
+		else
+		{
+			/* Add a small delay to prevent high CPU usage */
+			SDL_Delay(16); /* Roughly 60 frames per second */
 		}
 	}
 
+	if (options.connectAddress)
+		client_disconnect(&client);
+	/* Write the frames still queued */
+	bool captureFailed = options.capturePath && stop_capture(&capture) != 0;
+
+	stop_simulation(&sim);
+	free_simulation(&sim);
+	if (sim.status < 0)
+	{
+		cleanup(&instance);
+		exit(1);
+	}
+
+	if (options.timedemo)
+	{
+		report_timedemo(frameTimes, frames);
+		report_enemy_lod(&sim.lod);
+		report_explored();
+		mem_free(frameTimes);
+	}
+	if (options.replayPath)
+		close_replay(&recording);
+	if (options.recordPath)
+		stop_recording(&recording);
+
 	freeTexture(&objectTexture);
-	freeTexture(&miniTexture);
-	free_wallTexture(&wall1Texture);
-	free_wallTexture(&floorTexture);
-	free_wallTexture(&ceilingTexture);
+	freeTexture(&assets.mini);
+	free_wallTexture(&assets.wall);
+	free_wallTexture(&assets.floor);
+	free_wallTexture(&assets.ceiling);
+	if (options.connectAddress)
+		mem_destroy_texture(remoteEnemyTexture);
+	else
+		free_enemies(sim.enemies, 4 * sim.state.level);
 	free_LevelManager(&LevelManager);
+	close_asset_pack();
+	free_palette();
+	if (options.memoryPath)
+		mem_write_json(options.memoryPath);
+	mem_report_leaks();
 	cleanup(&instance);
 
-	exit(0);
+	exit((options.goldenDir && status != 0) || captureFailed ? 1 : 0);
 }
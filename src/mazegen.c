@@ -0,0 +1,390 @@
+#include "../headers/mazemania.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * struct MazeBand - Working state for one band of cell rows.
+ * @params: Maze parameters.
+ * @band: Index of the band.
+ * @firstRow: First cell row of the band.
+ * @lastRow: One past the last cell row of the band.
+ * @callback: Receives every finished tile row.
+ * @context: Passed to @callback.
+ * @status: 0 on success, 1 if the band could not allocate its rows.
+ *
+ * Description: Eller's algorithm only ever needs the set labels of the
+ * current row, so every array here is one row wide no matter how tall the
+ * maze is.
+ */
+
+typedef struct MazeBand
+{
+	const MazeParams *params;
+	int band;
+	int firstRow;
+	int lastRow;
+	MazeRowCallback callback;
+	void *context;
+	int status;
+} MazeBand;
+
+/**
+ * findSet - Finds the representative of a cell's set, compressing paths.
+ * @parent: Union-find parent array for the current row.
+ * @cell: The cell.
+ *
+ * Return: The representative cell index.
+ */
+
+static int findSet(int *parent, int cell)
+{
+	while (parent[cell] != cell)
+	{
+		parent[cell] = parent[parent[cell]];
+		cell = parent[cell];
+	}
+	return (cell);
+}
+
+/**
+ * emitRow - Applies the border and hands a tile row to the callback.
+ * @band: The band emitting the row.
+ * @row: Tile row, width tiles.
+ * @y: Tile row index in the whole maze.
+ */
+
+static void emitRow(MazeBand *band, int *row, int y)
+{
+	int width = band->params->width, height = band->params->height, x;
+
+	for (x = 0; x < width; x++)
+	{
+		if (x == 0 || x == width - 1 || y == 0 || y == height - 1)
+			row[x] = 1;
+	}
+	band->callback(row, width, y, band->context);
+}
+
+/**
+ * generateBand - Runs Eller's algorithm over one band of cell rows.
+ * @data: Pointer to the MazeBand.
+ *
+ * The last row of the band joins every remaining set, so each band is a
+ * perfect maze by itself. The wall row below it is then closed except for
+ * one opening, which links the bands into a single perfect maze without
+ * any band having to wait for its neighbours.
+ *
+ * Return: The band's status.
+ */
+
+static int generateBand(void *data)
+{
+	MazeBand *band = data;
+	const MazeParams *params = band->params;
+	int cols = (params->width - 1) / 2, totalRows = (params->height - 1) / 2;
+	int *label = malloc(cols * sizeof(int)), *parent = malloc(cols *
+			sizeof(int)), *stamp = malloc(cols * sizeof(int)), *count =
+		malloc(cols * sizeof(int)), *pick = malloc(cols * sizeof(int)),
+		*used = malloc(cols * sizeof(int));
+	bool *right = malloc(cols * sizeof(bool)), *down = malloc(cols *
+			sizeof(bool)), *hasDown = malloc(cols * sizeof(bool));
+	int *row = malloc(params->width * sizeof(int));
+	int r, c, x, fresh, root;
+	Uint64 rng;
+
+	band->status = 1;
+	if (!label || !parent || !stamp || !count || !pick || !used || !right ||
+			!down || !hasDown || !row)
+		goto done;
+
+	seed_rng(&rng, params->seed + 0x9E3779B97F4A7C15ULL * band->band);
+	for (c = 0; c < cols; c++)
+	{
+		label[c] = c;
+		stamp[c] = -1;
+		used[c] = -1;
+	}
+
+	if (band->firstRow == 0)
+	{
+		for (x = 0; x < params->width; x++)
+			row[x] = 1;
+		emitRow(band, row, 0);
+	}
+
+	for (r = band->firstRow; r < band->lastRow; r++)
+	{
+		bool bandEnd = (r == band->lastRow - 1);
+
+		/* Rebuild the row's union-find from the labels carried down */
+		for (c = 0; c < cols; c++)
+		{
+			if (stamp[label[c]] != r)
+			{
+				stamp[label[c]] = r;
+				pick[label[c]] = c;
+			}
+			parent[c] = pick[label[c]];
+		}
+
+		/* Join neighbours in different sets, all of them on a band's end */
+		for (c = 0; c + 1 < cols; c++)
+		{
+			int a = findSet(parent, c), b = findSet(parent, c + 1);
+
+			right[c] = true;
+			if (a != b && (bandEnd || rng_range(&rng, 2) == 0))
+			{
+				parent[b] = a;
+				right[c] = false;
+			}
+		}
+		right[cols - 1] = true;
+
+		/* Every set must carry on downwards through at least one cell */
+		for (c = 0; c < cols; c++)
+		{
+			count[c] = 0;
+			hasDown[c] = false;
+		}
+		for (c = 0; c < cols; c++)
+		{
+			root = findSet(parent, c);
+			down[c] = !bandEnd && rng_range(&rng, 2) == 0;
+			hasDown[root] |= down[c];
+			if (rng_range(&rng, ++count[root]) == 0)
+				pick[root] = c;
+		}
+		for (c = 0; c < cols && !bandEnd; c++)
+		{
+			root = findSet(parent, c);
+			if (!hasDown[root])
+			{
+				down[pick[root]] = true;
+				hasDown[root] = true;
+			}
+		}
+		if (bandEnd && r < totalRows - 1)
+			down[rng_range(&rng, cols)] = true;
+
+		/* Cell row: floor, exit and spawn tiles, with walls between cells */
+		for (x = 0; x < params->width; x++)
+			row[x] = 2;
+		for (c = 0; c < cols; c++)
+		{
+			row[2 * c + 1] = 0;
+			if (c == cols - 1 && r == totalRows - 1)
+				row[2 * c + 1] = 3;
+			else if ((c > 0 || r > 0) &&
+					rng_range(&rng, 100) < params->spawnPercent)
+				row[2 * c + 1] = 4;
+			if (!right[c])
+				row[2 * c + 2] = 0;
+		}
+		emitRow(band, row, 2 * r + 1);
+
+		/* Wall row below, open where a cell continues downwards */
+		for (x = 0; x < params->width; x++)
+			row[x] = 2;
+		for (c = 0; c < cols; c++)
+		{
+			if (down[c])
+				row[2 * c + 1] = 0;
+		}
+		emitRow(band, row, 2 * r + 2);
+
+		/* Carry labels down; cells that stop get unused labels */
+		for (c = 0; c < cols; c++)
+		{
+			label[c] = down[c] ? findSet(parent, c) : -1;
+			if (label[c] >= 0)
+				used[label[c]] = r;
+		}
+		for (c = 0, fresh = 0; c < cols; c++)
+		{
+			if (label[c] >= 0)
+				continue;
+			while (used[fresh] == r)
+				fresh++;
+			label[c] = fresh;
+			used[fresh] = r;
+		}
+	}
+
+	/* An even height leaves one more border row below the last wall row */
+	if (band->lastRow == totalRows && params->height % 2 == 0)
+	{
+		for (x = 0; x < params->width; x++)
+			row[x] = 1;
+		emitRow(band, row, params->height - 1);
+	}
+	band->status = 0;
+
+done:
+	free(label);
+	free(parent);
+	free(stamp);
+	free(count);
+	free(pick);
+	free(used);
+	free(right);
+	free(down);
+	free(hasDown);
+	free(row);
+	return (band->status);
+}
+
+/**
+ * generate_maze - Generates a maze in parallel bands of rows.
+ * @params: Seed, size in tiles and spawn density.
+ * @numBands: Number of independent bands, each generated on its own thread.
+ * @callback: Called once for every tile row. With more than one band it is
+ * called from several threads at once, but never twice for the same row.
+ * @context: Passed to @callback.
+ *
+ * The maze uses the level tile ids: 1 border, 2 inner wall, 0 floor, 3 exit
+ * in the bottom-right cell and 4 spawn points. The start tile (1, 1) is
+ * floor unless the maze has a single cell. A given seed and band count
+ * always give the same maze.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int generate_maze(const MazeParams *params, int numBands,
+		MazeRowCallback callback, void *context)
+{
+	int totalRows = (params->height - 1) / 2, i, status = 0;
+	MazeBand *bands;
+	SDL_Thread **threads;
+
+	if (params->width < 3 || params->height < 3)
+	{
+		fprintf(stderr, "A maze needs at least 3x3 tiles\n");
+		return (1);
+	}
+	if (numBands < 1)
+		numBands = 1;
+	if (numBands > totalRows)
+		numBands = totalRows;
+
+	bands = calloc(numBands, sizeof(MazeBand));
+	threads = calloc(numBands, sizeof(SDL_Thread *));
+	if (!bands || !threads)
+	{
+		fprintf(stderr, "Failed to allocate maze bands\n");
+		free(bands);
+		free(threads);
+		return (1);
+	}
+
+	for (i = 0; i < numBands; i++)
+	{
+		bands[i].params = params;
+		bands[i].band = i;
+		bands[i].firstRow = (int)((Sint64)totalRows * i / numBands);
+		bands[i].lastRow = (int)((Sint64)totalRows * (i + 1) / numBands);
+		bands[i].callback = callback;
+		bands[i].context = context;
+		if (i > 0)
+			threads[i] = SDL_CreateThread(generateBand, "mazegen", &bands[i]);
+		if (i > 0 && !threads[i])
+			generateBand(&bands[i]);
+	}
+	generateBand(&bands[0]);
+
+	for (i = 0; i < numBands; i++)
+	{
+		if (threads[i])
+			SDL_WaitThread(threads[i], NULL);
+		status |= bands[i].status;
+	}
+	free(bands);
+	free(threads);
+
+	if (status)
+		fprintf(stderr, "Failed to allocate maze rows\n");
+	return (status);
+}
+
+/**
+ * struct MazeFile - Output state shared by every band in write_maze_file.
+ * @fd: Descriptor of the output file.
+ * @width: Maze width in tiles.
+ * @status: Set to 1 by any band whose write fails.
+ */
+
+typedef struct MazeFile
+{
+	int fd;
+	int width;
+	SDL_atomic_t status;
+} MazeFile;
+
+/**
+ * writeMazeRow - Formats a tile row and writes it at its fixed offset.
+ * @row: Tile row.
+ * @width: Number of tiles.
+ * @y: Tile row index.
+ * @context: Pointer to the MazeFile.
+ *
+ * Every row is exactly 2 * width bytes ("d d ... d\n"), which is what lets
+ * bands write their rows concurrently with pwrite and no coordination.
+ */
+
+static void writeMazeRow(const int *row, int width, int y, void *context)
+{
+	MazeFile *maze = context;
+	char text[4096];
+	off_t offset = (off_t)y * 2 * maze->width;
+	int x = 0, length;
+
+	while (x < width)
+	{
+		for (length = 0; x < width && length < (int)sizeof(text); x++)
+		{
+			text[length++] = '0' + row[x];
+			text[length++] = (x == width - 1) ? '\n' : ' ';
+		}
+		if (pwrite(maze->fd, text, length, offset) != length)
+			SDL_AtomicSet(&maze->status, 1);
+		offset += length;
+	}
+}
+
+/**
+ * write_maze_file - Generates a maze straight into a level file.
+ * @params: Seed, size in tiles and spawn density.
+ * @path: Output file, in the worlds.txt format.
+ * @numBands: Number of bands generated in parallel.
+ *
+ * Rows are written as soon as they are generated, so memory use stays
+ * proportional to the maze width.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int write_maze_file(const MazeParams *params, const char *path, int numBands)
+{
+	MazeFile maze;
+	int status;
+
+	maze.width = params->width;
+	SDL_AtomicSet(&maze.status, 0);
+	maze.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (maze.fd < 0)
+	{
+		fprintf(stderr, "Could not create %s\n", path);
+		return (1);
+	}
+
+	status = generate_maze(params, numBands, writeMazeRow, &maze);
+	if (SDL_AtomicGet(&maze.status) != 0)
+	{
+		fprintf(stderr, "Could not write %s\n", path);
+		status = 1;
+	}
+	if (close(maze.fd) != 0)
+		status = 1;
+
+	return (status);
+}
@@ -0,0 +1,71 @@
+#include "../headers/mazemania.h"
+
+/**
+ * main - Entry point of the maze generator tool.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: mazegen [--seed N] [--size WxH] [--spawns PERCENT] [--threads N]
+ * OUTPUT. The output uses the worlds.txt tile format and is written row by
+ * row while the maze is generated, so its size is only limited by the disk.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int main(int argc, char *argv[])
+{
+	MazeParams params;
+	const char *path = NULL;
+	int threads = SDL_GetCPUCount(), i, status;
+	Uint64 start;
+
+	params.seed = 1;
+	params.width = mapWidth;
+	params.height = mapHeight;
+	params.spawnPercent = 10;
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			params.seed = strtoull(argv[++i], NULL, 0);
+		}
+		else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc &&
+				sscanf(argv[i + 1], "%dx%d", &params.width,
+					&params.height) == 2)
+		{
+			i++;
+		}
+		else if (strcmp(argv[i], "--spawns") == 0 && i + 1 < argc)
+		{
+			params.spawnPercent = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (argv[i][0] != '-' && !path)
+		{
+			path = argv[i];
+		}
+		else
+		{
+			path = NULL;
+			break;
+		}
+	}
+	if (!path)
+	{
+		fprintf(stderr, "Usage: %s [--seed N] [--size WxH] [--spawns PERCENT] "
+				"[--threads N] OUTPUT\n", argv[0]);
+		return (1);
+	}
+
+	start = SDL_GetPerformanceCounter();
+	status = write_maze_file(&params, path, threads);
+	if (status == 0)
+		printf("Wrote %dx%d maze to %s in %.2f s\n", params.width,
+				params.height, path, (double)(SDL_GetPerformanceCounter() -
+					start) / SDL_GetPerformanceFrequency());
+
+	return (status);
+}
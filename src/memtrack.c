@@ -0,0 +1,317 @@
+#include "../headers/mazemania.h"
+
+/**
+ * union MemHeader - Bookkeeping stored in front of each tracked block.
+ * @info: Size and tag of the block.
+ * @align: Keeps the block behind the header aligned like malloc's.
+ */
+
+typedef union MemHeader
+{
+	struct
+	{
+		size_t size;
+		int tag;
+	} info;
+	max_align_t align;
+} MemHeader;
+
+/**
+ * struct MemTexture - A tracked texture.
+ * @texture: The texture.
+ * @tag: Subsystem it belongs to.
+ * @bytes: Size of its pixels.
+ */
+
+typedef struct MemTexture
+{
+	SDL_Texture *texture;
+	int tag;
+	Sint64 bytes;
+} MemTexture;
+
+static const char *const tagNames[MEM_TAGS] = {
+	"levels", "textures", "enemies", "render", "simulation"
+};
+
+/* Allocations happen while loading, never per pixel, so one lock will do */
+static SDL_SpinLock lock;
+static MemUsage usage[MEM_TAGS];
+static MemTexture textures[MEM_MAX_TEXTURES];
+static int numTextures;
+
+/**
+ * account - Adds to or removes from a tag's usage.
+ * @tag: The tag.
+ * @bytes: Bytes allocated, negative when freed.
+ * @blocks: Change in the number of heap blocks.
+ * @created: Change in the number of textures.
+ *
+ * The caller holds the lock.
+ */
+
+static void account(int tag, Sint64 bytes, int blocks, int created)
+{
+	MemUsage *entry = &usage[tag];
+
+	entry->live += bytes;
+	entry->blocks += blocks;
+	entry->textures += created;
+	if (entry->live > entry->peak)
+		entry->peak = entry->live;
+}
+
+/**
+ * mem_alloc - Allocates memory on behalf of a subsystem.
+ * @tag: The subsystem, one of the MEM_ tags.
+ * @size: Bytes to allocate.
+ *
+ * The block is counted against @tag until it is passed to mem_free.
+ *
+ * Return: The block, or NULL if it could not be allocated.
+ */
+
+void *mem_alloc(int tag, size_t size)
+{
+	MemHeader *header = malloc(sizeof(MemHeader) + size);
+
+	if (!header)
+		return (NULL);
+	header->info.size = size;
+	header->info.tag = tag;
+
+	SDL_AtomicLock(&lock);
+	account(tag, size, 1, 0);
+	SDL_AtomicUnlock(&lock);
+
+	return (header + 1);
+}
+
+/**
+ * mem_calloc - Allocates zeroed memory on behalf of a subsystem.
+ * @tag: The subsystem.
+ * @count: Number of elements.
+ * @size: Size of one element.
+ *
+ * Return: The block, or NULL if it could not be allocated.
+ */
+
+void *mem_calloc(int tag, size_t count, size_t size)
+{
+	void *block;
+
+	if (size != 0 && count > ((size_t)-1 - sizeof(MemHeader)) / size)
+		return (NULL);
+	block = mem_alloc(tag, count * size);
+	if (block)
+		memset(block, 0, count * size);
+
+	return (block);
+}
+
+/**
+ * mem_free - Frees a block from mem_alloc or mem_calloc.
+ * @block: The block, or NULL.
+ */
+
+void mem_free(void *block)
+{
+	MemHeader *header = block;
+
+	if (!block)
+		return;
+	header--;
+
+	SDL_AtomicLock(&lock);
+	account(header->info.tag, -(Sint64)header->info.size, -1, 0);
+	SDL_AtomicUnlock(&lock);
+	free(header);
+}
+
+/**
+ * trackTexture - Counts a new texture against a subsystem.
+ * @tag: The subsystem.
+ * @texture: The texture, or NULL if creating it failed.
+ *
+ * Return: @texture.
+ */
+
+static SDL_Texture *trackTexture(int tag, SDL_Texture *texture)
+{
+	Uint32 format;
+	int width, height;
+	Sint64 bytes = 0;
+
+	if (!texture)
+		return (NULL);
+	if (SDL_QueryTexture(texture, &format, NULL, &width, &height) == 0)
+		bytes = (Sint64)width * height * SDL_BYTESPERPIXEL(format);
+
+	SDL_AtomicLock(&lock);
+	if (numTextures < MEM_MAX_TEXTURES)
+	{
+		textures[numTextures].texture = texture;
+		textures[numTextures].tag = tag;
+		textures[numTextures].bytes = bytes;
+		numTextures++;
+		account(tag, bytes, 0, 1);
+	}
+	SDL_AtomicUnlock(&lock);
+
+	return (texture);
+}
+
+/**
+ * mem_texture_from_surface - Creates a texture on behalf of a subsystem.
+ * @tag: The subsystem.
+ * @renderer: The renderer.
+ * @surface: Pixels of the texture.
+ *
+ * The texture's pixels are counted against @tag until it is passed to
+ * mem_destroy_texture.
+ *
+ * Return: The texture, or NULL on failure.
+ */
+
+SDL_Texture *mem_texture_from_surface(int tag, SDL_Renderer *renderer,
+		SDL_Surface *surface)
+{
+	return (trackTexture(tag, SDL_CreateTextureFromSurface(renderer,
+					surface)));
+}
+
+/**
+ * mem_create_texture - Creates an empty texture on behalf of a subsystem.
+ * @tag: The subsystem.
+ * @renderer: The renderer.
+ * @format: Pixel format.
+ * @access: SDL_TEXTUREACCESS_ value.
+ * @width: Width in pixels.
+ * @height: Height in pixels.
+ *
+ * Return: The texture, or NULL on failure.
+ */
+
+SDL_Texture *mem_create_texture(int tag, SDL_Renderer *renderer,
+		Uint32 format, int access, int width, int height)
+{
+	return (trackTexture(tag, SDL_CreateTexture(renderer, format, access,
+					width, height)));
+}
+
+/**
+ * mem_destroy_texture - Destroys a texture and stops counting it.
+ * @texture: The texture, or NULL.
+ */
+
+void mem_destroy_texture(SDL_Texture *texture)
+{
+	int i;
+
+	if (!texture)
+		return;
+
+	SDL_AtomicLock(&lock);
+	for (i = 0; i < numTextures; i++)
+	{
+		if (textures[i].texture != texture)
+			continue;
+		account(textures[i].tag, -textures[i].bytes, 0, -1);
+		textures[i] = textures[--numTextures];
+		break;
+	}
+	SDL_AtomicUnlock(&lock);
+	SDL_DestroyTexture(texture);
+}
+
+/**
+ * mem_tag_name - Names a subsystem.
+ * @tag: The subsystem.
+ *
+ * Return: Its name, as used in reports.
+ */
+
+const char *mem_tag_name(int tag)
+{
+	return (tagNames[tag]);
+}
+
+/**
+ * mem_usage - Reads a subsystem's memory use.
+ * @tag: The subsystem.
+ * @out: Receives the usage.
+ */
+
+void mem_usage(int tag, MemUsage *out)
+{
+	SDL_AtomicLock(&lock);
+	*out = usage[tag];
+	SDL_AtomicUnlock(&lock);
+}
+
+/**
+ * mem_report_leaks - Prints what is still allocated.
+ *
+ * Call once everything has been freed; any memory or texture still
+ * counted then was leaked.
+ *
+ * Return: 0 if nothing leaked, 1 otherwise.
+ */
+
+int mem_report_leaks(void)
+{
+	MemUsage entry;
+	int tag, leaked = 0;
+
+	for (tag = 0; tag < MEM_TAGS; tag++)
+	{
+		mem_usage(tag, &entry);
+		if (entry.blocks == 0 && entry.textures == 0)
+			continue;
+		fprintf(stderr, "Leaked %lld bytes of %s in %d blocks and %d "
+				"textures\n", (long long)entry.live, tagNames[tag],
+				entry.blocks, entry.textures);
+		leaked = 1;
+	}
+
+	return (leaked);
+}
+
+/**
+ * mem_write_json - Writes every subsystem's memory use as JSON.
+ * @path: File to write.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int mem_write_json(const char *path)
+{
+	FILE *file = fopen(path, "w");
+	MemUsage entry;
+	int tag, status;
+
+	if (!file)
+	{
+		fprintf(stderr, "Could not create %s\n", path);
+		return (1);
+	}
+
+	fputs("{\"tags\": [", file);
+	for (tag = 0; tag < MEM_TAGS; tag++)
+	{
+		mem_usage(tag, &entry);
+		fprintf(file, "%s{\"name\": \"%s\", \"live\": %lld, \"peak\": %lld, "
+				"\"blocks\": %d, \"textures\": %d}", tag ? ", " : "",
+				tagNames[tag], (long long)entry.live, (long long)entry.peak,
+				entry.blocks, entry.textures);
+	}
+	fputs("]}\n", file);
+
+	status = ferror(file) != 0;
+	if (fclose(file) != 0)
+		status = 1;
+	if (status)
+		fprintf(stderr, "Could not write %s\n", path);
+
+	return (status);
+}
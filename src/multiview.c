@@ -0,0 +1,210 @@
+#include "../headers/mazemania.h"
+
+/*
+ * One packet holds RAY_PACKET adjacent columns of a view. The stepping of
+ * every lane is done with GCC vector types, so each DDA step is a handful
+ * of packed compares and masked adds; only the map lookups, which gather
+ * from different tiles, are done lane by lane.
+ */
+typedef float RayPacketF __attribute__((vector_size(RAY_PACKET *
+				sizeof(float))));
+typedef Sint32 RayPacketI __attribute__((vector_size(RAY_PACKET *
+				sizeof(Sint32))));
+
+/**
+ * recordHit - Stores the hit of one column of a view.
+ * @view: The view.
+ * @ray: Column within the view.
+ * @angle: Ray angle in degrees.
+ * @offset: Angle of the ray relative to the view direction, in degrees.
+ * @distance: Distance along the ray in world pixels, INFINITY for a miss.
+ * @vertical: Non-zero if the ray crossed a vertical grid line last.
+ * @tileX: Column of the tile hit, ignored for a miss.
+ * @tileY: Row of the tile hit, ignored for a miss.
+ *
+ * Fields follow castSingleRay, so the wall kernels, sprite occlusion and the
+ * mini-map read a view's hits like the main camera's.
+ */
+
+static void recordHit(const CameraView *view, int ray, float angle,
+		float offset, float distance, int vertical, int tileX, int tileY)
+{
+	RayHits *hits = view->hits;
+	float projection = (view->viewport.w / 2) /
+		tan(DEG_TO_RAD(FOV_ANGLE) / 2), perpDistance, hit;
+
+	hits->angle[ray] = angle;
+	if (distance == INFINITY)
+	{
+		hits->distance[ray] = INFINITY;
+		hits->perpDistance[ray] = INFINITY;
+		hits->wallHeight[ray] = 0;
+		hits->texX[ray] = 0;
+		hits->tileX[ray] = NO_TILE;
+		hits->tileY[ray] = NO_TILE;
+		hits->tile[ray] = 0;
+		hits->verticalRay[ray] = 0;
+		return;
+	}
+
+	perpDistance = distance * cosf(DEG_TO_RAD(offset));
+	hit = vertical ? view->y + distance * sinf(DEG_TO_RAD(angle)) :
+		view->x + distance * cosf(DEG_TO_RAD(angle));
+	hits->distance[ray] = distance;
+	hits->perpDistance[ray] = perpDistance;
+	hits->wallHeight[ray] = (int)((TILE_SIZE / perpDistance) * projection);
+	hits->texX[ray] = (int)hit % TILE_SIZE;
+	hits->tileX[ray] = tileX;
+	hits->tileY[ray] = tileY;
+	hits->tile[ray] = view->map[tileY][tileX];
+	hits->verticalRay[ray] = vertical != 0;
+}
+
+/**
+ * castPacket - Traces RAY_PACKET adjacent columns of a view together.
+ * @view: The view.
+ * @first: First column of the packet.
+ *
+ * Every lane walks the grid with a DDA: the lane whose next vertical grid
+ * line is nearer than its next horizontal one steps in x, the others in y;
+ * a lane passing exactly through a grid corner steps in both, slipping
+ * between two diagonal walls as castSingleRay's rays do. Lanes past the edge of the viewport start inactive; a lane drops out
+ * when it meets a wall, tile 1 or 2 as in castSingleRay, or leaves the
+ * map, and the packet is done when every lane has.
+ */
+
+static void castPacket(const CameraView *view, int first)
+{
+	RayPacketF sideX, sideY, deltaX, deltaY;
+	RayPacketI mapX, mapY, stepX, stepY, active, vertical, moveX, moveY;
+	float angle[RAY_PACKET], offset[RAY_PACKET], dirX, dirY;
+	float originX = view->x / TILE_SIZE, originY = view->y / TILE_SIZE;
+	float increment = FOV_ANGLE / (float)view->viewport.w;
+	int startX = (int)originX, startY = (int)originY;
+	int lane, remaining = 0, tile;
+
+	for (lane = 0; lane < RAY_PACKET; lane++)
+	{
+		offset[lane] = -(FOV_ANGLE / 2.0f) + (first + lane) * increment;
+		angle[lane] = fmod(view->rotation + offset[lane], 360);
+		if (angle[lane] < 0)
+			angle[lane] += 360;
+		dirX = cosf(DEG_TO_RAD(angle[lane]));
+		dirY = sinf(DEG_TO_RAD(angle[lane]));
+
+		active[lane] = first + lane < view->viewport.w ? -1 : 0;
+		remaining += active[lane] != 0;
+		mapX[lane] = startX;
+		mapY[lane] = startY;
+		deltaX[lane] = fabsf(dirX) < 1e-6f ? 1e30f : fabsf(1 / dirX);
+		deltaY[lane] = fabsf(dirY) < 1e-6f ? 1e30f : fabsf(1 / dirY);
+		stepX[lane] = dirX < 0 ? -1 : 1;
+		stepY[lane] = dirY < 0 ? -1 : 1;
+		sideX[lane] = (dirX < 0 ? originX - startX : startX + 1 - originX) *
+			deltaX[lane];
+		sideY[lane] = (dirY < 0 ? originY - startY : startY + 1 - originY) *
+			deltaY[lane];
+	}
+
+	while (remaining > 0)
+	{
+		vertical = sideX <= sideY;
+		moveX = vertical & active;
+		moveY = (sideY <= sideX) & active;
+		mapX += stepX & moveX;
+		mapY += stepY & moveY;
+		sideX += (RayPacketF)((RayPacketI)deltaX & moveX);
+		sideY += (RayPacketF)((RayPacketI)deltaY & moveY);
+
+		for (lane = 0; lane < RAY_PACKET; lane++)
+		{
+			if (!active[lane])
+				continue;
+			if (mapX[lane] < 0 || mapX[lane] >= mapWidth || mapY[lane] < 0 ||
+					mapY[lane] >= mapHeight)
+			{
+				recordHit(view, first + lane, angle[lane], offset[lane],
+						INFINITY, 0, 0, 0);
+			}
+			else
+			{
+				tile = view->map[mapY[lane]][mapX[lane]];
+				if (tile != 1 && tile != 2)
+					continue;
+				recordHit(view, first + lane, angle[lane], offset[lane],
+						(vertical[lane] ? sideX[lane] - deltaX[lane] :
+						 sideY[lane] - deltaY[lane]) * TILE_SIZE,
+						vertical[lane], mapX[lane], mapY[lane]);
+			}
+			active[lane] = 0;
+			remaining--;
+		}
+	}
+}
+
+/**
+ * cast_views - Casts the rays of several cameras in one call.
+ * @views: The cameras; each one's hits are written to its own buffer.
+ * @count: Number of cameras.
+ *
+ * A view casts viewport.w rays, at most NUM_RAYS, spread over FOV_ANGLE
+ * like castRays spreads them over the screen, so a full-screen view of
+ * worldMap gives the same hits as castRays. Rays are traced in packets of
+ * RAY_PACKET adjacent columns, which share their start tile and mostly
+ * their path, so split-screen players and batches of small agent views
+ * cost one pass over the grid per packet rather than per ray.
+ */
+
+void cast_views(CameraView *views, int count)
+{
+	int i, first;
+
+	for (i = 0; i < count; i++)
+	{
+		if (views[i].viewport.w > NUM_RAYS)
+			views[i].viewport.w = NUM_RAYS;
+		for (first = 0; first < views[i].viewport.w; first += RAY_PACKET)
+			castPacket(&views[i], first);
+	}
+}
+
+/**
+ * shade_views - Draws flat-shaded walls of cast views into a framebuffer.
+ * @framebuffer: ARGB8888 pixels every viewport lies in.
+ * @pitch: Row length of @framebuffer in pixels.
+ * @views: Views already cast with cast_views.
+ * @count: Number of views.
+ *
+ * Each view fills its own viewport with the ceiling, its walls in
+ * drawWallSlice's two side colours and the floor, row by row so the
+ * framebuffer is written sequentially.
+ */
+
+void shade_views(Uint32 *framebuffer, int pitch, const CameraView *views,
+		int count)
+{
+	const CameraView *view;
+	Uint32 *row, wall;
+	int i, x, y, top;
+
+	for (i = 0; i < count; i++)
+	{
+		view = &views[i];
+		for (y = 0; y < view->viewport.h; y++)
+		{
+			row = framebuffer + (size_t)(view->viewport.y + y) * pitch +
+				view->viewport.x;
+			for (x = 0; x < view->viewport.w; x++)
+			{
+				top = (view->viewport.h - view->hits->wallHeight[x]) / 2;
+				wall = view->hits->verticalRay[x] ? 0xFFFFFDD0 : 0xFF404040;
+				if (y < top)
+					row[x] = 0xFF202020;
+				else if (y < top + view->hits->wallHeight[x])
+					row[x] = wall;
+				else
+					row[x] = 0xFF606060;
+			}
+		}
+	}
+}
@@ -0,0 +1,432 @@
+#include "../headers/mazemania.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * net_open_socket - Opens a non-blocking UDP socket.
+ * @port: Port to bind, host byte order; 0 lets the system pick one.
+ *
+ * Return: The socket, or -1 on failure.
+ */
+
+int net_open_socket(Uint16 port)
+{
+	struct sockaddr_in address;
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+	if (fd < 0)
+	{
+		perror("socket");
+		return (-1);
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+	{
+		fprintf(stderr, "Could not open UDP port %u: %s\n", port,
+				strerror(errno));
+		close(fd);
+		return (-1);
+	}
+
+	return (fd);
+}
+
+/**
+ * net_resolve - Looks up a server address.
+ * @name: HOST or HOST:PORT; the port defaults to NET_PORT.
+ * @host: Receives the IPv4 address, network byte order.
+ * @port: Receives the port, network byte order.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int net_resolve(const char *name, Uint32 *host, Uint16 *port)
+{
+	struct addrinfo hints, *result;
+	char hostName[256];
+	const char *colon = strrchr(name, ':');
+	size_t length = colon ? (size_t)(colon - name) : strlen(name);
+	int number = colon ? atoi(colon + 1) : NET_PORT;
+
+	if (length == 0 || length >= sizeof(hostName) || number <= 0 ||
+			number > 65535)
+	{
+		fprintf(stderr, "Invalid server address %s\n", name);
+		return (1);
+	}
+	memcpy(hostName, name, length);
+	hostName[length] = '\0';
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo(hostName, NULL, &hints, &result) != 0)
+	{
+		fprintf(stderr, "Could not resolve %s\n", hostName);
+		return (1);
+	}
+	*host = ((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+	*port = htons(number);
+	freeaddrinfo(result);
+
+	return (0);
+}
+
+/**
+ * net_send - Sends a packet.
+ * @socket: UDP socket.
+ * @host: Destination IPv4 address, network byte order.
+ * @port: Destination port, network byte order.
+ * @packet: Packet written with write_bits; partial bytes are sent whole.
+ *
+ * Return: Bytes sent, or 0 if the packet overflowed or could not be sent.
+ */
+
+int net_send(int socket, Uint32 host, Uint16 port, const BitPacker *packet)
+{
+	struct sockaddr_in address;
+	int size = (packet->bits + 7) / 8;
+
+	if (packet->overflow)
+		return (0);
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = host;
+	address.sin_port = port;
+	if (sendto(socket, packet->data, size, 0, (struct sockaddr *)&address,
+				sizeof(address)) != size)
+		return (0);
+	return (size);
+}
+
+/**
+ * net_receive - Takes the next waiting packet, if any.
+ * @socket: UDP socket.
+ * @data: Receives the packet.
+ * @capacity: Size of @data.
+ * @host: Receives the sender's IPv4 address, network byte order.
+ * @port: Receives the sender's port, network byte order.
+ *
+ * Return: Size of the packet, or -1 if none is waiting.
+ */
+
+int net_receive(int socket, Uint8 *data, int capacity, Uint32 *host,
+		Uint16 *port)
+{
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+	ssize_t size = recvfrom(socket, data, capacity, 0,
+			(struct sockaddr *)&address, &length);
+
+	if (size < 0)
+		return (-1);
+	*host = address.sin_addr.s_addr;
+	*port = address.sin_port;
+	return ((int)size);
+}
+
+/**
+ * init_bits - Starts reading or writing a packet.
+ * @packer: The packer.
+ * @data: Packet bytes.
+ * @capacity: Size of @data in bytes.
+ */
+
+void init_bits(BitPacker *packer, Uint8 *data, int capacity)
+{
+	packer->data = data;
+	packer->capacity = capacity;
+	packer->bits = 0;
+	packer->overflow = false;
+}
+
+/**
+ * write_bits - Appends the low bits of a value, least significant first.
+ * @packer: The packer.
+ * @value: Value to write.
+ * @count: Number of bits, 1 to 32.
+ */
+
+void write_bits(BitPacker *packer, Uint32 value, int count)
+{
+	int byte, offset, take;
+
+	if (packer->overflow || packer->bits + count > packer->capacity * 8)
+	{
+		packer->overflow = true;
+		return;
+	}
+
+	while (count > 0)
+	{
+		byte = packer->bits >> 3;
+		offset = packer->bits & 7;
+		take = 8 - offset < count ? 8 - offset : count;
+		if (offset == 0)
+			packer->data[byte] = 0;
+		packer->data[byte] |= (value & ((1u << take) - 1)) << offset;
+		value >>= take;
+		count -= take;
+		packer->bits += take;
+	}
+}
+
+/**
+ * read_bits - Reads a field written by write_bits.
+ * @packer: The packer.
+ * @count: Number of bits, 1 to 32.
+ *
+ * Return: The value, or 0 once the packet has been overrun.
+ */
+
+Uint32 read_bits(BitPacker *packer, int count)
+{
+	Uint32 value = 0;
+	int byte, offset, take, shift = 0;
+
+	if (packer->overflow || packer->bits + count > packer->capacity * 8)
+	{
+		packer->overflow = true;
+		return (0);
+	}
+
+	while (count > 0)
+	{
+		byte = packer->bits >> 3;
+		offset = packer->bits & 7;
+		take = 8 - offset < count ? 8 - offset : count;
+		value |= (Uint32)((packer->data[byte] >> offset) &
+				((1u << take) - 1)) << shift;
+		shift += take;
+		count -= take;
+		packer->bits += take;
+	}
+	return (value);
+}
+
+/**
+ * write_header - Starts a packet of the given type.
+ * @packer: The packer, empty.
+ * @type: One of the NET_ packet types.
+ */
+
+void write_header(BitPacker *packer, int type)
+{
+	write_bits(packer, NET_MAGIC, 16);
+	write_bits(packer, NET_VERSION, 8);
+	write_bits(packer, type, 8);
+}
+
+/**
+ * read_header - Checks a packet's header.
+ * @packer: The packer, at the start of the packet.
+ *
+ * Return: The packet type, or -1 if it is not one of ours.
+ */
+
+int read_header(BitPacker *packer)
+{
+	Uint32 magic = read_bits(packer, 16), version = read_bits(packer, 8);
+	int type = read_bits(packer, 8);
+
+	if (packer->overflow || magic != NET_MAGIC || version != NET_VERSION)
+		return (-1);
+	return (type);
+}
+
+/**
+ * writeDelta - Writes a 16-bit field against its baseline value.
+ * @packer: The packer.
+ * @value: The field.
+ * @base: The field in the baseline.
+ *
+ * An unchanged field costs one bit and a small change, the common case
+ * for positions and angles between two ticks, nine; anything else is
+ * sent whole. Differences wrap at 16 bits, so angles crossing zero stay
+ * small.
+ */
+
+static void writeDelta(BitPacker *packer, Uint16 value, Uint16 base)
+{
+	Sint16 difference = (Sint16)(Uint16)(value - base);
+
+	if (difference == 0)
+	{
+		write_bits(packer, 0, 1);
+		return;
+	}
+	write_bits(packer, 1, 1);
+	if (difference >= -64 && difference < 64)
+	{
+		write_bits(packer, 1, 1);
+		write_bits(packer, difference + 64, 7);
+	}
+	else
+	{
+		write_bits(packer, 0, 1);
+		write_bits(packer, value, 16);
+	}
+}
+
+/**
+ * readDelta - Reads a field written by writeDelta.
+ * @packer: The packer.
+ * @base: The field in the baseline.
+ *
+ * Return: The field.
+ */
+
+static Uint16 readDelta(BitPacker *packer, Uint16 base)
+{
+	if (!read_bits(packer, 1))
+		return (base);
+	if (read_bits(packer, 1))
+		return ((Uint16)(base + (int)read_bits(packer, 7) - 64));
+	return ((Uint16)read_bits(packer, 16));
+}
+
+/**
+ * samePlayer - Compares two player records field by field.
+ * @a: A player.
+ * @b: Another player.
+ *
+ * Return: true if they are equal.
+ */
+
+static bool samePlayer(const NetPlayer *a, const NetPlayer *b)
+{
+	return (a->active == b->active && a->x == b->x && a->y == b->y &&
+			a->angle == b->angle);
+}
+
+/**
+ * encode_world - Writes a snapshot as a delta against a baseline.
+ * @packer: The packer.
+ * @world: The snapshot.
+ * @base: The newest snapshot the client acknowledged, or an empty world
+ * to send everything.
+ *
+ * Every record starts with one bit telling whether it changed, and every
+ * field of a changed record is written with writeDelta, so a tick in
+ * which a few players walk costs a few bytes per walker.
+ */
+
+void encode_world(BitPacker *packer, const NetWorld *world,
+		const NetWorld *base)
+{
+	const NetEnemy *enemy, *old;
+	int i;
+
+	write_bits(packer, world->level != base->level, 1);
+	if (world->level != base->level)
+		write_bits(packer, world->level, 8);
+	write_bits(packer, world->numEnemies != base->numEnemies, 1);
+	if (world->numEnemies != base->numEnemies)
+		write_bits(packer, world->numEnemies, 8);
+
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		if (samePlayer(&world->players[i], &base->players[i]))
+		{
+			write_bits(packer, 0, 1);
+			continue;
+		}
+		write_bits(packer, 1, 1);
+		write_bits(packer, world->players[i].active, 1);
+		if (!world->players[i].active)
+			continue;
+		writeDelta(packer, world->players[i].x, base->players[i].x);
+		writeDelta(packer, world->players[i].y, base->players[i].y);
+		writeDelta(packer, world->players[i].angle, base->players[i].angle);
+	}
+
+	for (i = 0; i < world->numEnemies; i++)
+	{
+		enemy = &world->enemies[i];
+		old = &base->enemies[i];
+		if (enemy->x == old->x && enemy->y == old->y &&
+				enemy->health == old->health)
+		{
+			write_bits(packer, 0, 1);
+			continue;
+		}
+		write_bits(packer, 1, 1);
+		writeDelta(packer, enemy->x, old->x);
+		writeDelta(packer, enemy->y, old->y);
+		write_bits(packer, enemy->health != old->health, 1);
+		if (enemy->health != old->health)
+			write_bits(packer, enemy->health, 8);
+	}
+}
+
+/**
+ * decode_world - Reads a snapshot written by encode_world.
+ * @packer: The packer.
+ * @world: Receives the snapshot; its tick is left to the caller.
+ * @base: The baseline it was encoded against.
+ *
+ * Records the sender leaves out, inactive players and enemies past the
+ * count, are cleared rather than kept from @base, so both sides hold the
+ * same bytes for the next delta.
+ *
+ * Return: 0 on success, 1 if the packet is malformed.
+ */
+
+int decode_world(BitPacker *packer, NetWorld *world, const NetWorld *base)
+{
+	NetPlayer *player;
+	NetEnemy *enemy;
+	int i;
+
+	*world = *base;
+	if (read_bits(packer, 1))
+		world->level = read_bits(packer, 8);
+	if (read_bits(packer, 1))
+		world->numEnemies = read_bits(packer, 8);
+	if (world->numEnemies > MAX_ENEMIES)
+		return (1);
+
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		if (!read_bits(packer, 1))
+			continue;
+		player = &world->players[i];
+		player->active = read_bits(packer, 1);
+		if (!player->active)
+		{
+			memset(player, 0, sizeof(*player));
+			continue;
+		}
+		player->x = (Sint16)readDelta(packer, player->x);
+		player->y = (Sint16)readDelta(packer, player->y);
+		player->angle = readDelta(packer, player->angle);
+	}
+
+	for (i = 0; i < MAX_ENEMIES; i++)
+	{
+		enemy = &world->enemies[i];
+		if (i >= world->numEnemies)
+		{
+			memset(enemy, 0, sizeof(*enemy));
+			continue;
+		}
+		if (!read_bits(packer, 1))
+			continue;
+		enemy->x = (Sint16)readDelta(packer, enemy->x);
+		enemy->y = (Sint16)readDelta(packer, enemy->y);
+		if (read_bits(packer, 1))
+			enemy->health = read_bits(packer, 8);
+	}
+
+	return (packer->overflow ? 1 : 0);
+}
@@ -0,0 +1,204 @@
+#include "../headers/mazemania.h"
+#include <unistd.h>
+
+/* Baseline of snapshots the server sent whole */
+static const NetWorld emptyWorld;
+
+/**
+ * client_connect - Joins a server.
+ * @client: Receives the connection.
+ * @address: HOST or HOST:PORT of the server.
+ *
+ * The request is repeated every 100 ms for two seconds, since either it
+ * or the welcome may be lost.
+ *
+ * Return: 0 once welcomed, 1 on failure.
+ */
+
+int client_connect(NetClient *client, const char *address)
+{
+	Uint8 data[NET_MAX_PACKET];
+	BitPacker packet;
+	Uint32 host;
+	Uint16 port;
+	int attempt, wait, size, type;
+
+	memset(client, 0, sizeof(*client));
+	client->id = -1;
+	client->socket = -1;
+	if (net_resolve(address, &client->host, &client->port) != 0)
+		return (1);
+	client->socket = net_open_socket(0);
+	if (client->socket < 0)
+		return (1);
+
+	for (attempt = 0; attempt < 20; attempt++)
+	{
+		init_bits(&packet, data, sizeof(data));
+		write_header(&packet, NET_CONNECT);
+		net_send(client->socket, client->host, client->port, &packet);
+
+		for (wait = 0; wait < 20; wait++)
+		{
+			SDL_Delay(5);
+			while ((size = net_receive(client->socket, data, sizeof(data),
+							&host, &port)) >= 0)
+			{
+				if (host != client->host || port != client->port)
+					continue;
+				init_bits(&packet, data, size);
+				type = read_header(&packet);
+				if (type == NET_REFUSED)
+				{
+					fprintf(stderr, "Server %s is full\n", address);
+					client_disconnect(client);
+					return (1);
+				}
+				if (type != NET_WELCOME)
+					continue;
+				client->id = read_bits(&packet, 8);
+				client->seed = read_bits(&packet, 32);
+				client->seed |= (Uint64)read_bits(&packet, 32) << 32;
+				client->generate = read_bits(&packet, 1);
+				client->lastHeard = SDL_GetTicks();
+				if (!packet.overflow && client->id < NET_MAX_PLAYERS)
+					return (0);
+			}
+		}
+	}
+
+	fprintf(stderr, "No answer from server %s\n", address);
+	client_disconnect(client);
+	return (1);
+}
+
+/**
+ * receiveSnapshot - Decodes one snapshot packet.
+ * @client: The connection.
+ * @packet: The packet, past its header.
+ * @size: Size of the packet in bytes.
+ *
+ * Snapshots older than the newest one are dropped, as are deltas against a
+ * snapshot that is no longer, or never was, in the history; the server
+ * falls back to a whole snapshot once our acknowledgement gets too old.
+ *
+ * Return: 1 if a new snapshot was decoded, 0 otherwise.
+ */
+
+static int receiveSnapshot(NetClient *client, BitPacker *packet, int size)
+{
+	const NetWorld *base = &emptyWorld;
+	NetWorld world;
+	Uint32 tick = read_bits(packet, 32), baseTick = read_bits(packet, 32);
+
+	if (packet->overflow || tick == 0 || tick <= client->latest)
+		return (0);
+	if (baseTick != 0)
+	{
+		base = &client->history[baseTick % NET_HISTORY];
+		if (base->tick != baseTick)
+		{
+			client->undecodable++;
+			return (0);
+		}
+	}
+	if (decode_world(packet, &world, base) != 0)
+	{
+		client->undecodable++;
+		return (0);
+	}
+
+	world.tick = tick;
+	client->history[tick % NET_HISTORY] = world;
+	client->latest = tick;
+	client->lastHeard = SDL_GetTicks();
+	client->bytesReceived += size;
+	client->snapshots++;
+	client->deltas += baseTick != 0;
+	return (1);
+}
+
+/**
+ * client_poll - Takes every packet waiting from the server.
+ * @client: The connection.
+ *
+ * Return: Number of new snapshots decoded.
+ */
+
+int client_poll(NetClient *client)
+{
+	Uint8 data[NET_MAX_PACKET];
+	BitPacker packet;
+	Uint32 host;
+	Uint16 port;
+	int size, decoded = 0;
+
+	while ((size = net_receive(client->socket, data, sizeof(data), &host,
+					&port)) >= 0)
+	{
+		if (host != client->host || port != client->port)
+			continue;
+		init_bits(&packet, data, size);
+		if (read_header(&packet) == NET_SNAPSHOT)
+			decoded += receiveSnapshot(client, &packet, size);
+	}
+	return (decoded);
+}
+
+/**
+ * client_send_input - Sends this tick's input bits to the server.
+ * @client: The connection.
+ * @input: Input bits, see handleEvent; one-shot bits stay local.
+ *
+ * The packet also acknowledges the newest snapshot decoded, so the next
+ * one can be sent as a delta against it.
+ */
+
+void client_send_input(NetClient *client, Uint16 input)
+{
+	Uint8 data[16];
+	BitPacker packet;
+
+	init_bits(&packet, data, sizeof(data));
+	write_header(&packet, NET_INPUT);
+	write_bits(&packet, ++client->tick, 32);
+	write_bits(&packet, client->latest, 32);
+	write_bits(&packet, input & ~INPUT_ONESHOT_MASK, 16);
+	net_send(client->socket, client->host, client->port, &packet);
+}
+
+/**
+ * client_world - Returns the newest decoded snapshot.
+ * @client: The connection.
+ *
+ * Return: The snapshot, or NULL if none has arrived yet.
+ */
+
+const NetWorld *client_world(const NetClient *client)
+{
+	if (client->latest == 0)
+		return (NULL);
+	return (&client->history[client->latest % NET_HISTORY]);
+}
+
+/**
+ * client_disconnect - Leaves the server and closes the socket.
+ * @client: The connection.
+ */
+
+void client_disconnect(NetClient *client)
+{
+	Uint8 data[8];
+	BitPacker packet;
+
+	if (client->socket < 0)
+		return;
+	if (client->id >= 0)
+	{
+		init_bits(&packet, data, sizeof(data));
+		write_header(&packet, NET_DISCONNECT);
+		net_send(client->socket, client->host, client->port, &packet);
+	}
+	close(client->socket);
+	client->socket = -1;
+}
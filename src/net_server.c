@@ -0,0 +1,410 @@
+#include "../headers/mazemania.h"
+#include <unistd.h>
+
+/* Baseline of clients that have not acknowledged anything yet */
+static const NetWorld emptyWorld;
+
+/**
+ * spawnEnemies - Places the current level's enemies on its spawn tiles.
+ * @server: The server; worldMap holds the level.
+ *
+ * Spawn tiles are found and drawn like findSpawnPoints and load_enemies
+ * do it, but the server has no renderer, so its enemies get no texture. A
+ * level with too few spawn tiles gets as many enemies as it has tiles.
+ */
+
+static void spawnEnemies(NetServer *server)
+{
+	int spawnPointsX[mapHeight * mapWidth];
+	int spawnPointsY[mapHeight * mapWidth];
+	int numSpawnPoints = 0, i, j, index;
+	Enemy *enemy;
+
+	for (i = 0; i < mapHeight; i++)
+	{
+		for (j = 0; j < mapWidth; j++)
+		{
+			if (worldMap[i][j] == 4)
+			{
+				spawnPointsX[numSpawnPoints] = j;
+				spawnPointsY[numSpawnPoints++] = i;
+			}
+		}
+	}
+	server->numEnemies = 4 * server->level;
+	if (server->numEnemies > numSpawnPoints)
+	{
+		fprintf(stderr, "Level %d has only %d spawn points\n", server->level,
+				numSpawnPoints);
+		server->numEnemies = numSpawnPoints;
+	}
+
+	for (i = 0; i < server->numEnemies; i++)
+	{
+		index = rng_range(&server->rng, numSpawnPoints);
+		enemy = &server->enemies[i];
+		memset(enemy, 0, sizeof(*enemy));
+		enemy->rect.x = spawnPointsX[index] * TILE_SIZE + (TILE_SIZE / 3);
+		enemy->rect.y = spawnPointsY[index] * TILE_SIZE + (TILE_SIZE / 3);
+		enemy->rect.w = TILE_SIZE / 3;
+		enemy->rect.h = TILE_SIZE / 3;
+		enemy->speed = 100.0f;
+		enemy->health = 100;
+
+		for (j = index; j < numSpawnPoints - 1; j++)
+		{
+			spawnPointsX[j] = spawnPointsX[j + 1];
+			spawnPointsY[j] = spawnPointsY[j + 1];
+		}
+		numSpawnPoints--;
+	}
+}
+
+/**
+ * resetPlayer - Puts a player on the start tile.
+ * @state: The player.
+ */
+
+static void resetPlayer(GameState *state)
+{
+	state->player.x = 80;
+	state->player.y = 80;
+	state->player.w = NET_PLAYER_SIZE;
+	state->player.h = NET_PLAYER_SIZE;
+	state->degrees = 0;
+}
+
+/**
+ * startLevel - Loads the server's current level for everyone.
+ * @server: The server.
+ */
+
+static void startLevel(NetServer *server)
+{
+	int i;
+
+	server->levelManager.current_Level = server->level - 1;
+	loadCurrentLevel(&server->levelManager);
+	spawnEnemies(server);
+	init_projectiles(&server->projectiles);
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		server->peers[i].state.level = server->level;
+		resetPlayer(&server->peers[i].state);
+	}
+}
+
+/**
+ * server_init - Opens the server socket and loads the first level.
+ * @server: Receives the server.
+ * @port: UDP port to listen on, host byte order.
+ * @seed: Session seed.
+ * @generate: Generate the levels from @seed instead of using worlds.txt.
+ * @level: Level to start on (1-based).
+ *
+ * load_worlds_from_file must have been called first, as for the game.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int server_init(NetServer *server, Uint16 port, Uint64 seed, bool generate,
+		int level)
+{
+	memset(server, 0, sizeof(*server));
+	server->socket = -1;
+	if (init_LevelManager(&server->levelManager) != 0 || (generate &&
+				generate_levels(&server->levelManager, seed) != 0))
+		return (1);
+
+	server->socket = net_open_socket(port);
+	if (server->socket < 0)
+		return (1);
+
+	server->seed = seed;
+	server->generate = generate;
+	server->level = level;
+	seed_rng(&server->rng, seed);
+	startLevel(server);
+
+	return (0);
+}
+
+/**
+ * findPeer - Looks a client up by address.
+ * @server: The server.
+ * @host: Client address, network byte order.
+ * @port: Client port, network byte order.
+ *
+ * Return: The client's slot, or -1 if it is not connected.
+ */
+
+static int findPeer(const NetServer *server, Uint32 host, Uint16 port)
+{
+	int i;
+
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		if (server->peers[i].connected && server->peers[i].host == host &&
+				server->peers[i].port == port)
+			return (i);
+	}
+	return (-1);
+}
+
+/**
+ * acceptPeer - Answers a connection request.
+ * @server: The server.
+ * @host: Client address, network byte order.
+ * @port: Client port, network byte order.
+ *
+ * A client that is already connected is welcomed again, since its first
+ * welcome may have been lost. When every slot is taken the client is told
+ * so.
+ */
+
+static void acceptPeer(NetServer *server, Uint32 host, Uint16 port)
+{
+	Uint8 data[64];
+	BitPacker packet;
+	NetPeer *peer;
+	int id = findPeer(server, host, port);
+
+	if (id < 0)
+	{
+		id = 0;
+		while (id < NET_MAX_PLAYERS && server->peers[id].connected)
+			id++;
+	}
+
+	init_bits(&packet, data, sizeof(data));
+	if (id == NET_MAX_PLAYERS)
+	{
+		write_header(&packet, NET_REFUSED);
+		net_send(server->socket, host, port, &packet);
+		return;
+	}
+
+	peer = &server->peers[id];
+	if (!peer->connected)
+	{
+		memset(peer, 0, sizeof(*peer));
+		peer->connected = true;
+		peer->host = host;
+		peer->port = port;
+		peer->state.level = server->level;
+		peer->state.isMinimap = true;
+		peer->state.tick = server->tick;
+		resetPlayer(&peer->state);
+	}
+	peer->lastHeard = server->tick;
+
+	write_header(&packet, NET_WELCOME);
+	write_bits(&packet, id, 8);
+	write_bits(&packet, (Uint32)server->seed, 32);
+	write_bits(&packet, (Uint32)(server->seed >> 32), 32);
+	write_bits(&packet, server->generate, 1);
+	net_send(server->socket, host, port, &packet);
+}
+
+/**
+ * receivePackets - Handles every packet waiting on the server socket.
+ * @server: The server.
+ *
+ * Input packets carry the client's tick, so late or duplicated ones are
+ * ignored, and the newest snapshot the client decoded, which becomes the
+ * baseline of its next delta.
+ */
+
+static void receivePackets(NetServer *server)
+{
+	Uint8 data[NET_MAX_PACKET];
+	BitPacker packet;
+	NetPeer *peer;
+	Uint32 host, tick, ack;
+	Uint16 port, input;
+	int size, type, id;
+
+	while ((size = net_receive(server->socket, data, sizeof(data), &host,
+					&port)) >= 0)
+	{
+		init_bits(&packet, data, size);
+		type = read_header(&packet);
+		if (type == NET_CONNECT)
+		{
+			acceptPeer(server, host, port);
+			continue;
+		}
+
+		id = findPeer(server, host, port);
+		if (id < 0)
+			continue;
+		peer = &server->peers[id];
+		if (type == NET_DISCONNECT)
+		{
+			peer->connected = false;
+		}
+		else if (type == NET_INPUT)
+		{
+			tick = read_bits(&packet, 32);
+			ack = read_bits(&packet, 32);
+			input = read_bits(&packet, 16);
+			if (packet.overflow)
+				continue;
+			peer->lastHeard = server->tick;
+			if (tick > peer->inputTick)
+			{
+				peer->inputTick = tick;
+				peer->input = input & ~INPUT_ONESHOT_MASK;
+			}
+			if (ack > peer->ackTick && ack <= server->tick)
+				peer->ackTick = ack;
+		}
+	}
+}
+
+/**
+ * recordWorld - Stores this tick's snapshot in the history.
+ * @server: The server.
+ *
+ * Return: The snapshot.
+ */
+
+static const NetWorld *recordWorld(NetServer *server)
+{
+	NetWorld *world = &server->history[server->tick % NET_HISTORY];
+	double degrees;
+	int i;
+
+	memset(world, 0, sizeof(*world));
+	world->tick = server->tick;
+	world->level = server->level;
+	world->numEnemies = server->numEnemies;
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		if (!server->peers[i].connected)
+			continue;
+		degrees = fmod(server->peers[i].state.degrees, 360);
+		if (degrees < 0)
+			degrees += 360;
+		world->players[i].active = true;
+		world->players[i].x = server->peers[i].state.player.x;
+		world->players[i].y = server->peers[i].state.player.y;
+		world->players[i].angle = (Uint16)(degrees * 65536 / 360);
+	}
+	for (i = 0; i < server->numEnemies; i++)
+	{
+		world->enemies[i].x = server->enemies[i].rect.x;
+		world->enemies[i].y = server->enemies[i].rect.y;
+		world->enemies[i].health = server->enemies[i].health < 0 ? 0 :
+			server->enemies[i].health;
+	}
+
+	return (world);
+}
+
+/**
+ * sendSnapshots - Sends every client this tick's snapshot.
+ * @server: The server.
+ * @world: This tick's snapshot.
+ *
+ * Each client gets a delta against the newest snapshot it acknowledged,
+ * as long as that one is still in the history; otherwise it gets the
+ * whole world.
+ */
+
+static void sendSnapshots(NetServer *server, const NetWorld *world)
+{
+	Uint8 data[NET_MAX_PACKET];
+	BitPacker packet;
+	const NetWorld *base;
+	NetPeer *peer;
+	int i;
+
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		peer = &server->peers[i];
+		if (!peer->connected)
+			continue;
+		base = &server->history[peer->ackTick % NET_HISTORY];
+		if (peer->ackTick == 0 || server->tick - peer->ackTick >=
+				NET_HISTORY || base->tick != peer->ackTick)
+			base = &emptyWorld;
+
+		init_bits(&packet, data, sizeof(data));
+		write_header(&packet, NET_SNAPSHOT);
+		write_bits(&packet, world->tick, 32);
+		write_bits(&packet, base->tick, 32);
+		encode_world(&packet, world, base);
+		server->bytesSent += net_send(server->socket, peer->host, peer->port,
+				&packet);
+		server->snapshotsSent++;
+	}
+}
+
+/**
+ * server_tick - Runs one server tick.
+ * @server: The server.
+ *
+ * Takes the waiting packets, drops clients that went quiet, moves every
+ * player with its newest input and fires its weapons, then moves the
+ * projectiles and the enemies, which follow the nearest player. Everyone
+ * moves to the next level when any player reaches the exit, and the new
+ * snapshot is sent to every client. The players share the server's tick,
+ * so enemies and weapon cooldowns see one clock.
+ */
+
+void server_tick(NetServer *server)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	GameState players[NET_MAX_PLAYERS];
+	NetPeer *peer;
+	bool reachedExit = false;
+	int i, numPlayers = 0;
+
+	server->tick++;
+	receivePackets(server);
+
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+	{
+		peer = &server->peers[i];
+		if (peer->connected && server->tick - peer->lastHeard > NET_TIMEOUT)
+			peer->connected = false;
+		if (!peer->connected)
+			continue;
+		move_player(&peer->state, worldMap, peer->input, NET_SPEED,
+				1.0f / TICK_RATE);
+		fire_weapons(&peer->state, &server->projectiles, server->enemies,
+				server->numEnemies, peer->input);
+		peer->state.tick = server->tick;
+		peer->state.rng = server->rng;
+		players[numPlayers++] = peer->state;
+		reachedExit = reachedExit || atLevelExit(&peer->state);
+	}
+	step_projectiles(&server->projectiles, server->enemies,
+			server->numEnemies, 1.0f / TICK_RATE);
+	if (numPlayers > 0)
+		update_shared_enemies(server->enemies, server->numEnemies, players,
+				numPlayers);
+	if (reachedExit)
+	{
+		server->level = server->level % 6 + 1;
+		startLevel(server);
+	}
+
+	sendSnapshots(server, recordWorld(server));
+	server->busySeconds += (double)(SDL_GetPerformanceCounter() - start) /
+		SDL_GetPerformanceFrequency();
+}
+
+/**
+ * server_free - Closes the server socket and frees the levels.
+ * @server: The server.
+ */
+
+void server_free(NetServer *server)
+{
+	if (server->socket >= 0)
+		close(server->socket);
+	server->socket = -1;
+	free_LevelManager(&server->levelManager);
+}
@@ -0,0 +1,96 @@
+#include "../headers/mazemania.h"
+
+/* Memory overlay layout, in screen pixels */
+#define OVERLAY_X (SCREEN_WIDTH - 300)
+#define OVERLAY_Y 10
+#define OVERLAY_ROW 16
+#define OVERLAY_BAR 200
+#define OVERLAY_DIGIT 2
+
+/* 3x5 digit glyphs, one row per 3 bits with the top row highest */
+static const Uint16 digitGlyphs[10] = {
+	075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757,
+	075717
+};
+
+/* Colour of each memory tag's swatch and bar */
+static const SDL_Color tagColors[MEM_TAGS] = {
+	{90, 170, 255, 255}, {255, 200, 60, 255}, {255, 90, 90, 255},
+	{120, 220, 120, 255}, {200, 120, 255, 255}
+};
+
+/**
+ * drawNumber - Draws a number with the built-in digit font.
+ * @renderer: The renderer, its draw colour already set.
+ * @x: Left edge of the first digit.
+ * @y: Top edge of the digits.
+ * @value: The number, not negative.
+ */
+
+static void drawNumber(SDL_Renderer *renderer, int x, int y, long long value)
+{
+	char digits[24];
+	SDL_Rect pixel = {0, 0, OVERLAY_DIGIT, OVERLAY_DIGIT};
+	int i, bit, length = snprintf(digits, sizeof(digits), "%lld", value);
+
+	for (i = 0; i < length; i++)
+	{
+		for (bit = 0; bit < 15; bit++)
+		{
+			if (!((digitGlyphs[digits[i] - '0'] >> (14 - bit)) & 1))
+				continue;
+			pixel.x = x + (i * 4 + bit % 3) * OVERLAY_DIGIT;
+			pixel.y = y + bit / 3 * OVERLAY_DIGIT;
+			SDL_RenderFillRect(renderer, &pixel);
+		}
+	}
+}
+
+/**
+ * draw_memory_overlay - Draws the memory use of every subsystem.
+ * @renderer: The renderer, holding a finished frame.
+ *
+ * One row per tag of mem_alloc: a swatch, a bar of the live bytes scaled
+ * to the largest peak with a mark at the tag's own peak, and the live
+ * size in KiB.
+ */
+
+void draw_memory_overlay(SDL_Renderer *renderer)
+{
+	MemUsage usage[MEM_TAGS];
+	Sint64 scale = 1;
+	SDL_Rect rect = {OVERLAY_X - 6, OVERLAY_Y - 6, 300,
+		MEM_TAGS * OVERLAY_ROW + 8};
+	int tag, y;
+
+	for (tag = 0; tag < MEM_TAGS; tag++)
+	{
+		mem_usage(tag, &usage[tag]);
+		if (usage[tag].peak > scale)
+			scale = usage[tag].peak;
+	}
+
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+	SDL_RenderFillRect(renderer, &rect);
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+	for (tag = 0; tag < MEM_TAGS; tag++)
+	{
+		y = OVERLAY_Y + tag * OVERLAY_ROW;
+		SDL_SetRenderDrawColor(renderer, tagColors[tag].r, tagColors[tag].g,
+				tagColors[tag].b, 255);
+		rect = (SDL_Rect){OVERLAY_X, y, 10, 10};
+		SDL_RenderFillRect(renderer, &rect);
+		rect = (SDL_Rect){OVERLAY_X + 16, y,
+			(int)(usage[tag].live * OVERLAY_BAR / scale), 10};
+		SDL_RenderFillRect(renderer, &rect);
+
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+		rect = (SDL_Rect){OVERLAY_X + 16 + (int)(usage[tag].peak *
+				OVERLAY_BAR / scale), y, 1, 10};
+		SDL_RenderFillRect(renderer, &rect);
+		drawNumber(renderer, OVERLAY_X + OVERLAY_BAR + 24, y,
+				(usage[tag].live + 1023) / 1024);
+	}
+}
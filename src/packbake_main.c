@@ -0,0 +1,338 @@
+#include "../headers/mazemania.h"
+
+/**
+ * struct BakedTexture - A texture converted and ready to be written.
+ * @entry: Table of contents record; offsets are filled in when writing.
+ * @levels: Every mip level, one after the other.
+ * @levelsSize: Size of @levels in bytes.
+ * @columns: Column-major copy of level 0, or NULL.
+ */
+
+typedef struct BakedTexture
+{
+	PackEntry entry;
+	Uint32 *levels;
+	size_t levelsSize;
+	Uint32 *columns;
+} BakedTexture;
+
+/**
+ * nextPowerOfTwo - Rounds a size up to a power of two.
+ * @value: A positive size.
+ *
+ * Return: The smallest power of two not below @value.
+ */
+
+static Uint32 nextPowerOfTwo(Uint32 value)
+{
+	Uint32 power = 1;
+
+	while (power < value)
+		power <<= 1;
+	return (power);
+}
+
+/**
+ * sampleBilinear - Samples an ARGB8888 image with bilinear filtering.
+ * @pixels: Source pixels.
+ * @width: Source width.
+ * @height: Source height.
+ * @pitch: Source row length in pixels.
+ * @x: Sample x in source pixels, pixel centres at .5.
+ * @y: Sample y in source pixels, pixel centres at .5.
+ *
+ * Return: The filtered ARGB8888 colour.
+ */
+
+static Uint32 sampleBilinear(const Uint32 *pixels, int width, int height,
+		int pitch, float x, float y)
+{
+	int x0, y0, x1, y1, shift;
+	float fx, fy, value;
+	Uint32 result = 0;
+
+	x -= 0.5f;
+	y -= 0.5f;
+	x0 = (int)floorf(x);
+	y0 = (int)floorf(y);
+	fx = x - x0;
+	fy = y - y0;
+	x1 = x0 + 1 < width ? x0 + 1 : width - 1;
+	y1 = y0 + 1 < height ? y0 + 1 : height - 1;
+	x0 = x0 < 0 ? 0 : x0;
+	y0 = y0 < 0 ? 0 : y0;
+
+	for (shift = 0; shift < 32; shift += 8)
+	{
+		value = ((pixels[y0 * pitch + x0] >> shift) & 0xFF) * (1 - fx) *
+			(1 - fy) + ((pixels[y0 * pitch + x1] >> shift) & 0xFF) * fx *
+			(1 - fy) + ((pixels[y1 * pitch + x0] >> shift) & 0xFF) *
+			(1 - fx) * fy + ((pixels[y1 * pitch + x1] >> shift) & 0xFF) *
+			fx * fy;
+		result |= (Uint32)(value + 0.5f) << shift;
+	}
+	return (result);
+}
+
+/**
+ * halveLevel - Builds the next mip level with a 2x2 box filter.
+ * @source: Source level.
+ * @width: Source width.
+ * @height: Source height.
+ * @target: Receives the level of size max(width / 2, 1) by
+ * max(height / 2, 1).
+ */
+
+static void halveLevel(const Uint32 *source, int width, int height,
+		Uint32 *target)
+{
+	int newWidth = width > 1 ? width / 2 : 1, newHeight = height > 1 ?
+		height / 2 : 1, x, y, shift, x1, y1;
+	Uint32 sum, color;
+
+	for (y = 0; y < newHeight; y++)
+	{
+		for (x = 0; x < newWidth; x++)
+		{
+			x1 = width > 1 ? 2 * x + 1 : 0;
+			y1 = height > 1 ? 2 * y + 1 : 0;
+			color = 0;
+			for (shift = 0; shift < 32; shift += 8)
+			{
+				sum = ((source[(2 * y) * width + 2 * x] >> shift) & 0xFF) +
+					((source[(2 * y) * width + x1] >> shift) & 0xFF) +
+					((source[y1 * width + 2 * x] >> shift) & 0xFF) +
+					((source[y1 * width + x1] >> shift) & 0xFF);
+				color |= ((sum + 2) / 4) << shift;
+			}
+			target[y * newWidth + x] = color;
+		}
+	}
+}
+
+/**
+ * bakeImage - Decodes an image and builds its pack data.
+ * @path: Image file.
+ * @columns: Also build a column-major copy of level 0.
+ * @baked: Receives the converted texture.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+static int bakeImage(const char *path, bool columns, BakedTexture *baked)
+{
+	SDL_Surface *loaded = IMG_Load(path), *surface;
+	const char *name = strrchr(path, '/');
+	Uint32 width, height, x, y, level, *texels;
+	size_t size = 0;
+
+	memset(baked, 0, sizeof(*baked));
+	name = name ? name + 1 : path;
+	if (!loaded)
+	{
+		fprintf(stderr, "Unable to load image %s: %s\n", path, IMG_GetError());
+		return (1);
+	}
+	if (strlen(name) >= PACK_NAME_SIZE)
+	{
+		fprintf(stderr, "Image name %s is too long\n", name);
+		SDL_FreeSurface(loaded);
+		return (1);
+	}
+	surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface(loaded);
+	if (!surface)
+	{
+		fprintf(stderr, "Unable to convert %s: %s\n", path, SDL_GetError());
+		return (1);
+	}
+
+	strcpy(baked->entry.name, name);
+	baked->entry.sourceWidth = surface->w;
+	baked->entry.sourceHeight = surface->h;
+	baked->entry.width = nextPowerOfTwo(surface->w);
+	baked->entry.height = nextPowerOfTwo(surface->h);
+	for (width = baked->entry.width, height = baked->entry.height; ;
+			width = width > 1 ? width / 2 : 1, height = height > 1 ?
+			height / 2 : 1)
+	{
+		size += (size_t)width * height * sizeof(Uint32);
+		baked->entry.mipLevels++;
+		if (width == 1 && height == 1)
+			break;
+	}
+
+	baked->levelsSize = size;
+	baked->levels = malloc(size);
+	if (columns)
+		baked->columns = malloc((size_t)baked->entry.width *
+				baked->entry.height * sizeof(Uint32));
+	if (!baked->levels || (columns && !baked->columns))
+	{
+		fprintf(stderr, "Failed to allocate the levels of %s\n", path);
+		SDL_FreeSurface(surface);
+		return (1);
+	}
+
+	/* Level 0, resampled to the power-of-two size */
+	width = baked->entry.width;
+	height = baked->entry.height;
+	SDL_LockSurface(surface);
+	for (y = 0; y < height; y++)
+	{
+		for (x = 0; x < width; x++)
+			baked->levels[y * width + x] = sampleBilinear(surface->pixels,
+					surface->w, surface->h, surface->pitch / 4,
+					(x + 0.5f) * surface->w / width,
+					(y + 0.5f) * surface->h / height);
+	}
+	SDL_UnlockSurface(surface);
+	SDL_FreeSurface(surface);
+
+	for (texels = baked->levels, level = 1; level <
+			baked->entry.mipLevels; level++)
+	{
+		halveLevel(texels, width, height, texels + width * height);
+		texels += width * height;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	if (columns)
+	{
+		baked->entry.flags |= PACK_COLUMNS;
+		width = baked->entry.width;
+		height = baked->entry.height;
+		for (y = 0; y < height; y++)
+		{
+			for (x = 0; x < width; x++)
+				baked->columns[x * height + y] = baked->levels[y * width + x];
+		}
+	}
+
+	return (0);
+}
+
+/**
+ * writeAligned - Writes a block at the next PACK_ALIGN boundary.
+ * @file: Output stream.
+ * @data: Block to write.
+ * @size: Size of the block.
+ * @offset: Current file offset, updated past the block.
+ *
+ * Return: The offset the block was written at, or 0 on a write error.
+ */
+
+static Uint64 writeAligned(FILE *file, const void *data, size_t size,
+		Uint64 *offset)
+{
+	static const char padding[PACK_ALIGN];
+	Uint64 start = (*offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+
+	if (fwrite(padding, 1, start - *offset, file) != start - *offset ||
+			fwrite(data, 1, size, file) != size)
+		return (0);
+	*offset = start + size;
+	return (start);
+}
+
+/**
+ * main - Entry point of the asset baker.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: packbake [--columns] OUTPUT IMAGE... decodes every image once,
+ * converts it to ARGB8888, resamples it to power-of-two dimensions, builds
+ * its full mip chain and writes everything to OUTPUT with a table of
+ * contents, ready for open_asset_pack to map.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int main(int argc, char *argv[])
+{
+	PackHeader header;
+	BakedTexture *baked;
+	bool columns = false;
+	int first = 1, count, i, status = 0;
+	Uint64 offset;
+	FILE *file;
+
+	if (argc > 1 && strcmp(argv[1], "--columns") == 0)
+	{
+		columns = true;
+		first++;
+	}
+	count = argc - first - 1;
+	if (count < 1)
+	{
+		fprintf(stderr, "Usage: %s [--columns] OUTPUT IMAGE...\n", argv[0]);
+		return (1);
+	}
+
+	baked = calloc(count, sizeof(BakedTexture));
+	if (!baked)
+		return (1);
+	for (i = 0; i < count && status == 0; i++)
+		status = bakeImage(argv[first + 1 + i], columns, &baked[i]);
+
+	file = status == 0 ? fopen(argv[first], "wb") : NULL;
+	if (status == 0 && !file)
+	{
+		fprintf(stderr, "Could not create %s\n", argv[first]);
+		status = 1;
+	}
+
+	if (status == 0)
+	{
+		/* The table of contents is written twice: once to reserve it... */
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, PACK_MAGIC, 4);
+		header.version = PACK_VERSION;
+		header.byteOrder = PACK_BYTE_ORDER;
+		header.count = count;
+		offset = sizeof(header) + count * sizeof(PackEntry);
+		status = fwrite(&header, sizeof(header), 1, file) != 1;
+		for (i = 0; i < count && status == 0; i++)
+			status = fwrite(&baked[i].entry, sizeof(PackEntry), 1, file) != 1;
+
+		for (i = 0; i < count && status == 0; i++)
+		{
+			baked[i].entry.offset = writeAligned(file, baked[i].levels,
+					baked[i].levelsSize, &offset);
+			status = baked[i].entry.offset == 0;
+			if (status == 0 && baked[i].columns)
+			{
+				baked[i].entry.columnOffset = writeAligned(file,
+						baked[i].columns, (size_t)baked[i].entry.width *
+						baked[i].entry.height * sizeof(Uint32), &offset);
+				status = baked[i].entry.columnOffset == 0;
+			}
+		}
+
+		/* ...and again once every offset is known */
+		if (status == 0)
+			status = fseek(file, sizeof(header), SEEK_SET) != 0;
+		for (i = 0; i < count && status == 0; i++)
+			status = fwrite(&baked[i].entry, sizeof(PackEntry), 1, file) != 1;
+		if (fclose(file) != 0 || status != 0)
+		{
+			fprintf(stderr, "Could not write %s\n", argv[first]);
+			status = 1;
+		}
+		else
+		{
+			printf("Baked %d images into %s, %llu bytes\n", count, argv[first],
+					(unsigned long long)offset);
+		}
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		free(baked[i].levels);
+		free(baked[i].columns);
+	}
+	free(baked);
+
+	return (status);
+}
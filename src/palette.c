@@ -0,0 +1,444 @@
+#include "../headers/mazemania.h"
+
+/**
+ * paletteMode - True when the 8-bit palettized renderer is active.
+ */
+bool paletteMode;
+
+/**
+ * paletteShading - False to draw without distance fog and side shading,
+ * leaving only the quantization; the golden run compares that with the
+ * plain renderer.
+ */
+bool paletteShading = true;
+
+/**
+ * paletteFramebuffer - One palette index per screen pixel. Expanded to
+ * ARGB once per frame by presentPaletteFramebuffer.
+ */
+Uint8 paletteFramebuffer[SCREEN_HEIGHT * SCREEN_WIDTH];
+
+static SDL_Color palette[PALETTE_SIZE];
+static Uint32 paletteARGB[PALETTE_SIZE];
+static Uint8 inverseTable[32 * 32 * 32];
+static Uint8 colormaps[2][FOG_BANDS][PALETTE_SIZE];
+static Uint8 flatSliceIndex[2];
+static Uint8 skyIndex, groundIndex;
+static SDL_Texture *frameTexture;
+
+/**
+ * nearestPaletteIndex - Finds the palette entry closest to a colour.
+ * @r: Red component.
+ * @g: Green component.
+ * @b: Blue component.
+ *
+ * Return: The index of the nearest palette entry by squared RGB distance.
+ */
+
+static Uint8 nearestPaletteIndex(int r, int g, int b)
+{
+	int i, best = 0, bestDistance = INT_MAX;
+
+	for (i = 0; i < PALETTE_SIZE; i++)
+	{
+		int dr = palette[i].r - r;
+		int dg = palette[i].g - g;
+		int db = palette[i].b - b;
+		int distance = dr * dr + dg * dg + db * db;
+
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			best = i;
+		}
+	}
+	return ((Uint8)best);
+}
+
+/**
+ * quantizeColor - Maps an ARGB colour to a palette index.
+ * @color: The colour in the engine's ARGB8888 layout.
+ *
+ * Return: The palette index, looked up through the 15-bit inverse table.
+ */
+
+Uint8 quantizeColor(Uint32 color)
+{
+	int r = (color >> 19) & 0x1F;
+	int g = (color >> 11) & 0x1F;
+	int b = (color >> 3) & 0x1F;
+
+	return (inverseTable[(r << 10) | (g << 5) | b]);
+}
+
+/**
+ * init_palette - Builds the palette, inverse table and lighting colormaps.
+ * @renderer: The renderer that will receive the expanded framebuffer.
+ *
+ * The palette is a 6x6x6 colour cube followed by a 40 step grey ramp.
+ * Colormap [side][band] darkens every entry for its wall side and fades it
+ * towards black with distance, so lighting is a single table lookup per
+ * pixel.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int init_palette(SDL_Renderer *renderer)
+{
+	int i, r, g, b, side, band;
+
+	for (i = 0; i < 216; i++)
+	{
+		palette[i].r = (i / 36) * 51;
+		palette[i].g = ((i / 6) % 6) * 51;
+		palette[i].b = (i % 6) * 51;
+	}
+	for (i = 216; i < PALETTE_SIZE; i++)
+	{
+		int level = ((i - 216) * 255) / (PALETTE_SIZE - 217);
+
+		palette[i].r = level;
+		palette[i].g = level;
+		palette[i].b = level;
+	}
+	for (i = 0; i < PALETTE_SIZE; i++)
+	{
+		palette[i].a = 255;
+		paletteARGB[i] = 0xFF000000 | (palette[i].r << 16) |
+			(palette[i].g << 8) | palette[i].b;
+	}
+
+	for (r = 0; r < 32; r++)
+		for (g = 0; g < 32; g++)
+			for (b = 0; b < 32; b++)
+				inverseTable[(r << 10) | (g << 5) | b] = nearestPaletteIndex(
+						(r << 3) | (r >> 2), (g << 3) | (g >> 2),
+						(b << 3) | (b >> 2));
+
+	for (side = 0; side < 2; side++)
+	{
+		for (band = 0; band < FOG_BANDS; band++)
+		{
+			/* Side 0 (vertical grid hits) is darker, fog fades to black */
+			int light = (side ? 256 : 176) * (FOG_BANDS - band) / FOG_BANDS;
+
+			for (i = 0; i < PALETTE_SIZE; i++)
+				colormaps[side][band][i] = nearestPaletteIndex(
+						palette[i].r * light / 256, palette[i].g * light / 256,
+						palette[i].b * light / 256);
+		}
+	}
+
+	flatSliceIndex[0] = nearestPaletteIndex(64, 64, 64);
+	flatSliceIndex[1] = nearestPaletteIndex(255, 253, 208);
+	skyIndex = nearestPaletteIndex(135, 206, 235);
+	groundIndex = nearestPaletteIndex(128, 128, 128);
+
+	frameTexture = mem_create_texture(MEM_RENDER, renderer,
+			SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+			SCREEN_WIDTH, SCREEN_HEIGHT);
+	if (!frameTexture)
+	{
+		fprintf(stderr, "Failed to create palette frame texture: %s\n",
+				SDL_GetError());
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * free_palette - Releases the streaming texture used to present frames.
+ */
+
+void free_palette(void)
+{
+	if (frameTexture)
+	{
+		mem_destroy_texture(frameTexture);
+		frameTexture = NULL;
+	}
+}
+
+/**
+ * quantize_wallTexture - Builds the 8-bit copy of a loaded texture.
+ * @t: Pointer to a wallTexture whose ARGB pixels are already loaded.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int quantize_wallTexture(wallTexture *t)
+{
+	int i, count = t->width * t->height;
+
+	t->indices = mem_alloc(MEM_TEXTURES, count);
+	if (!t->indices)
+	{
+		printf("Failed to allocate memory for texture indices\n");
+		return (1);
+	}
+	for (i = 0; i < count; i++)
+		t->indices[i] = quantizeColor(t->pixels[i]);
+
+	return (0);
+}
+
+/**
+ * fogBand - Converts a perpendicular distance into a colormap band.
+ * @distance: Distance from the player in world units.
+ *
+ * Return: The band index, clamped to [0, FOG_BANDS); always 0 without
+ * paletteShading.
+ */
+
+static int fogBand(float distance)
+{
+	int band = (int)(distance * FOG_BANDS / FOG_DISTANCE);
+
+	if (band < 0 || !paletteShading)
+		return (0);
+	if (band >= FOG_BANDS)
+		return (FOG_BANDS - 1);
+	return (band);
+}
+
+/**
+ * litBand - Darkens a fog band further by a light level.
+ * @band: Fog band from fogBand.
+ * @light: Light level, LIGHT_FULL leaving @band unchanged.
+ *
+ * The colormaps scale by (FOG_BANDS - band) / FOG_BANDS, so the band
+ * whose scale is the product of fog and light is found without a table.
+ *
+ * Return: The band index, clamped to [0, FOG_BANDS).
+ */
+
+static int litBand(int band, int light)
+{
+	band = FOG_BANDS - (FOG_BANDS - band) * (light + 1) / LIGHT_LEVELS;
+	return (band >= FOG_BANDS ? FOG_BANDS - 1 : band);
+}
+
+/**
+ * renderTopHalfPalette - Fills the framebuffer with the sky and the
+ * plain grey floor used when no floor texture is drawn.
+ * @sky: Fill the upper half; false when the ceiling covers it.
+ * @ground: Fill the lower half; false when the floor covers it.
+ *
+ * The horizon row belongs to neither plane and is always filled.
+ */
+
+void renderTopHalfPalette(bool sky, bool ground)
+{
+	int half = (SCREEN_HEIGHT / 2) * SCREEN_WIDTH;
+
+	if (sky)
+		memset(paletteFramebuffer, skyIndex, half);
+	memset(paletteFramebuffer + half, groundIndex,
+			ground ? sizeof(paletteFramebuffer) - half : SCREEN_WIDTH);
+}
+
+/**
+ * drawWallSlicePalette - Draws a flat-shaded wall column with distance fog.
+ * @rayIndex: Screen column.
+ * @wallHeight: Projected height of the wall slice.
+ * @distance: Corrected perpendicular distance of the hit.
+ * @verticalRay: Non-zero if the ray hit a vertical grid line.
+ * @light: Light level of the wall face.
+ */
+
+void drawWallSlicePalette(int rayIndex, int wallHeight, float distance,
+		int verticalRay, int light)
+{
+	int drawStart = (SCREEN_HEIGHT / 2) - (wallHeight / 2);
+	int drawEnd = (SCREEN_HEIGHT / 2) + (wallHeight / 2);
+	/* Vertical hits get the dark grey, as in drawWallSlice's call site */
+	Uint8 index = colormaps[1][litBand(fogBand(distance), light)]
+		[flatSliceIndex[verticalRay ? 0 : 1]];
+	Uint8 *dst;
+
+	if (drawStart < 0)
+		drawStart = 0;
+	if (drawEnd >= SCREEN_HEIGHT)
+		drawEnd = SCREEN_HEIGHT - 1;
+
+	dst = paletteFramebuffer + drawStart * SCREEN_WIDTH + rayIndex;
+	for (int y = drawStart; y <= drawEnd; y++, dst += SCREEN_WIDTH)
+		*dst = index;
+}
+
+/**
+ * drawWallTexturePalette - Draws a textured wall column through the
+ * side/distance colormap.
+ * @rayIndex: Screen column.
+ * @wallHeight: Projected height of the wall slice.
+ * @texture: Texture with quantized indices.
+ * @texX: Texture column.
+ * @distance: Corrected perpendicular distance of the hit.
+ * @verticalRay: Non-zero if the ray hit a vertical grid line.
+ * @light: Light level of the wall face.
+ */
+
+void drawWallTexturePalette(int rayIndex, int wallHeight,
+		wallTexture *texture, int texX, float distance, int verticalRay,
+		int light)
+{
+	int drawStart = (SCREEN_HEIGHT / 2) - (wallHeight / 2);
+	int drawEnd = (SCREEN_HEIGHT / 2) + (wallHeight / 2);
+	const Uint8 *colormap = colormaps[verticalRay && paletteShading ? 0 : 1]
+		[litBand(fogBand(distance), light)];
+	const Uint8 *column = texture->indices + texX;
+	Uint8 *dst;
+
+	if (drawStart < 0)
+		drawStart = 0;
+	if (drawEnd >= SCREEN_HEIGHT)
+		drawEnd = SCREEN_HEIGHT - 1;
+
+	dst = paletteFramebuffer + drawStart * SCREEN_WIDTH + rayIndex;
+	for (int y = drawStart; y < drawEnd; y++, dst += SCREEN_WIDTH)
+	{
+		int d = y * 256 - SCREEN_HEIGHT * 128 + wallHeight * 128;
+		int texY = ((d * texture->height) / wallHeight) / 256;
+
+		*dst = colormap[column[texY * texture->width]];
+	}
+}
+
+/*
+ * PALETTE_PLANE_KERNEL - Defines a palettized floor or ceiling renderer for
+ * one lighting mode. IS_CEILING and LIT are constants, so each expansion
+ * carries neither check in its pixel loop. The pixels of each column's
+ * wall span are skipped; with lighting on, the colormap changes only where
+ * the row crosses into a tile of another light level.
+ */
+#define PALETTE_PLANE_KERNEL(name, IS_CEILING, LIT) \
+void name(SDL_Instance *instance, float playerX, float playerY, \
+		float playerAngle, wallTexture *texture, const RayHits *hits) \
+{ \
+	float rayDirX0 = cos(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2)); \
+	float rayDirY0 = sin(DEG_TO_RAD(playerAngle - FOV_ANGLE / 2)); \
+	float rayDirX1 = cos(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2)); \
+	float rayDirY1 = sin(DEG_TO_RAD(playerAngle + FOV_ANGLE / 2)); \
+	float posZ = 0.5 * SCREEN_HEIGHT; \
+	Uint8 lights[SCREEN_WIDTH]; \
+	int limits[SCREEN_WIDTH]; \
+	int bound = wall_spans(hits, IS_CEILING, limits); \
+\
+	(void)instance; \
+	for (int y = IS_CEILING ? 0 : bound; \
+			y < (IS_CEILING ? bound : SCREEN_HEIGHT); y++) \
+	{ \
+		int p = IS_CEILING ? SCREEN_HEIGHT / 2 - y : y - SCREEN_HEIGHT / 2; \
+		float rowDistance = posZ / p; \
+		float stepX = rowDistance * (rayDirX1 - rayDirX0) / SCREEN_WIDTH; \
+		float stepY = rowDistance * (rayDirY1 - rayDirY0) / SCREEN_WIDTH; \
+		float planeX = playerX + rowDistance * rayDirX0; \
+		float planeY = playerY + rowDistance * rayDirY0; \
+		/* Same distance a wall whose edge lands on this row would have */ \
+		int band = fogBand((TILE_SIZE / 2) * DIST_TO_PROJ_PLANE / p); \
+		const Uint8 *colormap = colormaps[1][band]; \
+		Uint8 *dst = paletteFramebuffer + y * SCREEN_WIDTH; \
+		int light = LIGHT_FULL; \
+\
+		if (LIT) \
+			light_plane_row(playerX, playerY, playerAngle, p, lights); \
+		for (int x = 0; x < SCREEN_WIDTH; x++, planeX += stepX, \
+				planeY += stepY) \
+		{ \
+			if (IS_CEILING ? y >= limits[x] : y < limits[x]) \
+				continue; \
+			if (LIT && lights[x] != light) \
+			{ \
+				light = lights[x]; \
+				colormap = colormaps[1][litBand(band, light)]; \
+			} \
+\
+			int cellX = (int)planeX; \
+			int cellY = (int)planeY; \
+			int tx = (int)(texture->width * (planeX - cellX)) & \
+				(texture->width - 1); \
+			int ty = (int)(texture->height * (planeY - cellY)) & \
+				(texture->height - 1); \
+\
+			dst[x] = colormap[texture->indices[ty * texture->width + tx]]; \
+		} \
+	} \
+}
+
+/**
+ * drawFloorPaletteLit - Renders the lit floor into the palette framebuffer.
+ * @instance: Unused; the kernels share one signature.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Floor texture with quantized indices.
+ * @hits: The frame's hits, or NULL to fill the whole lower half.
+ */
+PALETTE_PLANE_KERNEL(drawFloorPaletteLit, false, true)
+
+/**
+ * drawFloorPaletteUnlit - Renders the floor into the palette framebuffer
+ * with distance fog only.
+ * @instance: Unused; the kernels share one signature.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Floor texture with quantized indices.
+ * @hits: The frame's hits, or NULL to fill the whole lower half.
+ */
+PALETTE_PLANE_KERNEL(drawFloorPaletteUnlit, false, false)
+
+/**
+ * drawCeilingPaletteLit - Renders the lit ceiling into the palette
+ * framebuffer.
+ * @instance: Unused; the kernels share one signature.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Ceiling texture with quantized indices.
+ * @hits: The frame's hits, or NULL to fill the whole upper half.
+ */
+PALETTE_PLANE_KERNEL(drawCeilingPaletteLit, true, true)
+
+/**
+ * drawCeilingPaletteUnlit - Renders the ceiling into the palette
+ * framebuffer with distance fog only.
+ * @instance: Unused; the kernels share one signature.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ * @playerAngle: The angle of the player's viewing direction.
+ * @texture: Ceiling texture with quantized indices.
+ * @hits: The frame's hits, or NULL to fill the whole upper half.
+ */
+PALETTE_PLANE_KERNEL(drawCeilingPaletteUnlit, true, false)
+
+/**
+ * presentPaletteFramebuffer - Expands the framebuffer to ARGB and copies it
+ * to the renderer.
+ * @instance: Pointer to the SDL_Instance with the target renderer.
+ *
+ * This is the only place the frame is touched at 32 bits per pixel.
+ */
+
+void presentPaletteFramebuffer(SDL_Instance *instance)
+{
+	void *pixels;
+	int pitch, x, y;
+
+	if (SDL_LockTexture(frameTexture, NULL, &pixels, &pitch) != 0)
+	{
+		fprintf(stderr, "SDL_LockTexture Error: %s\n", SDL_GetError());
+		return;
+	}
+	for (y = 0; y < SCREEN_HEIGHT; y++)
+	{
+		const Uint8 *src = paletteFramebuffer + y * SCREEN_WIDTH;
+		Uint32 *dst = (Uint32 *)((Uint8 *)pixels + y * pitch);
+
+		for (x = 0; x < SCREEN_WIDTH; x++)
+			dst[x] = paletteARGB[src[x]];
+	}
+	SDL_UnlockTexture(frameTexture);
+	SDL_RenderCopy(instance->renderer, frameTexture, NULL, NULL);
+}
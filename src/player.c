@@ -0,0 +1,122 @@
+#include "../headers/mazemania.h"
+
+/**
+ * move_player - Advances the player by one simulation tick.
+ * @state: Pointer to the GameState holding the player.
+ * @map: The level the player moves through.
+ * @input: Input bits for this tick, see handleEvent.
+ * @speed: Speed at which the player moves.
+ * @deltaTime: Length of the tick in seconds.
+ *
+ * This function applies movement and rotation from the input bits, clamps
+ * the player inside the border and undoes the move if it would overlap an
+ * internal wall. It reads nothing but its arguments, so the same inputs
+ * always give the same result and any number of games can be advanced at
+ * once from different threads.
+ */
+
+void move_player(GameState *state, int map[mapHeight][mapWidth],
+		Uint16 input, float speed, float deltaTime)
+{
+	SDL_Rect *object = &state->player;
+	SDL_Rect prevPosition = *object;
+	bool keyW = input & INPUT_FORWARD, keyS = input & INPUT_BACK;
+	bool keyA = input & INPUT_LEFT, keyD = input & INPUT_RIGHT;
+	int y, x;
+
+	if (input & INPUT_TURN_LEFT)
+		state->degrees -= 180 * deltaTime;
+	if (input & INPUT_TURN_RIGHT)
+		state->degrees += 180 * deltaTime;
+	if (input & INPUT_TOGGLE_MAP)
+		state->isMinimap = !state->isMinimap;
+	if (input & INPUT_SHOW_MAP)
+		state->isMinimap = true;
+
+	/* Determine the resulting movement based on key states */
+	float moveX = 0, moveY = 0;
+
+	if ((keyW && keyS) || (keyA && keyD))
+	{
+		moveX = 0;
+		moveY = 0;
+	}
+	else
+	{
+		if (keyW && keyA)
+		{
+			moveY = -speed * deltaTime;
+			moveX = -speed * deltaTime;
+		}
+		else if (keyW && keyD)
+		{
+			moveY = -speed * deltaTime;
+			moveX = speed * deltaTime;
+		}
+		else if (keyA && keyS)
+		{
+			moveX = -speed * deltaTime;
+			moveY = speed * deltaTime;
+		}
+		else if (keyS && keyD)
+		{
+			moveX = speed * deltaTime;
+			moveY = speed * deltaTime;
+		}
+		else if (keyW && !keyS)
+		{
+			moveY = -speed * deltaTime;
+		}
+		else if (keyA && !keyD)
+		{
+			moveX = -speed * deltaTime;
+		}
+		else if (keyS && !keyW)
+		{
+			moveY = speed * deltaTime;
+		}
+		else if (keyD && !keyA)
+		{
+			moveX = speed * deltaTime;
+		}
+	}
+
+	object->x += moveX;
+	object->y += moveY;
+
+	/* Boundary checks. Added 10 pixels so that the player will go into open */
+	/* space when the world is rendered with textures */
+	if (object->x < TILE_SIZE + 10)
+		object->x = TILE_SIZE + 10;
+
+	if ((object->x + object->w) > SCREEN_WIDTH - TILE_SIZE - 10)
+		object->x = SCREEN_WIDTH - TILE_SIZE - 10 - object->w;
+
+	if (object->y < TILE_SIZE + 10)
+		object->y = TILE_SIZE + 10;
+
+	if ((object->y + object->h) > SCREEN_HEIGHT - TILE_SIZE - 10)
+		object->y = SCREEN_HEIGHT - TILE_SIZE - 10 - object->h;
+
+	/* Only the tiles under the player can overlap it */
+	for (y = object->y / TILE_SIZE; y <= (object->y + object->h - 1) /
+			TILE_SIZE && y < mapHeight; y++)
+	{
+		for (x = object->x / TILE_SIZE; x <= (object->x + object->w - 1) /
+				TILE_SIZE && x < mapWidth; x++)
+		{
+			if (map[y][x] == 2)
+			{
+				SDL_Rect wallRect = {x * TILE_SIZE, y * TILE_SIZE,
+					TILE_SIZE, TILE_SIZE};
+
+				if (checkIntersection(object, &wallRect))
+				{
+					/* Move the object back to its previous position */
+					*object = prevPosition;
+					return;
+				}
+			}
+		}
+	}
+}
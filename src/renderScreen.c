@@ -1,20 +1,43 @@
 #include "../headers/mazemania.h"
 
 /**
- * renderTopHalf - Renders the top half of the screen with a specified color.
+ * renderTopHalf - Renders the sky in the top half of the screen.
  * @instance: Pointer to the SDL_Instance structure with window and renderer.
+ * @hits: The frame's hits; the sky stops above each column's wall. NULL
+ * fills the whole top half.
  *
- * This function renders the top half of the screen with a specified color. It
- * creates an SDL_Rect structure to define the dimensions of the top half and
- * fills it with the specified color using SDL_RenderFillRect.
+ * This function fills the rows above each column's wall with the sky
+ * colour, using the limits wall_spans gives the ceiling. Adjacent columns
+ * with the same limit share a rectangle, and all of them go to the
+ * renderer in one SDL_RenderFillRects call.
  */
 
 
-void renderTopHalf(SDL_Instance *instance)
+void renderTopHalf(SDL_Instance *instance, const RayHits *hits)
 {
-	SDL_Rect TopRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT / 2};
+	SDL_Rect rects[SCREEN_WIDTH];
+	int limits[SCREEN_WIDTH];
+	int x, numRects = 0;
+
+	wall_spans(hits, true, limits);
+	for (x = 0; x < SCREEN_WIDTH; x++)
+	{
+		if (limits[x] == 0)
+			continue;
+		if (numRects > 0 && rects[numRects - 1].h == limits[x] &&
+				rects[numRects - 1].x + rects[numRects - 1].w == x)
+		{
+			rects[numRects - 1].w++;
+			continue;
+		}
+		rects[numRects].x = x;
+		rects[numRects].y = 0;
+		rects[numRects].w = 1;
+		rects[numRects].h = limits[x];
+		numRects++;
+	}
 
 	SDL_SetRenderDrawColor(instance->renderer, 135, 206, 235, 255);
 
-	SDL_RenderFillRect(instance->renderer, &TopRect);
+	SDL_RenderFillRects(instance->renderer, rects, numRects);
 }
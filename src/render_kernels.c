@@ -0,0 +1,151 @@
+#include "../headers/mazemania.h"
+
+/*
+ * WALL_KERNEL - Defines a wall column loop for one render mode. LIT is a
+ * constant and DRAW the column call of one renderer and wall style, so
+ * each expansion carries no mode checks per column. DRAW may use ray,
+ * texX, light, hits, instance, texture, column, the textured column
+ * renderer for the lighting mode and the texture's layout, and direct,
+ * its unlit twin for faces at LIGHT_FULL.
+ */
+#define WALL_KERNEL(name, LIT, DRAW) \
+static void name(SDL_Instance *instance, const RayHits *hits, \
+		wallTexture *texture) \
+{ \
+	int ray, texX, light = LIGHT_FULL; \
+	WallColumn direct = texture->columns ? drawWallColumns : drawWallRows; \
+	WallColumn column = !LIT ? direct : \
+		texture->columns ? drawWallColumnsLit : drawWallRowsLit; \
+\
+	(void)instance; \
+	(void)column; \
+	for (ray = 0; ray < NUM_RAYS; ray++) \
+	{ \
+		if (hits->tile[ray] == 0) \
+			continue; \
+\
+		/* Scale texX to the texture width */ \
+		texX = (hits->texX[ray] * texture->width) / TILE_SIZE; \
+		(void)texX; \
+		if (LIT) \
+			light = face_light(hits->tileX[ray], hits->tileY[ray], \
+					hits->verticalRay[ray], hits->angle[ray]); \
+		DRAW; \
+	} \
+}
+
+/* Level 1's flat shaded walls, vertical hits in the dark grey */
+#define FLAT_SLICE drawWallSlice(instance->renderer, ray, \
+		hits->wallHeight[ray], hits->verticalRay[ray], \
+		!hits->verticalRay[ray], light)
+#define FLAT_BATCH batchWallSlice(ray, hits->wallHeight[ray], \
+		hits->verticalRay[ray], !hits->verticalRay[ray], light)
+#define FLAT_PALETTE drawWallSlicePalette(ray, hits->wallHeight[ray], \
+		hits->perpDistance[ray], hits->verticalRay[ray], light)
+
+/* Textured walls of the later levels */
+#define TEXTURED_SLICE (light == LIGHT_FULL ? direct : column)( \
+		instance->renderer, ray, hits->wallHeight[ray], texture, texX, light)
+#define TEXTURED_BATCH batchWallTexture(instance->renderer, ray, \
+		hits->wallHeight[ray], texture, texX, light)
+#define TEXTURED_PALETTE drawWallTexturePalette(ray, hits->wallHeight[ray], \
+		texture, texX, hits->perpDistance[ray], hits->verticalRay[ray], \
+		light)
+
+WALL_KERNEL(flatWalls, false, FLAT_SLICE)
+WALL_KERNEL(flatWallsLit, true, FLAT_SLICE)
+WALL_KERNEL(texturedWalls, false, TEXTURED_SLICE)
+WALL_KERNEL(texturedWallsLit, true, TEXTURED_SLICE)
+WALL_KERNEL(flatWallsBatch, false, FLAT_BATCH)
+WALL_KERNEL(flatWallsBatchLit, true, FLAT_BATCH)
+WALL_KERNEL(texturedWallsBatch, false, TEXTURED_BATCH)
+WALL_KERNEL(texturedWallsBatchLit, true, TEXTURED_BATCH)
+WALL_KERNEL(flatWallsPalette, false, FLAT_PALETTE)
+WALL_KERNEL(flatWallsPaletteLit, true, FLAT_PALETTE)
+WALL_KERNEL(texturedWallsPalette, false, TEXTURED_PALETTE)
+WALL_KERNEL(texturedWallsPaletteLit, true, TEXTURED_PALETTE)
+
+/* Renderers, see kernelTable */
+enum {RENDER_PLAIN, RENDER_BATCH, RENDER_PALETTE, RENDER_BACKENDS};
+
+/* Level styles: the walls, then which of floor and ceiling are drawn */
+enum {STYLE_FLAT, STYLE_TEXTURED, STYLE_FLOOR, STYLE_FLOOR_CEILING,
+	RENDER_STYLES};
+
+/*
+ * kernelTable[renderer][lit][style] - Every render mode. The batched
+ * renderer shades its floor and ceiling in software like the plain one.
+ */
+static const RenderKernels kernelTable[RENDER_BACKENDS][2][RENDER_STYLES] = {
+	[RENDER_PLAIN] = {
+		{
+			{flatWalls, NULL, NULL},
+			{texturedWalls, NULL, NULL},
+			{texturedWalls, NULL, drawFloorUnlit},
+			{texturedWalls, drawCeilingUnlit, drawFloorUnlit},
+		},
+		{
+			{flatWallsLit, NULL, NULL},
+			{texturedWallsLit, NULL, NULL},
+			{texturedWallsLit, NULL, drawFloorLit},
+			{texturedWallsLit, drawCeilingLit, drawFloorLit},
+		},
+	},
+	[RENDER_BATCH] = {
+		{
+			{flatWallsBatch, NULL, NULL},
+			{texturedWallsBatch, NULL, NULL},
+			{texturedWallsBatch, NULL, drawFloorUnlit},
+			{texturedWallsBatch, drawCeilingUnlit, drawFloorUnlit},
+		},
+		{
+			{flatWallsBatchLit, NULL, NULL},
+			{texturedWallsBatchLit, NULL, NULL},
+			{texturedWallsBatchLit, NULL, drawFloorLit},
+			{texturedWallsBatchLit, drawCeilingLit, drawFloorLit},
+		},
+	},
+	[RENDER_PALETTE] = {
+		{
+			{flatWallsPalette, NULL, NULL},
+			{texturedWallsPalette, NULL, NULL},
+			{texturedWallsPalette, NULL, drawFloorPaletteUnlit},
+			{texturedWallsPalette, drawCeilingPaletteUnlit,
+				drawFloorPaletteUnlit},
+		},
+		{
+			{flatWallsPaletteLit, NULL, NULL},
+			{texturedWallsPaletteLit, NULL, NULL},
+			{texturedWallsPaletteLit, NULL, drawFloorPaletteLit},
+			{texturedWallsPaletteLit, drawCeilingPaletteLit,
+				drawFloorPaletteLit},
+		},
+	},
+};
+
+/**
+ * renderKernels - The kernels renderFrame draws the current level with.
+ */
+const RenderKernels *renderKernels = &kernelTable[RENDER_PLAIN][0][STYLE_FLAT];
+
+/**
+ * select_render_kernels - Picks the kernels for a level and the render
+ * mode flags.
+ * @level: Level number, from 1.
+ *
+ * Level 1 has flat shaded walls and later levels are textured; the floor
+ * appears from level 3 and the ceiling from level 5. Called through the
+ * LevelManager's onLoad hook each time a level is loaded, after the mode
+ * flags are set.
+ */
+
+void select_render_kernels(int level)
+{
+	int renderer = paletteMode ? RENDER_PALETTE :
+		gpuBatchMode ? RENDER_BATCH : RENDER_PLAIN;
+	int style = level >= 5 ? STYLE_FLOOR_CEILING :
+		level >= 3 ? STYLE_FLOOR :
+		level >= 2 ? STYLE_TEXTURED : STYLE_FLAT;
+
+	renderKernels = &kernelTable[renderer][lightingMode][style];
+}
@@ -0,0 +1,308 @@
+#include "../headers/mazemania.h"
+
+/*
+ * Recording file layout, all fields little-endian:
+ *   "MZRC", u16 version, u16 start level, u16 flags, u64 seed,
+ *   u32 tick count, then (u16 input, u16 run length) pairs until tick
+ *   count is reached.
+ * Inputs change rarely compared to the tick rate, so run-length pairs keep
+ * an hour of play in a few kilobytes. Version 1 files have no flags field
+ * and are still accepted.
+ */
+
+/**
+ * writeLE - Writes an unsigned value in little-endian byte order.
+ * @file: Output stream.
+ * @value: Value to write.
+ * @bytes: Number of low-order bytes to write.
+ *
+ * Return: 0 on success, 1 on a write error.
+ */
+
+static int writeLE(FILE *file, Uint64 value, int bytes)
+{
+	int i;
+
+	for (i = 0; i < bytes; i++)
+	{
+		if (fputc((int)((value >> (8 * i)) & 0xFF), file) == EOF)
+			return (1);
+	}
+	return (0);
+}
+
+/**
+ * readLE - Reads an unsigned little-endian value.
+ * @file: Input stream.
+ * @value: Pointer that receives the value.
+ * @bytes: Number of bytes to read.
+ *
+ * Return: 0 on success, 1 on end of file.
+ */
+
+static int readLE(FILE *file, Uint64 *value, int bytes)
+{
+	int i, c;
+
+	*value = 0;
+	for (i = 0; i < bytes; i++)
+	{
+		c = fgetc(file);
+		if (c == EOF)
+			return (1);
+		*value |= (Uint64)c << (8 * i);
+	}
+	return (0);
+}
+
+/**
+ * flushRun - Writes the pending input run, if any.
+ * @recording: Pointer to the recording.
+ *
+ * Return: 0 on success, 1 on a write error.
+ */
+
+static int flushRun(Recording *recording)
+{
+	if (recording->runLength == 0)
+		return (0);
+	if (writeLE(recording->file, recording->runInput, 2) != 0 ||
+			writeLE(recording->file, recording->runLength, 2) != 0)
+		return (1);
+	recording->runLength = 0;
+	return (0);
+}
+
+/**
+ * start_recording - Creates a recording file and writes its header.
+ * @recording: Pointer to the Recording to initialize.
+ * @path: Output file path.
+ * @seed: Seed of the game state's random number generator.
+ * @level: Level the session starts on (1-based).
+ * @flags: RECORDING_GENERATED if the levels are generated from @seed.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int start_recording(Recording *recording, const char *path, Uint64 seed,
+		int level, Uint16 flags)
+{
+	memset(recording, 0, sizeof(*recording));
+	recording->file = fopen(path, "wb");
+	if (!recording->file)
+	{
+		fprintf(stderr, "Could not create recording %s\n", path);
+		return (1);
+	}
+	recording->seed = seed;
+	recording->level = level;
+	recording->flags = flags;
+
+	/* The tick count is patched by stop_recording */
+	if (fwrite(RECORDING_MAGIC, 1, 4, recording->file) != 4 ||
+			writeLE(recording->file, RECORDING_VERSION, 2) != 0 ||
+			writeLE(recording->file, level, 2) != 0 ||
+			writeLE(recording->file, flags, 2) != 0 ||
+			writeLE(recording->file, seed, 8) != 0 ||
+			writeLE(recording->file, 0, 4) != 0)
+	{
+		fprintf(stderr, "Could not write recording header\n");
+		fclose(recording->file);
+		recording->file = NULL;
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * record_input - Appends one tick of input to a recording.
+ * @recording: Pointer to a recording opened with start_recording.
+ * @input: The input bits used for the tick.
+ */
+
+void record_input(Recording *recording, Uint16 input)
+{
+	if (!recording->file)
+		return;
+
+	if (recording->runLength > 0 && (input != recording->runInput ||
+				recording->runLength == 0xFFFF))
+		flushRun(recording);
+
+	recording->runInput = input;
+	recording->runLength++;
+	recording->ticks++;
+}
+
+/**
+ * stop_recording - Flushes the last run, patches the header and closes the
+ * file.
+ * @recording: Pointer to the recording.
+ *
+ * Return: 0 on success, 1 on a write error.
+ */
+
+int stop_recording(Recording *recording)
+{
+	int status = 0;
+
+	if (!recording->file)
+		return (0);
+
+	if (flushRun(recording) != 0 || fseek(recording->file, 18, SEEK_SET) != 0 ||
+			writeLE(recording->file, recording->ticks, 4) != 0)
+	{
+		fprintf(stderr, "Could not finish writing the recording\n");
+		status = 1;
+	}
+	fclose(recording->file);
+	recording->file = NULL;
+
+	return (status);
+}
+
+/**
+ * open_replay - Opens a recording for playback and reads its header.
+ * @recording: Pointer to the Recording to initialize.
+ * @path: Recording file path.
+ *
+ * Return: 0 on success, 1 on failure or a level other than 1 to 6.
+ */
+
+int open_replay(Recording *recording, const char *path)
+{
+	char magic[4];
+	Uint64 version, level, flags = 0, seed, ticks;
+
+	memset(recording, 0, sizeof(*recording));
+	recording->file = fopen(path, "rb");
+	if (!recording->file)
+	{
+		fprintf(stderr, "Could not open recording %s\n", path);
+		return (1);
+	}
+
+	if (fread(magic, 1, 4, recording->file) != 4 ||
+			memcmp(magic, RECORDING_MAGIC, 4) != 0 ||
+			readLE(recording->file, &version, 2) != 0 ||
+			version < 1 || version > RECORDING_VERSION ||
+			readLE(recording->file, &level, 2) != 0 ||
+			(version >= 2 && readLE(recording->file, &flags, 2) != 0) ||
+			readLE(recording->file, &seed, 8) != 0 ||
+			readLE(recording->file, &ticks, 4) != 0)
+	{
+		fprintf(stderr, "%s is not a recording of version %d or older\n",
+				path, RECORDING_VERSION);
+		fclose(recording->file);
+		recording->file = NULL;
+		return (1);
+	}
+	if (level < 1 || level > 6)
+	{
+		fprintf(stderr, "%s records level %u, not 1 to 6\n", path,
+				(unsigned int)level);
+		fclose(recording->file);
+		recording->file = NULL;
+		return (1);
+	}
+
+	recording->level = (int)level;
+	recording->flags = (Uint16)flags;
+	recording->seed = seed;
+	recording->ticks = (Uint32)ticks;
+
+	return (0);
+}
+
+/**
+ * next_replay_input - Returns the input of the next recorded tick.
+ * @recording: Pointer to a recording opened with open_replay.
+ * @input: Pointer that receives the input bits.
+ *
+ * Return: true while ticks remain, false at the end of the recording.
+ */
+
+bool next_replay_input(Recording *recording, Uint16 *input)
+{
+	Uint64 value, length;
+
+	if (!recording->file || recording->position >= recording->ticks)
+		return (false);
+
+	if (recording->runLength == 0)
+	{
+		if (readLE(recording->file, &value, 2) != 0 ||
+				readLE(recording->file, &length, 2) != 0 || length == 0)
+		{
+			fprintf(stderr, "Recording ended early at tick %u\n",
+					(unsigned int)recording->position);
+			return (false);
+		}
+		recording->runInput = (Uint16)value;
+		recording->runLength = (Uint16)length;
+	}
+
+	*input = recording->runInput;
+	recording->runLength--;
+	recording->position++;
+	return (true);
+}
+
+/**
+ * close_replay - Closes a recording opened with open_replay.
+ * @recording: Pointer to the recording.
+ */
+
+void close_replay(Recording *recording)
+{
+	if (recording->file)
+	{
+		fclose(recording->file);
+		recording->file = NULL;
+	}
+}
+
+/**
+ * compareFrameTimes - qsort comparator for frame times.
+ * @a: Pointer to the first double.
+ * @b: Pointer to the second double.
+ *
+ * Return: Negative, zero or positive as with strcmp.
+ */
+
+static int compareFrameTimes(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return ((x > y) - (x < y));
+}
+
+/**
+ * report_timedemo - Prints frame time statistics for a timedemo run.
+ * @frameTimes: Frame times in milliseconds, sorted in place.
+ * @count: Number of frames.
+ */
+
+void report_timedemo(double *frameTimes, Uint32 count)
+{
+	double total = 0;
+	Uint32 i;
+
+	if (count == 0)
+	{
+		printf("timedemo: no frames\n");
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		total += frameTimes[i];
+	qsort(frameTimes, count, sizeof(double), compareFrameTimes);
+
+	printf("timedemo: %u frames in %.1f ms, %.2f fps\n", (unsigned int)count,
+			total, count * 1000.0 / total);
+	printf("timedemo: avg %.3f ms, min %.3f ms, p50 %.3f ms, p95 %.3f ms, "
+			"p99 %.3f ms, max %.3f ms\n", total / count, frameTimes[0],
+			frameTimes[count * 50 / 100], frameTimes[count * 95 / 100],
+			frameTimes[count * 99 / 100], frameTimes[count - 1]);
+}
@@ -0,0 +1,51 @@
+#include "../headers/mazemania.h"
+
+/**
+ * seed_rng - Seeds a generator state.
+ * @state: Pointer to the generator state to initialize.
+ * @seed: Any 64-bit value, including 0.
+ *
+ * The seed is run through one splitmix64 round so that nearby seeds give
+ * unrelated sequences and the xorshift state is never zero.
+ */
+
+void seed_rng(Uint64 *state, Uint64 seed)
+{
+	Uint64 z = seed + 0x9E3779B97F4A7C15ULL;
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	*state = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * next_rng - Draws the next value from a generator (xorshift64*).
+ * @state: Pointer to the generator state.
+ *
+ * Return: A 32-bit pseudo-random value.
+ */
+
+Uint32 next_rng(Uint64 *state)
+{
+	Uint64 x = *state;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return ((Uint32)((x * 0x2545F4914F6CDD1DULL) >> 32));
+}
+
+/**
+ * rng_range - Draws a value in [0, bound).
+ * @state: Pointer to the generator state.
+ * @bound: Exclusive upper bound, must be positive.
+ *
+ * Return: A pseudo-random value below bound.
+ */
+
+int rng_range(Uint64 *state, int bound)
+{
+	return ((int)(((Uint64)next_rng(state) * (Uint32)bound) >> 32));
+}
@@ -0,0 +1,453 @@
+#include "../headers/mazemania.h"
+
+/* Words of a SaveState, the unit rewind deltas are encoded in */
+#define SAVE_WORDS (sizeof(SaveState) / sizeof(Uint32))
+
+/**
+ * capture_save_state - Copies the simulation state into a save state.
+ * @save: Receives the state.
+ * @state: The game state.
+ * @enemies: The level's 4 * @state->level enemies.
+ * @pool: Projectiles in flight.
+ *
+ * Only copies, so it is cheap enough to run every tick.
+ */
+
+void capture_save_state(SaveState *save, const GameState *state,
+		const Enemy *enemies, const ProjectilePool *pool)
+{
+	int i;
+
+	memset(save, 0, sizeof(*save));
+	save->magic = SAVE_MAGIC;
+	save->version = SAVE_VERSION;
+	save->size = sizeof(SaveState);
+	save->numEnemies = 4 * state->level;
+	memcpy(&save->state, state, sizeof(*state));
+	for (i = 0; i < save->numEnemies; i++)
+	{
+		save->enemies[i].rect = enemies[i].rect;
+		save->enemies[i].speed = enemies[i].speed;
+		save->enemies[i].health = enemies[i].health;
+		save->enemies[i].direction = enemies[i].direction;
+		save->enemies[i].lastThink = enemies[i].lastThink;
+		save->enemies[i].alertUntil = enemies[i].alertUntil;
+	}
+	memcpy(save->map, worldMap, sizeof(worldMap));
+	get_explored(save->explored);
+	memcpy(&save->projectiles, pool, sizeof(*pool));
+}
+
+/**
+ * restore_save_state - Puts the simulation back into a saved state.
+ * @save: The state.
+ * @state: The game state.
+ * @enemies: The level's enemies.
+ * @pool: Projectiles in flight.
+ * @levelManager: The level manager, loading the saved level if it is not
+ * the current one.
+ * @instance: Instance the enemy textures of another level are created
+ * with.
+ *
+ * Changing the level or the world map touches what the renderer reads, so
+ * it must happen on the render thread; the tiles of the map that differ
+ * go through setTile, so only the caches around them are repaired. A
+ * restore within the current level and map only writes the simulation's
+ * own state and can run anywhere.
+ *
+ * Return: 0 on success, 1 if the enemy textures could not be created.
+ */
+
+int restore_save_state(const SaveState *save, GameState *state,
+		Enemy *enemies, ProjectilePool *pool, LevelManager *levelManager,
+		SDL_Instance *instance)
+{
+	SDL_Texture *texture;
+	int i, x, y;
+
+	if (save->state.level != state->level)
+	{
+		free_enemies(enemies, 4 * state->level);
+		levelManager->current_Level = save->state.level - 1;
+		loadCurrentLevel(levelManager);
+		/* One texture for the level's enemies, as load_enemies makes */
+		if (load_EnemyTexture(instance->renderer, ENEMY_TEXTURE_PATH,
+					&texture, false) != 0)
+			return (1);
+		for (i = 0; i < save->numEnemies; i++)
+			enemies[i].texture = texture;
+	}
+	/* Only the tiles that differ are repaired, as after a door opening */
+	for (y = 0; y < mapHeight; y++)
+		for (x = 0; x < mapWidth; x++)
+			setTile(x, y, save->map[y][x]);
+	flush_tiles();
+	set_explored(save->explored);
+
+	*state = save->state;
+	for (i = 0; i < save->numEnemies; i++)
+	{
+		enemies[i].rect = save->enemies[i].rect;
+		enemies[i].speed = save->enemies[i].speed;
+		enemies[i].health = save->enemies[i].health;
+		enemies[i].direction = save->enemies[i].direction;
+		enemies[i].lastThink = save->enemies[i].lastThink;
+		enemies[i].alertUntil = save->enemies[i].alertUntil;
+	}
+	*pool = save->projectiles;
+
+	return (0);
+}
+
+/**
+ * write_save_state - Writes a save state to a file.
+ * @save: The state.
+ * @path: Path of the file.
+ *
+ * The state is written as it is in memory, so a save only loads back into
+ * a build with the same layout, which read_save_state checks.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int write_save_state(const SaveState *save, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	int status;
+
+	if (!file)
+	{
+		fprintf(stderr, "Could not create %s\n", path);
+		return (1);
+	}
+	status = fwrite(save, sizeof(*save), 1, file) != 1;
+	if (fclose(file) != 0)
+		status = 1;
+	if (status)
+		fprintf(stderr, "Could not write %s\n", path);
+
+	return (status);
+}
+
+/**
+ * validSaveState - Checks that a save state read from a file is sane.
+ * @save: The state.
+ *
+ * Return: true if it can be restored without indexing out of bounds.
+ */
+
+static bool validSaveState(const SaveState *save)
+{
+	const ProjectilePool *pool = &save->projectiles;
+	int i, x, y;
+
+	if (save->magic != SAVE_MAGIC || save->version != SAVE_VERSION ||
+			save->size != sizeof(SaveState))
+		return (false);
+	if (save->state.level < 1 || save->state.level > 6 ||
+			save->numEnemies != 4 * save->state.level)
+		return (false);
+	for (y = 0; y < mapHeight; y++)
+		for (x = 0; x < mapWidth; x++)
+			if (save->map[y][x] < 0 || save->map[y][x] > 5)
+				return (false);
+
+	if (pool->numLive < 0 || pool->numLive > MAX_PROJECTILES ||
+			pool->freeHead < -1 || pool->freeHead >= MAX_PROJECTILES)
+		return (false);
+	for (i = 0; i < pool->numLive; i++)
+		if (pool->live[i] < 0 || pool->live[i] >= MAX_PROJECTILES)
+			return (false);
+	for (i = 0; i < MAX_PROJECTILES; i++)
+		if (pool->slots[i].next < -1 || pool->slots[i].next >= MAX_PROJECTILES)
+			return (false);
+
+	return (true);
+}
+
+/**
+ * read_save_state - Reads a save state written by write_save_state.
+ * @save: Receives the state.
+ * @path: Path of the file.
+ *
+ * Return: 0 on success, 1 if the file is missing, short or not a save of
+ * this build.
+ */
+
+int read_save_state(SaveState *save, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	int status;
+
+	if (!file)
+	{
+		fprintf(stderr, "Could not open %s\n", path);
+		return (1);
+	}
+	status = fread(save, sizeof(*save), 1, file) != 1;
+	fclose(file);
+	if (status || !validSaveState(save))
+	{
+		fprintf(stderr, "%s is not a save of this game\n", path);
+		return (1);
+	}
+
+	return (0);
+}
+
+/**
+ * init_rewind - Allocates an empty rewind buffer.
+ * @rewind: The buffer.
+ *
+ * The whole budget is allocated and touched here, so pushing a tick never
+ * allocates or page-faults.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int init_rewind(RewindBuffer *rewind)
+{
+	memset(rewind, 0, sizeof(*rewind));
+	rewind->arena = mem_alloc(MEM_SIMULATION, REWIND_BUDGET);
+	rewind->key = mem_alloc(MEM_SIMULATION, sizeof(SaveState));
+	rewind->delta = mem_alloc(MEM_SIMULATION, sizeof(SaveState));
+	if (!rewind->arena || !rewind->key || !rewind->delta)
+	{
+		fprintf(stderr, "Could not allocate the rewind buffer\n");
+		free_rewind(rewind);
+		return (1);
+	}
+	memset(rewind->arena, 0, REWIND_BUDGET);
+
+	return (0);
+}
+
+/**
+ * clear_rewind - Forgets every tick in a rewind buffer.
+ * @rewind: The buffer.
+ */
+
+void clear_rewind(RewindBuffer *rewind)
+{
+	rewind->head = 0;
+	rewind->first = 0;
+	rewind->next = 0;
+	rewind->hasKey = false;
+}
+
+/**
+ * encodeDelta - Encodes the words of a save state that differ from the
+ * buffer's keyframe.
+ * @rewind: The buffer; the delta is written to @rewind->delta.
+ * @save: The state.
+ *
+ * The delta is a list of runs, each a header word holding the number of
+ * unchanged words to skip in its high half and the number of changed
+ * words following it in its low half.
+ *
+ * Return: Size of the delta in bytes, or sizeof(SaveState) if it would be
+ * no smaller than a keyframe.
+ */
+
+static Uint32 encodeDelta(RewindBuffer *rewind, const SaveState *save)
+{
+	const Uint32 *key = (const Uint32 *)rewind->key;
+	const Uint32 *words = (const Uint32 *)save;
+	Uint32 *out = rewind->delta, *header;
+	Uint32 limit = SAVE_WORDS, length = 0, i = 0, skip, count;
+
+	while (i < SAVE_WORDS)
+	{
+		for (skip = 0; i < SAVE_WORDS && words[i] == key[i] && skip < 0xFFFF;
+				skip++)
+			i++;
+		if (i == SAVE_WORDS)
+			break;
+		if (length + 1 >= limit)
+			return (sizeof(SaveState));
+		header = &out[length++];
+		for (count = 0; i < SAVE_WORDS && words[i] != key[i] &&
+				count < 0xFFFF; count++)
+		{
+			if (length >= limit)
+				return (sizeof(SaveState));
+			out[length++] = words[i++];
+		}
+		*header = skip << 16 | count;
+	}
+
+	return (length * sizeof(Uint32));
+}
+
+/**
+ * dropOldest - Frees the oldest keyframe of a rewind buffer and every
+ * delta encoded against it.
+ * @rewind: The buffer, holding at least one record.
+ */
+
+static void dropOldest(RewindBuffer *rewind)
+{
+	do {
+		rewind->first++;
+	} while (rewind->first != rewind->next &&
+			rewind->records[rewind->first % REWIND_RECORDS].key !=
+			rewind->first);
+
+	if (rewind->hasKey && rewind->keySeq < rewind->first)
+		rewind->hasKey = false;
+	if (rewind->first == rewind->next)
+		rewind->head = 0;
+}
+
+/**
+ * reserveRecord - Finds arena space for a new record.
+ * @rewind: The buffer.
+ * @size: Bytes needed.
+ *
+ * Records are laid out one after the other and wrap to the start of the
+ * arena when the end is reached; the oldest ticks are dropped until there
+ * is room. The head only meets the oldest record when the ring is empty.
+ *
+ * Return: Arena offset of the space.
+ */
+
+static Uint32 reserveRecord(RewindBuffer *rewind, Uint32 size)
+{
+	Uint32 tail;
+
+	for (;;)
+	{
+		if (rewind->first == rewind->next)
+			return (0);
+		tail = rewind->records[rewind->first % REWIND_RECORDS].offset;
+		if (rewind->next - rewind->first < REWIND_RECORDS)
+		{
+			if (rewind->head < tail && rewind->head + size < tail)
+				return (rewind->head);
+			if (rewind->head >= tail && rewind->head + size <= REWIND_BUDGET)
+				return (rewind->head);
+			if (rewind->head >= tail && size < tail)
+				return (0);
+		}
+		dropOldest(rewind);
+	}
+}
+
+/**
+ * rewind_push - Stores a tick in a rewind buffer.
+ * @rewind: The buffer.
+ * @save: State at the end of the tick, from capture_save_state.
+ *
+ * A keyframe is stored every REWIND_KEYFRAME ticks, or sooner if a delta
+ * would not be smaller; other ticks store a delta against the newest
+ * keyframe. Once REWIND_BUDGET is full the oldest ticks are dropped.
+ */
+
+void rewind_push(RewindBuffer *rewind, const SaveState *save)
+{
+	RewindRecord *record;
+	Uint32 size = sizeof(SaveState), offset;
+
+	if (rewind->hasKey && rewind->next - rewind->keySeq < REWIND_KEYFRAME)
+		size = encodeDelta(rewind, save);
+	offset = reserveRecord(rewind, size);
+	/* Making room may have dropped the keyframe the delta is against */
+	if (size != sizeof(SaveState) && !rewind->hasKey)
+	{
+		size = sizeof(SaveState);
+		offset = reserveRecord(rewind, size);
+	}
+
+	record = &rewind->records[rewind->next % REWIND_RECORDS];
+	record->offset = offset;
+	record->size = size;
+	if (size == sizeof(SaveState))
+	{
+		memcpy(rewind->arena + offset, save, size);
+		memcpy(rewind->key, save, size);
+		rewind->keySeq = rewind->next;
+		rewind->hasKey = true;
+	}
+	else
+		memcpy(rewind->arena + offset, rewind->delta, size);
+	record->key = rewind->keySeq;
+	rewind->head = offset + size;
+	rewind->next++;
+}
+
+/**
+ * decodeRecord - Rebuilds the state a record holds.
+ * @rewind: The buffer.
+ * @seq: Sequence number of the record; its keyframe must be in the ring.
+ * @save: Receives the state.
+ */
+
+static void decodeRecord(const RewindBuffer *rewind, Uint32 seq,
+		SaveState *save)
+{
+	const RewindRecord *record = &rewind->records[seq % REWIND_RECORDS];
+	const RewindRecord *key = &rewind->records[record->key % REWIND_RECORDS];
+	const Uint32 *in = (const Uint32 *)(rewind->arena + record->offset);
+	const Uint32 *end = in + record->size / sizeof(Uint32);
+	Uint32 *words = (Uint32 *)save, i = 0, count;
+
+	memcpy(save, rewind->arena + key->offset, sizeof(SaveState));
+	if (record->key == seq)
+		return;
+	while (in < end)
+	{
+		i += *in >> 16;
+		count = *in++ & 0xFFFF;
+		memcpy(&words[i], in, count * sizeof(Uint32));
+		in += count;
+		i += count;
+	}
+}
+
+/**
+ * rewind_step - Steps a rewind buffer back by one tick.
+ * @rewind: The buffer; its newest record is the current tick, which is
+ * dropped.
+ * @save: Receives the tick before it, now the newest.
+ *
+ * Return: 0 on success, 1 if there is no earlier tick left.
+ */
+
+int rewind_step(RewindBuffer *rewind, SaveState *save)
+{
+	const RewindRecord *newest;
+
+	if (rewind->next - rewind->first < 2)
+		return (1);
+
+	rewind->next--;
+	rewind->head = rewind->records[rewind->next % REWIND_RECORDS].offset;
+	decodeRecord(rewind, rewind->next - 1, save);
+
+	newest = &rewind->records[(rewind->next - 1) % REWIND_RECORDS];
+	if (newest->key != rewind->keySeq || !rewind->hasKey)
+	{
+		rewind->keySeq = newest->key;
+		memcpy(rewind->key, rewind->arena +
+				rewind->records[newest->key % REWIND_RECORDS].offset,
+				sizeof(SaveState));
+		rewind->hasKey = true;
+	}
+
+	return (0);
+}
+
+/**
+ * free_rewind - Frees what init_rewind allocated.
+ * @rewind: The buffer.
+ */
+
+void free_rewind(RewindBuffer *rewind)
+{
+	mem_free(rewind->arena);
+	rewind->arena = NULL;
+	mem_free(rewind->key);
+	rewind->key = NULL;
+	mem_free(rewind->delta);
+	rewind->delta = NULL;
+}
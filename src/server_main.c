@@ -0,0 +1,128 @@
+#include "../headers/mazemania.h"
+#include <signal.h>
+
+int worldMap[mapHeight][mapWidth];
+
+static volatile sig_atomic_t stopRequested;
+
+/**
+ * requestStop - Signal handler ending the server loop.
+ * @signal: Unused.
+ */
+
+static void requestStop(int signal)
+{
+	(void)signal;
+	stopRequested = 1;
+}
+
+/**
+ * reportLoad - Prints the server's load since the last report.
+ * @server: The server; its counters are reset.
+ * @ticks: Ticks run since the last report.
+ */
+
+static void reportLoad(NetServer *server, Uint32 ticks)
+{
+	int clients = 0, i;
+
+	for (i = 0; i < NET_MAX_PLAYERS; i++)
+		clients += server->peers[i].connected;
+	printf("{\"tick\":%u,\"level\":%d,\"clients\":%d,\"tickMicros\":%.1f,"
+			"\"coreShare\":%.4f,\"bytesPerSnapshot\":%.1f}\n", server->tick,
+			server->level, clients, server->busySeconds * 1e6 / ticks,
+			server->busySeconds * TICK_RATE / ticks,
+			server->snapshotsSent ? (double)server->bytesSent /
+			server->snapshotsSent : 0.0);
+	fflush(stdout);
+	server->busySeconds = 0;
+	server->bytesSent = 0;
+	server->snapshotsSent = 0;
+}
+
+/**
+ * main - Entry point of the multiplayer server.
+ * @argc: Argument count.
+ * @argv: Argument vector.
+ *
+ * Usage: mazeserver [--port N] [--seed N] [--generate] [--level N]
+ * [--ticks N] runs a shared maze at TICK_RATE on one thread until it is
+ * interrupted or has run N ticks, printing its load every five seconds as
+ * one JSON object per line.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int main(int argc, char *argv[])
+{
+	NetServer server;
+	Uint64 seed = time(NULL), frequency = SDL_GetPerformanceFrequency();
+	Uint64 last, now;
+	Uint32 maxTicks = 0, reported = 0;
+	double accumulator = 0, tickSeconds = 1.0 / TICK_RATE;
+	bool generate = false;
+	int port = NET_PORT, level = 1, i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+			port = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--generate") == 0)
+			generate = true;
+		else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+			level = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+			maxTicks = strtoul(argv[++i], NULL, 0);
+		else
+			level = 0;
+	}
+	if (level < 1 || level > 6 || port <= 0 || port > 65535)
+	{
+		fprintf(stderr, "Usage: %s [--port N] [--seed N] [--generate] "
+				"[--level N] [--ticks N]\n", argv[0]);
+		return (1);
+	}
+
+	if (load_worlds_from_file() != 0 ||
+			server_init(&server, port, seed, generate, level) != 0)
+	{
+		fprintf(stderr, "Could not start the server\n");
+		return (1);
+	}
+	signal(SIGINT, requestStop);
+	signal(SIGTERM, requestStop);
+	fprintf(stderr, "Serving level %d on UDP port %d, seed %llu\n", level,
+			port, (unsigned long long)seed);
+
+	last = SDL_GetPerformanceCounter();
+	while (!stopRequested && (maxTicks == 0 || server.tick < maxTicks))
+	{
+		now = SDL_GetPerformanceCounter();
+		accumulator += (double)(now - last) / frequency;
+		last = now;
+		/* Don't try to catch up on more than a quarter second */
+		if (accumulator > 0.25)
+			accumulator = 0.25;
+
+		while (accumulator >= tickSeconds &&
+				(maxTicks == 0 || server.tick < maxTicks))
+		{
+			accumulator -= tickSeconds;
+			server_tick(&server);
+			if (server.tick - reported >= TICK_RATE * 5)
+			{
+				reportLoad(&server, server.tick - reported);
+				reported = server.tick;
+			}
+		}
+		SDL_Delay(1);
+	}
+
+	if (server.tick > reported)
+		reportLoad(&server, server.tick - reported);
+	server_free(&server);
+
+	return (0);
+}
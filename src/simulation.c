@@ -0,0 +1,565 @@
+#include "../headers/mazemania.h"
+
+/**
+ * init_snapshots - Fills every slot of a triple buffer with one snapshot.
+ * @buffer: The buffer.
+ * @initial: Snapshot the reader sees until the first publish.
+ */
+
+void init_snapshots(SnapshotBuffer *buffer, const Snapshot *initial)
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+		buffer->slots[i] = *initial;
+	buffer->back = 0;
+	buffer->front = 1;
+	SDL_AtomicSet(&buffer->spare, 2);
+}
+
+/**
+ * snapshot_back - Returns the slot the writer fills next.
+ * @buffer: The buffer.
+ *
+ * Return: The slot; the reader never looks at it until it is published.
+ */
+
+Snapshot *snapshot_back(SnapshotBuffer *buffer)
+{
+	return (&buffer->slots[buffer->back]);
+}
+
+/**
+ * publish_snapshot - Hands the filled back slot to the reader.
+ * @buffer: The buffer.
+ *
+ * The filled slot becomes the fresh spare and the old spare becomes the
+ * next back slot. A spare the reader never took is simply overwritten.
+ */
+
+void publish_snapshot(SnapshotBuffer *buffer)
+{
+	SDL_MemoryBarrierRelease();
+	buffer->back = SDL_AtomicSet(&buffer->spare,
+			buffer->back | SNAPSHOT_FRESH) & 3;
+}
+
+/**
+ * latest_snapshot - Returns the newest complete snapshot.
+ * @buffer: The buffer.
+ *
+ * Return: The snapshot, valid until the next call; the same one as last
+ * time if nothing was published since.
+ */
+
+const Snapshot *latest_snapshot(SnapshotBuffer *buffer)
+{
+	if (SDL_AtomicGet(&buffer->spare) & SNAPSHOT_FRESH)
+	{
+		buffer->front = SDL_AtomicSet(&buffer->spare, buffer->front) & 3;
+		SDL_MemoryBarrierAcquire();
+	}
+	return (&buffer->slots[buffer->front]);
+}
+
+/**
+ * takeSnapshot - Copies the simulation state into a snapshot.
+ * @sim: The simulation.
+ * @snapshot: Receives the copy.
+ */
+
+static void takeSnapshot(const Simulation *sim, Snapshot *snapshot)
+{
+	snapshot->state = sim->state;
+	snapshot->numEnemies = 4 * sim->state.level;
+	memcpy(snapshot->enemies, sim->enemies,
+			snapshot->numEnemies * sizeof(Enemy));
+}
+
+/**
+ * init_simulation - Prepares a simulation whose state, enemies, level
+ * manager, instance, recording and speed are already filled in.
+ * @sim: The simulation.
+ *
+ * The starting state is kept for INPUT_RESTART.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int init_simulation(Simulation *sim)
+{
+	Snapshot initial;
+
+	if (init_rewind(&sim->rewind) != 0)
+		return (1);
+	sim->startSave = mem_alloc(MEM_SIMULATION, sizeof(SaveState));
+	sim->quicksave = mem_alloc(MEM_SIMULATION, sizeof(SaveState));
+	sim->scratch = mem_alloc(MEM_SIMULATION, sizeof(SaveState));
+	sim->levelDone = SDL_CreateSemaphore(0);
+	if (!sim->levelDone || !sim->startSave || !sim->quicksave ||
+			!sim->scratch)
+	{
+		fprintf(stderr, "Could not create the simulation: %s\n",
+				SDL_GetError());
+		free_simulation(sim);
+		return (1);
+	}
+
+	init_projectiles(&sim->projectiles);
+	capture_save_state(sim->startSave, &sim->state, sim->enemies,
+			&sim->projectiles);
+	sim->hasQuicksave = false;
+	sim->levelRestore = NULL;
+	sim->editTile = -1;
+	takeSnapshot(sim, &initial);
+	init_snapshots(&sim->snapshots, &initial);
+	SDL_AtomicSet(&sim->heldInput, 0);
+	SDL_AtomicSet(&sim->oneshotInput, 0);
+	SDL_AtomicSet(&sim->running, 1);
+	SDL_AtomicSet(&sim->levelRequest, 0);
+	sim->status = 0;
+	sim->thread = NULL;
+
+	return (0);
+}
+
+/**
+ * waitForRenderThread - Hands the request set up in the simulation to the
+ * render thread and waits until it is done.
+ * @sim: The simulation.
+ *
+ * Return: The request's status, or 1 if the session ended first.
+ */
+
+static int waitForRenderThread(Simulation *sim)
+{
+	SDL_AtomicSet(&sim->levelRequest, 1);
+	while (SDL_SemWaitTimeout(sim->levelDone, 10) != 0)
+	{
+		if (!SDL_AtomicGet(&sim->running))
+			return (1);
+	}
+	return (sim->levelStatus);
+}
+
+/**
+ * requestLevelChange - Has the render thread run checkLevelCompletion, or
+ * restore a save state.
+ * @sim: The simulation.
+ * @restore: Save state to restore, or NULL to move on to the next level.
+ *
+ * Loading a level reloads the world map the renderer reads and creates
+ * enemy textures, which only the thread owning the renderer may do, so
+ * the simulation thread waits while the render thread does it between
+ * two frames. This and requestTileEdit are the only times the two
+ * threads synchronise.
+ *
+ * Return: checkLevelCompletion's result, -1 if the restore failed, or 1
+ * if the session ended first.
+ */
+
+static int requestLevelChange(Simulation *sim, const SaveState *restore)
+{
+	sim->levelRestore = restore;
+	return (waitForRenderThread(sim));
+}
+
+/**
+ * requestTileEdit - Has the render thread change one tile of the map.
+ * @sim: The simulation.
+ * @x: Column of the tile.
+ * @y: Row of the tile.
+ * @id: New tile id.
+ *
+ * The renderer reads the world map and its visibility and light caches
+ * while drawing, so like a level change the edit is made between frames.
+ *
+ * Return: 0 on success, or 1 if the session ended first.
+ */
+
+static int requestTileEdit(Simulation *sim, int x, int y, int id)
+{
+	sim->levelRestore = NULL;
+	sim->editX = x;
+	sim->editY = y;
+	sim->editTile = id;
+	return (waitForRenderThread(sim));
+}
+
+/**
+ * tileOccupied - Tells whether the player or a live enemy overlaps a tile.
+ * @sim: The simulation.
+ * @x: Column of the tile.
+ * @y: Row of the tile.
+ *
+ * Return: true if so.
+ */
+
+static bool tileOccupied(const Simulation *sim, int x, int y)
+{
+	SDL_Rect tile = {x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+	int i;
+
+	if (SDL_HasIntersection(&tile, &sim->state.player))
+		return (true);
+	for (i = 0; i < 4 * sim->state.level; i++)
+	{
+		if (sim->enemies[i].health > 0 &&
+				SDL_HasIntersection(&tile, &sim->enemies[i].rect))
+			return (true);
+	}
+
+	return (false);
+}
+
+/**
+ * editTileAhead - Opens or closes the tile in front of the player.
+ * @sim: The simulation.
+ * @threaded: Whether this runs on the simulation thread.
+ *
+ * The tile one TILE_SIZE ahead of the player's centre turns from an inner
+ * wall into floor, or from floor into an inner wall unless someone stands
+ * in it. The border and other tiles are left alone.
+ *
+ * Return: 0 on success, 1 if the session ended first.
+ */
+
+static int editTileAhead(Simulation *sim, bool threaded)
+{
+	double radians = DEG_TO_RAD(sim->state.degrees);
+	int x = (int)floor((sim->state.player.x + sim->state.player.w / 2 +
+				cos(radians) * TILE_SIZE) / TILE_SIZE);
+	int y = (int)floor((sim->state.player.y + sim->state.player.h / 2 +
+				sin(radians) * TILE_SIZE) / TILE_SIZE);
+	int id;
+
+	if (x <= 0 || x >= mapWidth - 1 || y <= 0 || y >= mapHeight - 1)
+		return (0);
+	if (worldMap[y][x] == 2)
+		id = 0;
+	else if (worldMap[y][x] == 0 && !tileOccupied(sim, x, y))
+		id = 2;
+	else
+		return (0);
+
+	if (threaded)
+		return (requestTileEdit(sim, x, y, id));
+	setTile(x, y, id);
+	flush_tiles();
+	return (0);
+}
+
+/**
+ * restoreSave - Puts the simulation back into a save state.
+ * @sim: The simulation.
+ * @save: The state.
+ * @threaded: Whether this runs on the simulation thread.
+ *
+ * A state of another level or map is restored by the render thread, see
+ * requestLevelChange.
+ *
+ * Return: 0 on success, -1 on error, 1 if the session ended first.
+ */
+
+static int restoreSave(Simulation *sim, const SaveState *save, bool threaded)
+{
+	if (threaded && (save->state.level != sim->state.level ||
+				memcmp(save->map, worldMap, sizeof(worldMap)) != 0))
+		return (requestLevelChange(sim, save));
+
+	return (restore_save_state(save, &sim->state, sim->enemies,
+				&sim->projectiles, sim->levelManager, sim->instance) ? -1 : 0);
+}
+
+/**
+ * handleSaveInput - Acts on the save, load and restart keys.
+ * @sim: The simulation.
+ * @input: Input bits for this tick.
+ * @threaded: Whether this runs on the simulation thread.
+ *
+ * INPUT_SAVE keeps the current state as the quicksave and, outside
+ * replays, writes it to SAVE_PATH. INPUT_LOAD restores the quicksave; if
+ * there is none yet it is read from SAVE_PATH, except in a recorded or
+ * replayed session, which must not depend on files outside the recording.
+ * INPUT_RESTART restores the state the session started in.
+ *
+ * Return: 0 if nothing was restored, 2 if a state was restored, otherwise
+ * restoreSave's error.
+ */
+
+static int handleSaveInput(Simulation *sim, Uint16 input, bool threaded)
+{
+	const SaveState *save = NULL;
+	int status;
+
+	if (input & INPUT_SAVE)
+	{
+		capture_save_state(sim->quicksave, &sim->state, sim->enemies,
+				&sim->projectiles);
+		sim->hasQuicksave = true;
+		if (!sim->replaying)
+			write_save_state(sim->quicksave, SAVE_PATH);
+	}
+	if (input & INPUT_RESTART)
+		save = sim->startSave;
+	else if (input & INPUT_LOAD)
+	{
+		if (!sim->hasQuicksave && !sim->replaying && !sim->recording &&
+				read_save_state(sim->quicksave, SAVE_PATH) == 0)
+			sim->hasQuicksave = true;
+		if (sim->hasQuicksave)
+			save = sim->quicksave;
+	}
+	if (!save)
+		return (0);
+
+	status = restoreSave(sim, save, threaded);
+	return (status != 0 ? status : 2);
+}
+
+/**
+ * stepTick - Advances the simulation by one tick and publishes it.
+ * @sim: The simulation.
+ * @threaded: Whether this runs on the simulation thread.
+ *
+ * While INPUT_REWIND is held each tick steps back to the one before it
+ * instead of advancing; otherwise the finished tick is pushed to the
+ * rewind buffer. The buffer starts over with each level.
+ *
+ * Return: 0 to keep playing, 1 when the session is over, -1 on error.
+ */
+
+static int stepTick(Simulation *sim, bool threaded)
+{
+	Uint16 input;
+	int status = 0, level = sim->state.level;
+
+	if (sim->replaying)
+	{
+		if (!next_replay_input(sim->recording, &input))
+			return (1);
+	}
+	else
+	{
+		input = SDL_AtomicGet(&sim->heldInput) |
+			SDL_AtomicSet(&sim->oneshotInput, 0);
+		if (sim->recording)
+			record_input(sim->recording, input);
+	}
+
+	if (input & INPUT_REWIND)
+	{
+		if (rewind_step(&sim->rewind, sim->scratch) == 0)
+			status = restoreSave(sim, sim->scratch, threaded);
+		takeSnapshot(sim, snapshot_back(&sim->snapshots));
+		publish_snapshot(&sim->snapshots);
+		return (status);
+	}
+
+	status = handleSaveInput(sim, input, threaded);
+	if (status != 0)
+	{
+		clear_rewind(&sim->rewind);
+		goto publish;
+	}
+
+	if ((input & INPUT_EDIT) && editTileAhead(sim, threaded) != 0)
+	{
+		status = 1;
+		goto publish;
+	}
+
+	updatePlayer(&sim->state, input, sim->speed, 1.0f / TICK_RATE);
+	fire_weapons(&sim->state, &sim->projectiles, sim->enemies, 4 * level,
+			input);
+	step_projectiles(&sim->projectiles, sim->enemies, 4 * level,
+			1.0f / TICK_RATE);
+	sim->state.tick++;
+	update_enemies(sim->enemies, 4 * level, &sim->state, &sim->lod);
+
+	/* Check for level completion */
+	if (atLevelExit(&sim->state))
+		status = threaded ? requestLevelChange(sim, NULL) :
+			checkLevelCompletion(&sim->state, sim->levelManager, sim->enemies,
+					sim->instance);
+	/* Nothing in flight carries over to the next level */
+	if (sim->state.level != level)
+	{
+		init_projectiles(&sim->projectiles);
+		clear_rewind(&sim->rewind);
+	}
+
+publish:
+	if (status == 2)
+		status = 0;
+	capture_save_state(sim->scratch, &sim->state, sim->enemies,
+			&sim->projectiles);
+	rewind_push(&sim->rewind, sim->scratch);
+	takeSnapshot(sim, snapshot_back(&sim->snapshots));
+	publish_snapshot(&sim->snapshots);
+
+	return (status);
+}
+
+/**
+ * step_simulation - Runs one tick on the calling thread.
+ * @sim: The simulation, not started with start_simulation.
+ *
+ * Used when ticks must stay in lockstep with frames, as in a timedemo.
+ *
+ * Return: 0 to keep playing, 1 when the session is over, -1 on error.
+ */
+
+int step_simulation(Simulation *sim)
+{
+	return (stepTick(sim, false));
+}
+
+/**
+ * simulationThread - Thread body running ticks at TICK_RATE.
+ * @data: Pointer to the Simulation.
+ *
+ * Return: Always 0; errors are reported through the status field.
+ */
+
+static int simulationThread(void *data)
+{
+	Simulation *sim = data;
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 last = SDL_GetPerformanceCounter(), now;
+	double accumulator = 0, tickSeconds = 1.0 / TICK_RATE;
+	int status = 0;
+
+	while (status == 0 && SDL_AtomicGet(&sim->running))
+	{
+		now = SDL_GetPerformanceCounter();
+		accumulator += (double)(now - last) / frequency;
+		last = now;
+		/* Don't try to catch up on more than a quarter second */
+		if (accumulator > 0.25)
+			accumulator = 0.25;
+
+		while (status == 0 && accumulator >= tickSeconds)
+		{
+			accumulator -= tickSeconds;
+			status = stepTick(sim, true);
+		}
+		SDL_Delay(1);
+	}
+
+	if (status < 0)
+		sim->status = -1;
+	SDL_AtomicSet(&sim->running, 0);
+
+	return (0);
+}
+
+/**
+ * start_simulation - Starts running ticks on their own thread.
+ * @sim: The simulation.
+ *
+ * From here on the render thread only reads the simulation through
+ * latest_snapshot and feeds it through send_input and
+ * service_level_change, so a slow frame never delays a tick.
+ *
+ * Return: 0 on success, 1 on failure.
+ */
+
+int start_simulation(Simulation *sim)
+{
+	sim->thread = SDL_CreateThread(simulationThread, "simulation", sim);
+	if (!sim->thread)
+	{
+		fprintf(stderr, "Could not start the simulation thread: %s\n",
+				SDL_GetError());
+		return (1);
+	}
+	return (0);
+}
+
+/**
+ * stop_simulation - Ends the session and waits for the simulation thread.
+ * @sim: The simulation.
+ */
+
+void stop_simulation(Simulation *sim)
+{
+	SDL_AtomicSet(&sim->running, 0);
+	if (sim->thread)
+		SDL_WaitThread(sim->thread, NULL);
+	sim->thread = NULL;
+}
+
+/**
+ * send_input - Passes the keyboard state to the simulation.
+ * @sim: The simulation.
+ * @input: Input word built by handleEvent; its one-shot bits are cleared
+ * once handed over.
+ *
+ * Held bits replace the previous ones; one-shot bits accumulate until a
+ * tick consumes them, so a key press between two ticks is never lost.
+ */
+
+void send_input(Simulation *sim, Uint16 *input)
+{
+	int oneshot = *input & INPUT_ONESHOT_MASK, old;
+
+	SDL_AtomicSet(&sim->heldInput, *input & ~INPUT_ONESHOT_MASK);
+	if (!oneshot)
+		return;
+
+	do {
+		old = SDL_AtomicGet(&sim->oneshotInput);
+	} while (!SDL_AtomicCAS(&sim->oneshotInput, old, old | oneshot));
+	*input &= ~INPUT_ONESHOT_MASK;
+}
+
+/**
+ * service_level_change - Makes a level change the simulation asked for.
+ * @sim: The simulation.
+ *
+ * Called by the render thread between frames; see requestLevelChange
+ * and requestTileEdit.
+ */
+
+void service_level_change(Simulation *sim)
+{
+	if (!SDL_AtomicGet(&sim->levelRequest))
+		return;
+
+	if (sim->levelRestore)
+		sim->levelStatus = restore_save_state(sim->levelRestore, &sim->state,
+				sim->enemies, &sim->projectiles, sim->levelManager,
+				sim->instance) ? -1 : 0;
+	else if (sim->editTile >= 0)
+	{
+		setTile(sim->editX, sim->editY, sim->editTile);
+		flush_tiles();
+		sim->editTile = -1;
+		sim->levelStatus = 0;
+	}
+	else
+		sim->levelStatus = checkLevelCompletion(&sim->state,
+				sim->levelManager, sim->enemies, sim->instance);
+	SDL_AtomicSet(&sim->levelRequest, 0);
+	SDL_SemPost(sim->levelDone);
+}
+
+/**
+ * free_simulation - Frees what init_simulation created.
+ * @sim: The simulation, already stopped.
+ */
+
+void free_simulation(Simulation *sim)
+{
+	if (sim->levelDone)
+		SDL_DestroySemaphore(sim->levelDone);
+	sim->levelDone = NULL;
+	mem_free(sim->startSave);
+	sim->startSave = NULL;
+	mem_free(sim->quicksave);
+	sim->quicksave = NULL;
+	mem_free(sim->scratch);
+	sim->scratch = NULL;
+	free_rewind(&sim->rewind);
+}
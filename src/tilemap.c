@@ -0,0 +1,97 @@
+#include "../headers/mazemania.h"
+
+/*
+ * Caches derived from the world map, told about every flushed batch of
+ * edits. The visibility sets and the light grid are always kept in step;
+ * subscribe_tiles adds more.
+ */
+static TileListener listeners[MAX_TILE_LISTENERS] = {
+	update_visibility_tiles, relight_tiles
+};
+static int numListeners = 2;
+/* Tiles edited since the last flush, each listed once */
+static int dirtyTiles[mapHeight * mapWidth];
+static bool dirty[mapHeight * mapWidth];
+static int numDirty;
+
+/**
+ * setTile - Changes one tile of the world map.
+ * @x: Column of the tile.
+ * @y: Row of the tile.
+ * @id: New tile id.
+ *
+ * The tile is only marked dirty; the caches built from the map are
+ * repaired by the next flush_tiles, so several edits of one tick cost a
+ * single repair.
+ *
+ * Return: 0 on success, 1 if the tile lies outside the map.
+ */
+
+int setTile(int x, int y, int id)
+{
+	int tile = y * mapWidth + x;
+
+	if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+		return (1);
+	if (worldMap[y][x] == id)
+		return (0);
+
+	worldMap[y][x] = id;
+	if (!dirty[tile])
+	{
+		dirty[tile] = true;
+		dirtyTiles[numDirty++] = tile;
+	}
+
+	return (0);
+}
+
+/**
+ * subscribe_tiles - Adds a cache to repair after tile edits.
+ * @listener: Called by flush_tiles with the edited tiles.
+ *
+ * Return: 0 on success, 1 if MAX_TILE_LISTENERS are already subscribed.
+ */
+
+int subscribe_tiles(TileListener listener)
+{
+	if (numListeners == MAX_TILE_LISTENERS)
+		return (1);
+	listeners[numListeners++] = listener;
+
+	return (0);
+}
+
+/**
+ * flush_tiles - Repairs every cache after the edits since the last flush.
+ *
+ * Each listener is handed the whole dirty set at once, then the set is
+ * emptied. Does nothing when no tile changed.
+ */
+
+void flush_tiles(void)
+{
+	int i;
+
+	if (numDirty == 0)
+		return;
+	for (i = 0; i < numListeners; i++)
+		listeners[i](dirtyTiles, numDirty);
+	clear_tile_changes();
+}
+
+/**
+ * clear_tile_changes - Forgets the edits since the last flush.
+ *
+ * For when the caches are rebuilt from scratch anyway, as loadCurrentLevel
+ * does.
+ */
+
+void clear_tile_changes(void)
+{
+	int i;
+
+	for (i = 0; i < numDirty; i++)
+		dirty[dirtyTiles[i]] = false;
+	numDirty = 0;
+}
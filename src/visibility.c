@@ -0,0 +1,452 @@
+#include "../headers/mazemania.h"
+
+/*
+ * pvs - Potentially visible set. Row i holds one bit per map tile that may
+ * be seen from anywhere inside tile i, walls included. It errs only on
+ * the side of too many tiles, see tilesSeeEachOther.
+ */
+static Uint64 pvs[mapHeight * mapWidth][PVS_WORDS];
+/* Source tiles whose rows are being rebuilt, claimed through nextSource */
+static int sources[mapHeight * mapWidth];
+static int numSources;
+static SDL_atomic_t nextSource;
+/* Tiles edited since the rows in sources were built, see repairRow */
+static const int *editedTiles;
+static int numEdited;
+/**
+ * isOpaqueTile - Tells whether a tile blocks sight.
+ * @tile: Tile id from the world map.
+ *
+ * Return: true for border and inner walls.
+ */
+
+static bool isOpaqueTile(int tile)
+{
+	return (tile == 1 || tile == 2);
+}
+
+/**
+ * rowHas - Tests one tile's bit in a visibility row.
+ * @row: The row.
+ * @tile: Index of the tile.
+ *
+ * Return: true if the bit is set.
+ */
+
+static bool rowHas(const Uint64 *row, int tile)
+{
+	return ((row[tile / 64] >> (tile % 64)) & 1);
+}
+
+/**
+ * crossesInset - Tests whether a segment passes through the inside of a
+ * tile shrunk on every side.
+ * @x0: Start of the segment in tile units.
+ * @y0: Start of the segment in tile units.
+ * @dx: Segment extent along x.
+ * @dy: Segment extent along y.
+ * @tileX: Column of the tile.
+ * @tileY: Row of the tile.
+ * @inset: How much the tile is shrunk by; negative to grow it.
+ *
+ * Merely touching the shrunk square does not count.
+ *
+ * Return: true if the segment crosses it.
+ */
+
+static bool crossesInset(float x0, float y0, float dx, float dy, int tileX,
+		int tileY, float inset)
+{
+	float left = tileX + inset, right = tileX + 1 - inset;
+	float top = tileY + inset, bottom = tileY + 1 - inset;
+	float slack = PVS_EPSILON * (fabsf(dx) + fabsf(dy));
+	float c0, c1, c2, c3;
+
+	/* The bounding boxes must overlap... */
+	if (fmaxf(x0, x0 + dx) <= left + PVS_EPSILON ||
+			fminf(x0, x0 + dx) >= right - PVS_EPSILON ||
+			fmaxf(y0, y0 + dy) <= top + PVS_EPSILON ||
+			fminf(y0, y0 + dy) >= bottom - PVS_EPSILON)
+		return (false);
+
+	/* ...and the square's corners lie on both sides of the line */
+	c0 = dx * (top - y0) - dy * (left - x0);
+	c1 = dx * (top - y0) - dy * (right - x0);
+	c2 = dx * (bottom - y0) - dy * (left - x0);
+	c3 = dx * (bottom - y0) - dy * (right - x0);
+
+	return (fmaxf(fmaxf(c0, c1), fmaxf(c2, c3)) > slack &&
+			fminf(fminf(c0, c1), fminf(c2, c3)) < -slack);
+}
+
+/**
+ * segmentBlocker - Walks a segment through the grid with a DDA and tests
+ * the walls it meets.
+ * @x0: Start in tile units.
+ * @y0: Start in tile units.
+ * @x1: End in tile units.
+ * @y1: End in tile units.
+ * @target: Index of the tile looked at, which never blocks.
+ *
+ * Return: Index of the first wall other than @target the segment crosses,
+ * shrunk as crossesInset does, or -1 if it crosses none.
+ */
+
+static int segmentBlocker(float x0, float y0, float x1, float y1, int target)
+{
+	float dx = x1 - x0, dy = y1 - y0;
+	int mapX = (int)floorf(x0), mapY = (int)floorf(y0);
+	int stepX = dx < 0 ? -1 : 1, stepY = dy < 0 ? -1 : 1;
+	float deltaX = dx == 0 ? INFINITY : fabsf(1.0f / dx);
+	float deltaY = dy == 0 ? INFINITY : fabsf(1.0f / dy);
+	float sideX = dx == 0 ? INFINITY :
+		(dx < 0 ? x0 - mapX : mapX + 1 - x0) * deltaX;
+	float sideY = dy == 0 ? INFINITY :
+		(dy < 0 ? y0 - mapY : mapY + 1 - y0) * deltaY;
+
+	while (true)
+	{
+		if (mapX >= 0 && mapX < mapWidth && mapY >= 0 && mapY < mapHeight &&
+				mapY * mapWidth + mapX != target &&
+				isOpaqueTile(worldMap[mapY][mapX]) &&
+				crossesInset(x0, y0, dx, dy, mapX, mapY, PVS_MARGIN))
+			return (mapY * mapWidth + mapX);
+		if (sideX > 1 && sideY > 1)
+			return (-1);
+
+		if (sideX < sideY)
+		{
+			sideX += deltaX;
+			mapX += stepX;
+		}
+		else
+		{
+			sideY += deltaY;
+			mapY += stepY;
+		}
+	}
+}
+
+/**
+ * facingSamples - Lists points along the edges of a tile that face
+ * another tile.
+ * @tileX: Column of the tile.
+ * @tileY: Row of the tile.
+ * @otherX: Column of the other tile.
+ * @otherY: Row of the other tile.
+ * @points: Receives up to 2 * PVS_EDGE_SAMPLES points, x then y.
+ *
+ * Any segment between the two tiles leaves the first through one of
+ * these edges.
+ *
+ * Return: The number of points.
+ */
+
+static int facingSamples(int tileX, int tileY, int otherX, int otherY,
+		float points[][2])
+{
+	int count = 0, i;
+
+	for (i = 0; i < PVS_EDGE_SAMPLES; i++)
+	{
+		float along = (float)i / (PVS_EDGE_SAMPLES - 1);
+
+		if (otherX != tileX)
+		{
+			points[count][0] = tileX + (otherX > tileX);
+			points[count++][1] = tileY + along;
+		}
+		if (otherY != tileY)
+		{
+			points[count][0] = tileX + along;
+			points[count++][1] = tileY + (otherY > tileY);
+		}
+	}
+
+	return (count);
+}
+
+/**
+ * tilesSeeEachOther - Tests whether any point of one tile can see any
+ * point of another.
+ * @source: Index of the viewing tile, which must be open.
+ * @target: Index of the tile looked at, open or a wall.
+ *
+ * The test is conservative: it may find a pair visible that is not,
+ * but never the reverse. A sight line leaves the source and enters the
+ * target through the edges facing each other, and on each of those edges
+ * it passes within PVS_MARGIN of one of PVS_EDGE_SAMPLES evenly spaced
+ * points. So the segment between those two points stays within
+ * PVS_MARGIN of the sight line, and clears every wall shrunk by
+ * PVS_MARGIN; those segments are what is tested. Most segments of a
+ * hidden pair are stopped by the same few walls, so the walls found so
+ * far are tried before walking the grid.
+ *
+ * Return: true if the target may be visible from the source.
+ */
+
+static bool tilesSeeEachOther(int source, int target)
+{
+	int sx = source % mapWidth, sy = source / mapWidth;
+	int tx = target % mapWidth, ty = target / mapWidth;
+	float from[2 * PVS_EDGE_SAMPLES][2], to[2 * PVS_EDGE_SAMPLES][2];
+	float dx, dy;
+	int blockers[PVS_BLOCKERS], numBlockers = 0, numFrom, numTo, i, j, k;
+
+	/* Tiles sharing an edge or a corner touch */
+	if (abs(tx - sx) <= 1 && abs(ty - sy) <= 1)
+		return (true);
+
+	numFrom = facingSamples(sx, sy, tx, ty, from);
+	numTo = facingSamples(tx, ty, sx, sy, to);
+	for (i = 0; i < numFrom; i++)
+	{
+		for (j = 0; j < numTo; j++)
+		{
+			dx = to[j][0] - from[i][0];
+			dy = to[j][1] - from[i][1];
+			for (k = 0; k < numBlockers; k++)
+			{
+				if (crossesInset(from[i][0], from[i][1], dx, dy,
+							blockers[k] % mapWidth, blockers[k] / mapWidth,
+							PVS_MARGIN))
+					break;
+			}
+			if (k < numBlockers)
+				continue;
+
+			k = segmentBlocker(from[i][0], from[i][1], to[j][0], to[j][1],
+					target);
+			if (k < 0)
+				return (true);
+			if (numBlockers < PVS_BLOCKERS)
+				blockers[numBlockers++] = k;
+		}
+	}
+
+	return (false);
+}
+
+/**
+ * pairSpansEdit - Tells whether an edited tile lies between two tiles.
+ * @source: Index of the viewing tile.
+ * @target: Index of the tile looked at.
+ * @tiles: Indices of the edited tiles.
+ * @count: Number of entries of @tiles.
+ *
+ * Every segment tilesSeeEachOther tests for the pair lies within a unit
+ * square swept from the centre of one tile to the other's, so only a
+ * tile that square sweeps over can change its answer.
+ *
+ * Return: true if an edited tile lies in that swept area.
+ */
+
+static bool pairSpansEdit(int source, int target, const int *tiles,
+		int count)
+{
+	float x0 = source % mapWidth + 0.5f, y0 = source / mapWidth + 0.5f;
+	float dx = target % mapWidth + 0.5f - x0;
+	float dy = target / mapWidth + 0.5f - y0;
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (crossesInset(x0, y0, dx, dy, tiles[i] % mapWidth,
+					tiles[i] / mapWidth, -0.5f))
+			return (true);
+	}
+
+	return (false);
+}
+
+/**
+ * computeTileVisibility - Rebuilds the visibility row of one tile.
+ * @source: Index of the tile (y * mapWidth + x).
+ *
+ * Every other tile is tested with tilesSeeEachOther, so the set covers
+ * every position the player can stand on inside the tile.
+ */
+
+static void computeTileVisibility(int source)
+{
+	int x = source % mapWidth, y = source / mapWidth, target;
+	Uint64 *row = pvs[source];
+
+	memset(row, 0, sizeof(pvs[0]));
+	if (isOpaqueTile(worldMap[y][x]))
+		return;
+
+	for (target = 0; target < mapHeight * mapWidth; target++)
+	{
+		if (tilesSeeEachOther(source, target))
+			row[target / 64] |= (Uint64)1 << (target % 64);
+	}
+}
+
+/**
+ * repairRow - Tests again the pairs of a row that an edit can change.
+ * @source: Index of the tile, which was not edited.
+ *
+ * Only pairs with an edited tile between them, see pairSpansEdit, can
+ * change, so the row ends up as computeTileVisibility would build it.
+ */
+
+static void repairRow(int source)
+{
+	Uint64 bit;
+	int target;
+
+	if (isOpaqueTile(worldMap[source / mapWidth][source % mapWidth]))
+		return;
+
+	for (target = 0; target < mapHeight * mapWidth; target++)
+	{
+		if (!pairSpansEdit(source, target, editedTiles, numEdited))
+			continue;
+		bit = (Uint64)1 << (target % 64);
+		if (tilesSeeEachOther(source, target))
+			pvs[source][target / 64] |= bit;
+		else
+			pvs[source][target / 64] &= ~bit;
+	}
+}
+
+/**
+ * visibilityWorker - Thread body that claims source tiles until none remain.
+ * @data: Unused.
+ *
+ * Return: Always 0.
+ */
+
+static int visibilityWorker(void *data)
+{
+	int next;
+
+	(void)data;
+	while ((next = SDL_AtomicAdd(&nextSource, 1)) < numSources)
+	{
+		if (numEdited > 0)
+			repairRow(sources[next]);
+		else
+			computeTileVisibility(sources[next]);
+	}
+
+	return (0);
+}
+
+/**
+ * rebuildSources - Recomputes the rows of the tiles listed in sources, or
+ * repairs them after the edits in editedTiles.
+ *
+ * Each tile is an independent job, so the work is spread over one thread
+ * per CPU. If threads cannot be created the calling thread finishes the
+ * remaining tiles itself. Up to PVS_INLINE_SOURCES tiles are cheaper to
+ * do on the calling thread than to start threads for.
+ */
+
+static void rebuildSources(void)
+{
+	SDL_Thread *threads[PVS_MAX_THREADS];
+	int numThreads = SDL_GetCPUCount(), i;
+
+	if (numThreads > PVS_MAX_THREADS)
+		numThreads = PVS_MAX_THREADS;
+	if (numSources <= PVS_INLINE_SOURCES)
+		numThreads = 1;
+
+	SDL_AtomicSet(&nextSource, 0);
+	for (i = 0; i < numThreads - 1; i++)
+		threads[i] = SDL_CreateThread(visibilityWorker, "pvs", NULL);
+
+	visibilityWorker(NULL);
+
+	for (i = 0; i < numThreads - 1; i++)
+	{
+		if (threads[i])
+			SDL_WaitThread(threads[i], NULL);
+	}
+}
+
+/**
+ * build_visibility - Builds the potentially visible set for the current
+ * world map.
+ */
+
+void build_visibility(void)
+{
+	for (numSources = 0; numSources < mapHeight * mapWidth; numSources++)
+		sources[numSources] = numSources;
+	rebuildSources();
+}
+
+/**
+ * update_visibility_tiles - Repairs the visibility set after tile edits.
+ * @tiles: Indices (y * mapWidth + x) of the edited tiles.
+ * @count: Number of entries of @tiles.
+ *
+ * The edited tiles' own rows are rebuilt and every other row is repaired,
+ * see repairRow, so the set is the one a full build would give. A setTile
+ * subscriber.
+ */
+
+void update_visibility_tiles(const int *tiles, int count)
+{
+	Uint64 edited[PVS_WORDS] = {0};
+	int source, i;
+
+	for (i = 0; i < count; i++)
+	{
+		edited[tiles[i] / 64] |= (Uint64)1 << (tiles[i] % 64);
+		sources[i] = tiles[i];
+	}
+	numSources = count;
+	rebuildSources();
+
+	numSources = 0;
+	for (source = 0; source < mapHeight * mapWidth; source++)
+	{
+		if (!rowHas(edited, source))
+			sources[numSources++] = source;
+	}
+	editedTiles = tiles;
+	numEdited = count;
+	rebuildSources();
+	numEdited = 0;
+}
+
+/**
+ * tileVisible - Tests whether one tile can be seen from another.
+ * @fromX: Column of the viewing tile.
+ * @fromY: Row of the viewing tile.
+ * @toX: Column of the target tile.
+ * @toY: Row of the target tile.
+ *
+ * Return: true if the target tile is in the viewer's visible set.
+ */
+
+bool tileVisible(int fromX, int fromY, int toX, int toY)
+{
+	int target = toY * mapWidth + toX;
+
+	if (fromX < 0 || fromX >= mapWidth || fromY < 0 || fromY >= mapHeight ||
+			toX < 0 || toX >= mapWidth || toY < 0 || toY >= mapHeight)
+		return (false);
+
+	return ((pvs[fromY * mapWidth + fromX][target / 64] >>
+				(target % 64)) & 1);
+}
+
+/**
+ * enemyCanSeePlayer - Line-of-sight query from an enemy to the player.
+ * @enemy: Pointer to the enemy.
+ * @playerX: The x-coordinate of the player's position.
+ * @playerY: The y-coordinate of the player's position.
+ *
+ * Return: true if the player's tile is visible from the enemy's tile.
+ */
+
+bool enemyCanSeePlayer(const Enemy *enemy, float playerX, float playerY)
+{
+	return (tileVisible(enemy->rect.x / TILE_SIZE, enemy->rect.y / TILE_SIZE,
+				(int)playerX / TILE_SIZE, (int)playerY / TILE_SIZE));
+}
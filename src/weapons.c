@@ -0,0 +1,339 @@
+#include "../headers/mazemania.h"
+
+/**
+ * isWallTile - Tells whether a tile stops shots.
+ * @x: Column.
+ * @y: Row.
+ *
+ * Return: true for border and inner walls, and outside the map.
+ */
+
+static bool isWallTile(int x, int y)
+{
+	if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+		return (true);
+	return (worldMap[y][x] == 1 || worldMap[y][x] == 2);
+}
+
+/**
+ * segmentHitsRect - Finds where a segment first enters a rectangle.
+ * @x: Segment start x.
+ * @y: Segment start y.
+ * @dx: Segment x extent.
+ * @dy: Segment y extent.
+ * @rect: The rectangle.
+ * @t: Receives the entry point as a fraction of the segment.
+ *
+ * A slab test: the segment is clipped against the rectangle's x and y
+ * ranges in turn. A segment starting inside the rectangle enters it at 0.
+ *
+ * Return: true if the segment touches the rectangle.
+ */
+
+static bool segmentHitsRect(float x, float y, float dx, float dy,
+		const SDL_Rect *rect, float *t)
+{
+	float lo[2] = {rect->x, rect->y};
+	float hi[2] = {rect->x + rect->w, rect->y + rect->h};
+	float start[2] = {x, y}, delta[2] = {dx, dy};
+	float enter = 0, leave = 1, t0, t1, swap;
+	int axis;
+
+	for (axis = 0; axis < 2; axis++)
+	{
+		if (delta[axis] == 0)
+		{
+			if (start[axis] < lo[axis] || start[axis] > hi[axis])
+				return (false);
+			continue;
+		}
+		t0 = (lo[axis] - start[axis]) / delta[axis];
+		t1 = (hi[axis] - start[axis]) / delta[axis];
+		if (t0 > t1)
+		{
+			swap = t0;
+			t0 = t1;
+			t1 = swap;
+		}
+		if (t0 > enter)
+			enter = t0;
+		if (t1 < leave)
+			leave = t1;
+		if (enter > leave)
+			return (false);
+	}
+
+	*t = enter;
+	return (true);
+}
+
+/**
+ * firstEnemyHit - Finds the nearest live enemy a segment touches.
+ * @enemies: The level's enemies.
+ * @numEnemies: Number of entries of @enemies.
+ * @x: Segment start x.
+ * @y: Segment start y.
+ * @dx: Segment x extent.
+ * @dy: Segment y extent.
+ * @t: Receives the hit as a fraction of the segment; only hits before its
+ * value on entry count.
+ *
+ * Return: Index of the enemy, or -1 if none is hit before @t.
+ */
+
+static int firstEnemyHit(const Enemy *enemies, int numEnemies, float x,
+		float y, float dx, float dy, float *t)
+{
+	int i, hit = -1;
+	float enter;
+
+	for (i = 0; i < numEnemies; i++)
+	{
+		if (enemies[i].health > 0 && segmentHitsRect(x, y, dx, dy,
+					&enemies[i].rect, &enter) && enter < *t)
+		{
+			*t = enter;
+			hit = i;
+		}
+	}
+
+	return (hit);
+}
+
+/**
+ * sweepGrid - Walks a segment across the tile grid to its first wall.
+ * @x: Segment start x.
+ * @y: Segment start y.
+ * @dx: Segment x extent.
+ * @dy: Segment y extent.
+ *
+ * Only the tiles the segment crosses are visited, one grid line at a
+ * time, so a fast projectile cannot tunnel through a wall.
+ *
+ * Return: Where the segment enters a wall as a fraction of it, or a value
+ * above 1 if it stays in the open.
+ */
+
+static float sweepGrid(float x, float y, float dx, float dy)
+{
+	int tileX = (int)floorf(x / TILE_SIZE), tileY = (int)floorf(y / TILE_SIZE);
+	int stepX = dx > 0 ? 1 : -1, stepY = dy > 0 ? 1 : -1;
+	float deltaX = dx != 0 ? fabsf(TILE_SIZE / dx) : INFINITY;
+	float deltaY = dy != 0 ? fabsf(TILE_SIZE / dy) : INFINITY;
+	float nextX = dx == 0 ? INFINITY :
+		((tileX + (dx > 0)) * TILE_SIZE - x) / dx;
+	float nextY = dy == 0 ? INFINITY :
+		((tileY + (dy > 0)) * TILE_SIZE - y) / dy;
+	float t;
+
+	if (isWallTile(tileX, tileY))
+		return (0);
+
+	for (;;)
+	{
+		if (nextX < nextY)
+		{
+			t = nextX;
+			nextX += deltaX;
+			tileX += stepX;
+		}
+		else
+		{
+			t = nextY;
+			nextY += deltaY;
+			tileY += stepY;
+		}
+		if (t > 1)
+			return (t);
+		if (isWallTile(tileX, tileY))
+			return (t);
+	}
+}
+
+/**
+ * init_projectiles - Empties a projectile pool.
+ * @pool: The pool.
+ *
+ * Every slot is chained onto the free list, so spawning and releasing are
+ * constant time and never allocate.
+ */
+
+void init_projectiles(ProjectilePool *pool)
+{
+	int i;
+
+	for (i = 0; i < MAX_PROJECTILES; i++)
+		pool->slots[i].next = i + 1 < MAX_PROJECTILES ? i + 1 : -1;
+	pool->freeHead = 0;
+	pool->numLive = 0;
+}
+
+/**
+ * spawn_projectile - Launches a projectile.
+ * @pool: The pool.
+ * @x: Start x in world pixels.
+ * @y: Start y in world pixels.
+ * @degrees: Direction of flight.
+ *
+ * Return: The projectile's slot, or -1 if the pool is full and the shot
+ * is dropped.
+ */
+
+int spawn_projectile(ProjectilePool *pool, float x, float y, double degrees)
+{
+	int slot = pool->freeHead;
+	Projectile *projectile;
+
+	if (slot < 0)
+		return (-1);
+
+	projectile = &pool->slots[slot];
+	pool->freeHead = projectile->next;
+	projectile->x = x;
+	projectile->y = y;
+	projectile->dx = cos(DEG_TO_RAD(degrees)) * PROJECTILE_SPEED;
+	projectile->dy = sin(DEG_TO_RAD(degrees)) * PROJECTILE_SPEED;
+	projectile->ttl = PROJECTILE_LIFETIME;
+	pool->live[pool->numLive++] = slot;
+
+	return (slot);
+}
+
+/**
+ * releaseProjectile - Returns a live projectile's slot to the free list.
+ * @pool: The pool.
+ * @index: Position of the projectile in the live list.
+ *
+ * The last live entry takes its place, keeping the live list packed.
+ */
+
+static void releaseProjectile(ProjectilePool *pool, int index)
+{
+	int slot = pool->live[index];
+
+	pool->live[index] = pool->live[--pool->numLive];
+	pool->slots[slot].next = pool->freeHead;
+	pool->freeHead = slot;
+}
+
+/**
+ * step_projectiles - Moves every projectile in flight by one tick.
+ * @pool: The pool.
+ * @enemies: The level's enemies; those hit lose PROJECTILE_DAMAGE health
+ * and are alerted.
+ * @numEnemies: Number of entries of @enemies.
+ * @deltaTime: Length of the tick in seconds.
+ *
+ * Each projectile's move is swept against the tile grid and the enemies'
+ * rectangles, so nothing is skipped however far it moves in a tick. One
+ * that hits something or runs out of time is released. The live list is
+ * walked backwards so the entry swapped into a released one's place has
+ * already moved.
+ */
+
+void step_projectiles(ProjectilePool *pool, Enemy *enemies, int numEnemies,
+		float deltaTime)
+{
+	Projectile *projectile;
+	float dx, dy, t;
+	int i, hit;
+
+	for (i = pool->numLive - 1; i >= 0; i--)
+	{
+		projectile = &pool->slots[pool->live[i]];
+		dx = projectile->dx * deltaTime;
+		dy = projectile->dy * deltaTime;
+
+		t = sweepGrid(projectile->x, projectile->y, dx, dy);
+		hit = firstEnemyHit(enemies, numEnemies, projectile->x, projectile->y,
+				dx, dy, &t);
+		if (hit >= 0)
+		{
+			enemies[hit].health -= PROJECTILE_DAMAGE;
+			alert_enemy(&enemies[hit]);
+		}
+		if (t <= 1 || --projectile->ttl <= 0)
+		{
+			releaseProjectile(pool, i);
+			continue;
+		}
+		projectile->x += dx;
+		projectile->y += dy;
+	}
+}
+
+/**
+ * fire_hitscan - Fires an instant shot along the player's view.
+ * @state: The game state; the shot leaves from the player.
+ * @enemies: The level's enemies; the one hit loses HITSCAN_DAMAGE health
+ * and is alerted.
+ * @numEnemies: Number of entries of @enemies.
+ *
+ * The shot is cast with the renderer's own ray caster, so it stops at
+ * exactly the wall the player sees, and only enemies between the player
+ * and that wall can be hit.
+ *
+ * Return: Index of the enemy hit, or -1.
+ */
+
+int fire_hitscan(const GameState *state, Enemy *enemies, int numEnemies)
+{
+	/* Only column 0 is used; the simulation thread is its only user */
+	static RayHits shot;
+	double degrees = fmod(state->degrees, 360);
+	float reach, dx, dy, t = 1;
+	int hit;
+
+	if (degrees < 0)
+		degrees += 360;
+	castSingleRay(state->player.x, state->player.y, degrees, degrees, &shot,
+			0, NULL);
+	reach = shot.tile[0] != 0 ? shot.distance[0] :
+		hypot(mapWidth, mapHeight) * TILE_SIZE;
+	dx = cos(DEG_TO_RAD(degrees)) * reach;
+	dy = sin(DEG_TO_RAD(degrees)) * reach;
+
+	hit = firstEnemyHit(enemies, numEnemies, state->player.x, state->player.y,
+			dx, dy, &t);
+	if (hit >= 0)
+	{
+		enemies[hit].health -= HITSCAN_DAMAGE;
+		alert_enemy(&enemies[hit]);
+	}
+
+	return (hit);
+}
+
+/**
+ * fire_weapons - Fires the weapons the tick's input holds down.
+ * @state: The game state; its cooldown and last shot tick are updated.
+ * @pool: Projectiles in flight.
+ * @enemies: The level's enemies.
+ * @numEnemies: Number of entries of @enemies.
+ * @input: Input bits for this tick, see handleEvent.
+ *
+ * INPUT_FIRE shoots the hitscan gun and INPUT_LAUNCH a projectile, each
+ * shot starting the weapons' shared cooldown.
+ */
+
+void fire_weapons(GameState *state, ProjectilePool *pool, Enemy *enemies,
+		int numEnemies, Uint16 input)
+{
+	if (state->tick < state->nextShot)
+		return;
+
+	if (input & INPUT_FIRE)
+	{
+		fire_hitscan(state, enemies, numEnemies);
+		state->nextShot = state->tick + HITSCAN_COOLDOWN;
+	}
+	else if (input & INPUT_LAUNCH)
+	{
+		spawn_projectile(pool, state->player.x, state->player.y,
+				state->degrees);
+		state->nextShot = state->tick + LAUNCH_COOLDOWN;
+	}
+	else
+		return;
+	state->lastShot = state->tick + 1;
+}